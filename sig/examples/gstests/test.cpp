@@ -14,12 +14,16 @@
 
 void test_random ();
 void test_mat ();
+void test_matperf ();
 void test_matn ();
 void test_euler ();
 void test_vars ();
 void test_heap ();
 void test_table ();
 void test_slotmap ();
+void test_smallarray ();
+void test_shareable ();
+void test_simplify ();
 void test_string ();
 void test_structures ();
 void test_timer ();
@@ -35,6 +39,7 @@ struct FuncDesc { void (*func) (); const char* name; } FD[] =
 	{ test_string,	"string" },
 	{ test_vars,	"vars" },
 	{ test_mat,		"mat" },
+	{ test_matperf, "matperf" },
 	{ test_matn,	"matn" },
 	{ test_euler,	"euler" },
 	{ test_grid,	"grid" },
@@ -46,6 +51,9 @@ struct FuncDesc { void (*func) (); const char* name; } FD[] =
 	{ test_slotmap, "slotmap" },
 	{ test_structures, "structures" },
 	{ test_arraylist, "arraylist" },
+	{ test_smallarray, "smallarray" },
+	{ test_shareable, "shareable" },
+	{ test_simplify, "simplify" },
 	{ 0, 0 } };
 
 int main ( int argc, char** argv )
@@ -9,6 +9,8 @@
 # include <sig/gs_color.h>
 # include <sig/gs_graph.h>
 # include <sig/gs_string.h>
+# include <sig/gs_time.h>
+# include <sig/gs_random.h>
 
 class MyNode;
 
@@ -77,7 +79,36 @@ static void run ()
    for ( it.last(); it.inrange(); it.prior() ) gsout<<it->s<<gsnl;
  }
 
+// shortest paths in a grid with random costs, as in navigation graphs:
+static void shortest_paths ()
+ {
+   const int w=300, h=300;
+   MyGraph g;
+   GsArray<MyNode*> nodes ( w*h );
+   GsRandom<float> r ( 1.0f, 2.0f );
+   for ( int i=0; i<nodes.size(); i++ ) nodes[i] = g.insert ( new MyNode );
+   for ( int y=0; y<h; y++ )
+	for ( int x=0; x<w; x++ )
+	 { MyNode* n = nodes[y*w+x];
+	   if ( x+1<w ) g.link ( n, nodes[y*w+x+1], r.get() );
+	   if ( y+1<h ) g.link ( n, nodes[(y+1)*w+x], r.get() );
+	   if ( x+1<w && y+1<h ) g.link ( n, nodes[(y+1)*w+x+1], r.get()*1.41f );
+	 }
+
+   GsArray<MyNode*> path;
+   float cost, total=0;
+   GsRandom<int> ri ( 0, nodes.size()-1 );
+   double t = gs_time();
+   for ( int k=0; k<20; k++ )
+	{ if ( !g.shortest_path ( nodes[ri.get()], nodes[ri.get()], path, cost ) ) gsout<<"ERROR: path not found!\n";
+	  total += cost;
+	}
+   t = gs_time()-t;
+   gsout << "\n20 shortest paths in a "<<w<<"x"<<h<<" grid: "<<t*1000.0<<"ms, total cost "<<total<<gsnl;
+ }
+
 void test_graph ()
  {
    run ();
+   shortest_paths ();
  }
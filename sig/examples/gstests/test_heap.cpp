@@ -53,5 +53,17 @@ void test_heap ()
    print(h);
    gsout<<"Elements in order:"<<gsnl;
    gsout<<h<<gsnl;
+ 
+   gsout<<"Indexed heap with decrease_key:"<<gsnl;
+   GsIndexedHeap<int> ih;
+   GsArray<int> costs(50);
+   for ( i=0; i<costs.size(); i++ ) { costs[i]=r.get()+100; ih.insert(i,costs[i]); }
+   for ( i=0; i<costs.size(); i+=3 ) { costs[i]-=100; ih.decrease_key(i,costs[i]); }
+   ih.remove ( 7 );
+   int prior=-1, n=0; bool ok=!ih.contains(7);
+   while ( !ih.empty() )
+	{ if ( ih.lowest_cost()<prior || ih.lowest_cost()!=costs[ih.top()] ) ok=false;
+	  prior=ih.lowest_cost(); ih.remove(); n++;
+	}
+   gsout << (ok&&n==costs.size()-1? "ok":"ERROR!") << gsnl;
  }
-
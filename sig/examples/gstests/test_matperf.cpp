@@ -0,0 +1,134 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_mat.h>
+# include <sig/gs_quat.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+
+// reference product computed element by element:
+static GsMat refmult ( const GsMat& a, const GsMat& b )
+ {
+   GsMat m(GsMat::NoInit);
+   for ( int i=0; i<4; i++ )
+	for ( int j=0; j<4; j++ )
+	 { float s=0;
+	   for ( int k=0; k<4; k++ ) s += a.cget(i,k)*b.cget(k,j);
+	   m.e[i*4+j] = s;
+	 }
+   return m;
+ }
+
+static GsQuat refmult ( const GsQuat& q1, const GsQuat& q2 )
+ {
+   GsVec v1(q1.x,q1.y,q1.z), v2(q2.x,q2.y,q2.z);
+   GsVec v = q1.w*v2 + q2.w*v1 + cross(v1,v2);
+   return GsQuat ( q1.w*q2.w-dot(v1,v2), v.x, v.y, v.z );
+ }
+
+static bool qnext ( const GsQuat& q1, const GsQuat& q2 )
+ {
+   for ( int i=0; i<4; i++ ) if ( gs_dist(q1.e[i],q2.e[i])>gsmall ) return false;
+   return true;
+ }
+
+static void rmat ( GsMat& m, bool affine )
+ {
+   for ( int i=0; i<16; i++ ) m[i] = gs_random(-1.0f,1.0f);
+   if ( affine ) m.setl4 ( 0, 0, 0, 1 );
+ }
+
+static void test_results ()
+ {
+   int i, times=100000;
+   GsMat a, b, r, m;
+   GsQuat q1, q2, q;
+
+   gsout << "Testing aliased mult... ";
+   for ( i=0; i<times; i++ )
+	{ rmat(a,false); rmat(b,false);
+	  r = refmult(a,a);
+	  m=a; m.mult(m,m);
+	  if ( !next(m,r,gsmall) ) { gsout<<"mult(this,this) ERROR!\n"; break; }
+	  r = refmult(a,b);
+	  m=a; m.mult(m,b);
+	  if ( !next(m,r,gsmall) ) { gsout<<"mult(this,m) ERROR!\n"; break; }
+	  m=b; m.mult(a,m);
+	  if ( !next(m,r,gsmall) ) { gsout<<"mult(m,this) ERROR!\n"; break; }
+	  m=a; m*=b;
+	  if ( !next(m,r,gsmall) ) { gsout<<"operator*= ERROR!\n"; break; }
+	}
+   gsout << "Ok.\n";
+
+   gsout << "Testing aliased multaff... ";
+   for ( i=0; i<times; i++ )
+	{ rmat(a,true); rmat(b,true);
+	  r = refmult(a,b);
+	  m=a; m.multaff(m,b);
+	  if ( !next(m,r,gsmall) ) { gsout<<"multaff(this,m) ERROR!\n"; break; }
+	  m=b; m.multaff(a,m);
+	  if ( !next(m,r,gsmall) ) { gsout<<"multaff(m,this) ERROR!\n"; break; }
+	}
+   gsout << "Ok.\n";
+
+   gsout << "Testing aliased inverse... ";
+   for ( i=0; i<times; i++ )
+	{ rmat(a,false);
+	  a.inverse(r);
+	  m=a; m.invert();
+	  if ( m!=r ) { gsout<<"invert ERROR!\n"; break; }
+	}
+   gsout << "Ok.\n";
+
+   gsout << "Testing mat2quat and quaternion product... ";
+   for ( i=0; i<times; i++ )
+	{ q1.setrandom(); q2.setrandom();
+	  q = q1*q2;
+	  if ( !qnext(q,refmult(q1,q2)) ) { gsout<<"quaternion product ERROR!\n"; break; }
+	  q1.get(m);
+	  mat2quat ( m, q );
+	  if ( !qnext(q,q1) && !qnext(q,q1*-1.0f) ) { gsout<<"mat2quat ERROR!\n"; break; }
+	}
+   gsout << "Ok.\n";
+ }
+
+# define TIMES 2000000
+
+static void test_times ()
+ {
+   int i;
+   GsTimer t;
+   GsMat a, b, m;
+   GsQuat q1, q2, q;
+   float sum=0; // used to avoid the loops to be optimized out
+
+   rmat(a,true); rmat(b,true);
+   q1.setrandom(); q2.setrandom();
+
+   # define BENCH(name,op) \
+	 t.start(); for ( i=0; i<TIMES; i++ ) { op; } t.stop(); \
+	 gsout << name << ": " << float(t.dt()*1.0E9/TIMES) << " ns\n";
+
+   gsout << TIMES << " calls for each method, average time per call:\n";
+   BENCH ( "mult        ", m.mult(a,b); sum+=m[3] );
+   BENCH ( "mult aliased", m=a; m.mult(m,b); sum+=m[3] );
+   BENCH ( "multaff     ", m=a; m.multaff(m,b); sum+=m[3] );
+   BENCH ( "operator *= ", m=a; m*=b; sum+=m[3] );
+   BENCH ( "inverse     ", a.inverse(m); sum+=m[3] );
+   BENCH ( "invert      ", m=a; m.invert(); sum+=m[3] );
+   BENCH ( "mat2quat    ", mat2quat(a,q); sum+=q.x );
+   BENCH ( "quat product", q=q1*q2; sum+=q.x );
+   # undef BENCH
+
+   gsout << "(" << sum << ")\n";
+ }
+
+void test_matperf ()
+ {
+   test_results();
+   test_times();
+ }
@@ -0,0 +1,97 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <atomic>
+
+# include <sig/gs_array.h>
+# include <sig/gs_shareable.h>
+# include <sig/gs_thread_pool.h>
+# include <sig/gs_time.h>
+
+class Node : public GsShareable
+{  public :
+	Node* next;
+	float data[6];
+	Node () { next=0; }
+};
+
+// Counters with the same layout as in GsShareable, updated as with and without GS_ATOMIC_REF:
+struct PlainCounter { unsigned ref; char pad[44]; };
+struct AtomicCounter { std::atomic<unsigned> ref; char pad[44]; };
+
+static double plain_pass ( GsArray<PlainCounter>& a, int passes )
+{
+	double t = gs_time();
+	for ( int p=0; p<passes; p++ )
+	{	for ( int i=0; i<a.size(); i++ ) ++(*(volatile unsigned*)&a[i].ref);
+		for ( int i=0; i<a.size(); i++ ) --(*(volatile unsigned*)&a[i].ref);
+	}
+	return gs_time()-t;
+}
+
+static double atomic_pass ( GsArray<AtomicCounter>& a, int passes )
+{
+	double t = gs_time();
+	for ( int p=0; p<passes; p++ )
+	{	for ( int i=0; i<a.size(); i++ ) a[i].ref.fetch_add ( 1, std::memory_order_relaxed );
+		for ( int i=0; i<a.size(); i++ ) a[i].ref.fetch_sub ( 1, std::memory_order_acq_rel );
+	}
+	return gs_time()-t;
+}
+
+// references and unreferences a node list as done when traversing and sharing scene nodes:
+static double node_pass ( Node* first, int passes )
+{
+	double t = gs_time();
+	for ( int p=0; p<passes; p++ )
+	{	for ( Node* n=first; n; n=n->next ) n->ref();
+		for ( Node* n=first; n; n=n->next ) n->unref();
+	}
+	return gs_time()-t;
+}
+
+static void share_loop ( int /*i*/, int /*slot*/, void* udata )
+{
+	Node* n = (Node*)udata;
+	for ( int k=0; k<100000; k++ ) { n->ref(); n->unref(); }
+}
+
+void test_shareable ()
+{
+	const int size=100000, passes=50;
+	double ops = double(size)*passes;
+
+	gsout << "GsShareable compiled with " << (GsShareable::atomicref()? "atomic":"plain") << " reference counts\n\n";
+
+	gsout << "Single-threaded traversal, " << size << " objects, " << passes << " passes:\n";
+	{	GsArray<PlainCounter> pa ( size );
+		GsArray<AtomicCounter> aa ( size );
+		for ( int i=0; i<size; i++ ) { pa[i].ref=1; aa[i].ref=1; }
+		double tp = plain_pass ( pa, passes );
+		double ta = atomic_pass ( aa, passes );
+		gsout.putf ( "plain counters:  %6.2f ns per ref/unref pair\n", tp*1.0E9/ops );
+		gsout.putf ( "atomic counters: %6.2f ns per ref/unref pair (%.2fx)\n", ta*1.0E9/ops, ta/tp );
+	}
+
+	{	GsArray<Node*> nodes ( size );
+		for ( int i=0; i<size; i++ ) { nodes[i]=new Node; nodes[i]->ref(); if ( i ) nodes[i-1]->next=nodes[i]; }
+		double tn = node_pass ( nodes[0], passes );
+		gsout.putf ( "GsShareable:     %6.2f ns per ref/unref pair\n", tn*1.0E9/ops );
+		for ( int i=0; i<size; i++ ) nodes[i]->unref();
+	}
+
+	gsout << "\nObject shared by 4 threads: ";
+	if ( GsShareable::atomicref() )
+	{	GsThreadPool pool ( 3 );
+		Node* n = new Node;
+		n->ref();
+		pool.run ( 16, share_loop, n, 1 );
+		gsout << ( n->getref()==1? "ok":"ERROR!" ) << gsnl;
+		n->unref();
+	}
+	else gsout << "skipped, requires GS_ATOMIC_REF\n";
+}
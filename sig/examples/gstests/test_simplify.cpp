@@ -0,0 +1,79 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_time.h>
+
+// Checks that all indices are valid and that there are no degenerated or duplicated faces:
+static bool check_model ( const GsModel& m )
+{
+	for ( int i=0; i<m.F.size(); i++ )
+	{	const GsModel::Face& f = m.F[i];
+		if ( f.a<0 || f.b<0 || f.c<0 || f.a>=m.V.size() || f.b>=m.V.size() || f.c>=m.V.size() ) return false;
+		if ( f.a==f.b || f.b==f.c || f.c==f.a ) return false;
+		for ( int j=0; j<i; j++ )
+		{	const GsModel::Face& g = m.F[j];
+			int same = 0;
+			if ( g.a==f.a || g.a==f.b || g.a==f.c ) same++;
+			if ( g.b==f.a || g.b==f.b || g.b==f.c ) same++;
+			if ( g.c==f.a || g.c==f.b || g.c==f.c ) same++;
+			if ( same==3 ) return false;
+		}
+	}
+	if ( m.Fn.size()>0 )
+	{	if ( m.Fn.size()!=m.F.size() ) return false;
+		for ( int i=0; i<m.Fn.size(); i++ )
+		{	const GsModel::Face& f = m.Fn[i];
+			if ( f.a<0 || f.b<0 || f.c<0 || f.a>=m.N.size() || f.b>=m.N.size() || f.c>=m.N.size() ) return false;
+		}
+	}
+	return true;
+}
+
+static void make_tetrahedron ( GsModel& m )
+{
+	m.init ();
+	m.V.push().set ( 0, 0, 0 );
+	m.V.push().set ( 1, 0, 0 );
+	m.V.push().set ( 0, 1, 0 );
+	m.V.push().set ( 0, 0, 1 );
+	m.F.push().set ( 0, 2, 1 );
+	m.F.push().set ( 0, 1, 3 );
+	m.F.push().set ( 0, 3, 2 );
+	m.F.push().set ( 1, 2, 3 );
+}
+
+static void report ( const char* name, const GsModel& m, int target, int faces )
+{
+	gsout << name << ": " << faces << " faces for target " << target << ", "
+		  << m.V.size() << " vertices, " << ( faces==m.F.size() && check_model(m)? "ok":"ERROR!" ) << gsnl;
+}
+
+void test_simplify ()
+{
+	GsModel m;
+
+	make_tetrahedron ( m );
+	int n = m.simplify ( 1 );
+	report ( "tetrahedron", m, 1, n );
+	if ( n!=4 ) gsout << "ERROR: a closed mesh must keep 4 faces\n";
+
+	int targets[] = { 1000, 200, 50, 10, 1 };
+	for ( int smooth=0; smooth<=1; smooth++ )
+	{	for ( int i=0; i<5; i++ )
+		{	m.init ();
+			m.make_sphere ( GsPnt::null, 1.0f, 40, smooth==1 );
+			int orig = m.F.size();
+			double t = gs_time();
+			n = m.simplify ( targets[i] );
+			t = gs_time()-t;
+			report ( smooth? "smooth sphere":"flat sphere", m, targets[i], n );
+			gsout.putf ( "   from %d faces in %.2f ms\n", orig, t*1000.0 );
+			if ( n<4 ) gsout << "ERROR: a closed mesh must keep 4 faces\n";
+		}
+	}
+}
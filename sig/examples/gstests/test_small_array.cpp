@@ -0,0 +1,136 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <stdlib.h>
+
+# include <sig/gs_array.h>
+# include <sig/gs_allocator.h>
+# include <sig/gs_random.h>
+# include <sig/gs_time.h>
+
+// Allocator counting the blocks requested, used to compare arrays with and without inline storage:
+class CountAllocator : public GsAllocator
+{  public :
+	int allocs, reallocs, frees;
+	CountAllocator () { allocs=reallocs=frees=0; }
+	virtual void* alloc ( size_t n ) override { allocs++; return ::malloc(n); }
+	virtual void* realloc ( void* p, size_t /*n*/, size_t nn ) override { reallocs++; return ::realloc(p,nn); }
+	virtual void free ( void* p, size_t /*n*/ ) override { frees++; ::free(p); }
+};
+
+static void check_basic ()
+{
+	GsSmallArray<int,4> a;
+	int i, ok=1;
+	for ( i=0; i<4; i++ ) a.push()=i;
+	if ( !a.inlined() || a.capacity()!=4 ) ok=0;
+	for ( i=4; i<100; i++ ) a.push(i);
+	if ( a.inlined() ) ok=0;
+	a.insert(0)=-1;
+	int b[3] = { 100, 101, 102 };
+	a.push ( b, 3 );
+	for ( i=0; i<a.size(); i++ ) if ( a[i]!=i-1 ) ok=0;
+	GsSmallArray<int,4> c=a;
+	a.remove ( 3, a.size()-3 );
+	a.compress();
+	if ( !a.inlined() || a[2]!=1 || c.size()!=104 || c.top()!=102 ) ok=0;
+	gsout << "Basic operations: " << (ok? "ok":"ERROR!") << gsnl;
+}
+
+//============================== skeleton construction ==============================
+
+// parents of a 67-joint humanoid hierarchy with 3 joints per finger, as in typical bvh files:
+static const int Parents[] = { -1, 0,1,2,3, 0,5,6,7, 0,9,10,11,12,13,
+	12,15,16,17, 18,19,20,21, 18,23,24,25, 18,27,28,29, 18,31,32,33, 18,35,36,37,
+	12,39,40,41, 42,43,44,45, 42,47,48,49, 42,51,52,53, 42,55,56,57, 42,59,60,61, 13,63,64,65 };
+
+template <int N>
+struct BJoint
+{	GsSmallArray<BJoint*,N> children;
+	BJoint* parent;
+	BJoint ( GsAllocator* a ) : children(a) { parent=0; }
+};
+
+template <int N>
+static void build_skeletons ( int nsk, CountAllocator& ca, double& t )
+{
+	int nj = sizeof(Parents)/sizeof(int);
+	GsArray<BJoint<N>*> joints ( nj );
+	t = gs_time();
+	for ( int s=0; s<nsk; s++ )
+	{	for ( int j=0; j<nj; j++ )
+		{	joints[j] = new BJoint<N> ( &ca );
+			if ( Parents[j]>=0 ) { joints[j]->parent=joints[Parents[j]]; joints[Parents[j]]->children.push()=joints[j]; }
+		}
+		for ( int j=0; j<nj; j++ ) joints[j]->children.compress(); // as done by KnSkeleton::compress()
+		for ( int j=0; j<nj; j++ ) delete joints[j];
+	}
+	t = gs_time()-t;
+}
+
+//============================== model loading ==============================
+
+// face lines of an obj file: each face has 3 or 4 vertices with position, texture and normal indices
+static void make_faces ( GsArray<int>& faces, int n )
+{
+	GsRandom<int> r ( 1, 5000 );
+	for ( int f=0; f<n; f++ )
+	{	int nv = f%3==0? 4:3;
+		faces.push() = nv;
+		for ( int v=0; v<nv*3; v++ ) faces.push()=r.get();
+	}
+}
+
+// triangulates faces reading each face into temporary index buffers, as in an obj loader
+template <int N>
+static void load_faces ( const GsArray<int>& faces, GsArray<int>& tris, CountAllocator& ca, double& t )
+{
+	t = gs_time();
+	tris.size ( 0 );
+	for ( int i=0; i<faces.size(); )
+	{	GsSmallArray<int,N> va(&ca), ta(&ca), na(&ca);
+		int nv = faces[i++];
+		for ( int v=0; v<nv; v++ ) { va.push()=faces[i++]; ta.push()=faces[i++]; na.push()=faces[i++]; }
+		for ( int v=2; v<nv; v++ )
+		{	int* tri = tris.push_n ( 9 );
+			tri[0]=va[0]; tri[1]=va[v-1]; tri[2]=va[v];
+			tri[3]=ta[0]; tri[4]=ta[v-1]; tri[5]=ta[v];
+			tri[6]=na[0]; tri[7]=na[v-1]; tri[8]=na[v];
+		}
+	}
+	t = gs_time()-t;
+}
+
+static void print ( const char* name, const CountAllocator& ca, double t )
+{
+	gsout.putf ( "%-24s allocs:%8d  reallocs:%8d  frees:%8d  time:%7.2fms\n", name, ca.allocs, ca.reallocs, ca.frees, t*1000.0 );
+}
+
+void test_smallarray ()
+{
+	check_basic ();
+
+	gsout << "\nSkeleton construction, 10000 skeletons of " << int(sizeof(Parents)/sizeof(int)) << " joints:\n";
+	{	CountAllocator c0, c3; double t0, t3;
+		build_skeletons<0> ( 10000, c0, t0 );
+		build_skeletons<3> ( 10000, c3, t3 );
+		print ( "children without inline", c0, t0 );
+		print ( "children with 3 inline", c3, t3 );
+	}
+
+	gsout << "\nModel loading, 200000 faces:\n";
+	{	GsArray<int> faces, tris;
+		make_faces ( faces, 200000 );
+		CountAllocator c0, c8; double t0, t8;
+		load_faces<0> ( faces, tris, c0, t0 );
+		int n0 = tris.size();
+		load_faces<8> ( faces, tris, c8, t8 );
+		print ( "face buffers no inline", c0, t0 );
+		print ( "face buffers 8 inline", c8, t8 );
+		if ( n0!=tris.size() ) gsout << "ERROR: different results!\n";
+	}
+}
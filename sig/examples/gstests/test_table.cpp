@@ -6,6 +6,9 @@
   =======================================================================*/
 
 # include <sig/gs_table.h>
+# include <sig/gs_hash_table.h>
+# include <sig/gs_time.h>
+# include <sig/gs_string.h>
 
 void print ( GsTableBase& T )
 {
@@ -34,6 +37,70 @@ void print ( GsTableBase& T )
 		  << " Collisions:"<<T.collisions()<<"\n\n";
 }
 
+void print ( GsHashTableBase& T )
+{
+	gsout <<"\nEntries:\n";
+	for ( int i=0; i<T.size(); i++ )
+	{	gsout << i << ":[" << (T.key(i)? T.key(i):"") << "]";
+		int j = T.collidingid(i);
+		if ( j>=0 ) gsout << " collides with " << j;
+		gsout << gsnl;
+	}
+
+	gsout << "HashSize:"<<T.hashsize()
+		  << " Elements:"<<T.elements()
+		  << " LongestEntry:"<< T.longest_entry()
+		  << " Collisions:"<<T.collisions()<<"\n\n";
+}
+
+// compares lookups of joint names as done when loading skeletons, motions and skin weights
+template <class T>
+static double lookups ( T& table, const GsArray<GsString>& names, int times )
+{
+	int found=0;
+	double t = gs_time();
+	for ( int k=0; k<times; k++ )
+		for ( int i=0; i<names.size(); i++ ) if ( table.lookup(names[i]) ) found++;
+	t = gs_time()-t;
+	if ( found!=names.size()*times ) gsout << "ERROR: not found!\n";
+	return t;
+}
+
+static void test_hash_table ()
+{
+	GsHashTable<long> TB;
+	const char* keys[] = { "", "atest", "btest", "ctest", "abc", "go now", "lshoulder", "lelbow", "LWrist",
+		"lwrist", "rwrist", "rshoulder", "relbow", "l_shoulder", "l_elbow", "l_wrist", "r_wrist", "r_shoulder", "r_elbow", 0 };
+	for ( int i=0; keys[i]; i++ ) TB.insert ( keys[i], 0 );
+	print ( TB );
+
+	gsout<<"index of [relbow]: "<<TB.lookup_index("relbow")<<gsnl;
+	gsout<<"index of [relbowX]: "<<TB.lookup_index("relbowX")<<gsnl;
+
+	TB.remove("ctest");
+	TB.remove("abc");
+	TB.remove("rshoulder");
+	TB.remove("l_shoulder");
+	gsout<<"\nremoved [ctest,abc,rshoulder,l_shoulder], then inserted [abc,new]: "<<gsnl;
+	TB.insert ( "abc", 0 );
+	TB.insert ( "new", 0 );
+	print ( TB );
+
+	GsHashTable<long> TI ( 0, GsHashTableBase::InternedKeys );
+	TI.insert ( "lwrist", 0 );
+	gsout << "interned keys shared: " << (TI.key(0)==GsHashTableBase::intern("lwrist")? "yes":"ERROR!") << gsnl;
+
+	GsArray<GsString> names ( 300 );
+	for ( int i=0; i<names.size(); i++ ) names[i].setf ( "Character1_LeftHandIndex%d", i );
+	GsTable<long> chained ( 256 );
+	GsHashTable<long> open;
+	for ( int i=0; i<names.size(); i++ ) { chained.insert(names[i],i+1); open.insert(names[i],i+1); }
+	double tc = lookups ( chained, names, 1000 );
+	double to = lookups ( open, names, 1000 );
+	gsout << "\n300000 lookups: GsTable " << tc*1000.0 << "ms (longest " << chained.longest_entry()
+		  << "), GsHashTable " << to*1000.0 << "ms (longest " << open.longest_entry() << ")\n";
+}
+
 struct MyData 
 {   int x;
 	MyData(int i=0):x(i) {}
@@ -98,5 +165,7 @@ void test_table ()
 	gsout << T.lookup("d1")->x << gsnl;
 	gsout << T.lookup("d2")->x << gsnl;
 	gsout << T.lookup("d3")->x << gsnl;
-}
 
+	gsout<<"\nOpen addressing version:\n";
+	test_hash_table ();
+}
@@ -0,0 +1,310 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <stdlib.h>
+# include <string.h>
+# include <sig/gs_output.h>
+# include <sig/gs_random.h>
+# include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_skin.h>
+# include <sigkin/kn_motion.h>
+# include <sigkin/kn_posture.h>
+# include <sigkin/kn_ct_motion.h>
+# include <sigkin/kn_ct_scheduler.h>
+# include <sigkin/kn_coldet.h>
+# include <sigkin/kn_scene.h>
+# include <sigkin/kn_runner.h>
+# include <sigkin/kn_motion_index.h>
+# include <sigkin/kn_motion_graph.h>
+# include <sigkin/kn_rig_builder.h>
+
+// Headless simulation of a skeleton: no windows are created and no events are
+// processed, so it can run on build servers. The trace written with -t can be
+// compared with a reference trace with -c for regression tests. Options -index
+// and -graph verify KnMotionIndex and KnMotionGraph on the simulated motion, and
+// option -rig verifies KnRigBuilder, in which case no skeleton is needed.
+
+static void usage ()
+{
+	gsout << "Usage: simrun <skeleton> [options], or simrun -rig\n"
+			 "  -m <file>  motion to play, otherwise the postures of the skeleton are played\n"
+			 "  -n <int>   number of frames to simulate (default 600)\n"
+			 "  -dt <num>  time step in seconds (default 1/60)\n"
+			 "  -t <file>  writes the binary trace of all frames\n"
+			 "  -c <file>  compares the trace written with -t with a reference trace\n"
+			 "  -col       checks collisions at each frame\n"
+			 "  -scene     also updates a scene graph of the skeleton\n"
+			 "  -index     checks the kd-tree of KnMotionIndex against a linear search\n"
+			 "  -graph     checks the transitions and the search of KnMotionGraph\n"
+			 "  -rig       checks the skeleton built by KnRigBuilder from a small set of parts\n";
+}
+
+// Motion going through all postures of the skeleton, one per second, back to the first one
+static KnMotion* postures_motion ( KnSkeleton* sk )
+{
+	GsArray<KnPosture*>& postures = sk->postures();
+	if ( postures.size()<2 ) return 0;
+	GsArray<KnPosture*> keys;
+	GsArray<float> times;
+	for ( int i=0; i<=postures.size(); i++ )
+	{	keys.push() = postures[i%postures.size()];
+		times.push() = float(i);
+	}
+	KnMotion* m = new KnMotion;
+	if ( !m->make(keys,times) ) { delete m; return 0; }
+	return m;
+}
+
+// Motion with one frame per simulation step, looping over the duration of m
+static KnMotion* sampled_motion ( KnSkeleton* sk, KnMotion* m, int frames, double dt )
+{
+	GsArray<KnPosture*> keys;
+	GsArray<float> times;
+	m->connect ( sk );
+	for ( int i=0; i<frames; i++ )
+	{	double t = i*dt;
+		if ( m->duration()>0 ) t = fmod ( t, double(m->duration()) );
+		m->apply ( float(t) );
+		KnPosture* p = new KnPosture ( sk );
+		p->get ();
+		keys.push() = p;
+		times.push() = float(i*dt);
+	}
+	KnMotion* sm = new KnMotion;
+	bool ok = sm->make ( keys, times );
+	for ( int i=0; i<keys.size(); i++ ) delete keys[i];
+	m->disconnect ();
+	if ( !ok ) { delete sm; return 0; }
+	return sm;
+}
+
+// Compares the kd-tree search with a linear search for queries at the indexed
+// frames and between consecutive frames, returning the number of differences
+static int check_index ( KnSkeleton* sk, KnMotion* m )
+{
+	KnMotionIndex* mi = new KnMotionIndex ( sk );
+	mi->ref ();
+	mi->add_motion ( m );
+	mi->build ();
+
+	int errors = 0;
+	const int dim = mi->dimension();
+	GsArray<float> q ( dim );
+	for ( int e=0; e<mi->entries(); e++ )
+	{	const float* f1 = mi->features ( e );
+		const float* f2 = mi->features ( e+1<mi->entries()? e+1:e );
+		for ( int k=0; k<2; k++ )
+		{	for ( int d=0; d<dim; d++ )
+				q[d] = k==0? f1[d] : (f1[d]+f2[d])/2.0f+gs_random(-0.05f,0.05f);
+			float dk, dl;
+			int ek = mi->search ( q.pt(), &dk );
+			int el = mi->search_linear ( q.pt(), &dl );
+			if ( ek<0 || el<0 || dk!=dl || ( k==0 && dk!=0 ) ) errors++; // equal distances may be at different frames
+		}
+	}
+	gsout<<"Index: "<<mi->entries()<<" frames, "<<dim<<" features, "<<errors<<" searches differ from the linear search\n";
+	mi->unref ();
+	return errors;
+}
+
+static bool second_clip_end ( const KnMgNode* n, void* udata ) { return n->motion==1 && n->frame==*(int*)udata; }
+
+// Builds a motion graph with the motion spliced with itself, which must have transitions
+// between the two clips, and searches for a path from the start of the first clip to the
+// end of the second one, whose cost cannot be larger than the duration of one clip.
+// Returns the number of errors found.
+static int check_graph ( KnSkeleton* sk, KnMotion* m )
+{
+	KnMotionGraph* mg = new KnMotionGraph ( sk );
+	mg->ref ();
+	mg->add_motion ( m );
+	mg->add_motion ( m );
+	int n = mg->build ();
+
+	int errors=0, between=0;
+	const GsArray<KnMotionGraph::Transition>& t = mg->transitions();
+	for ( int i=0; i<t.size(); i++ )
+	{	if ( t[i].m1!=t[i].m2 ) between++;
+		if ( !mg->node(t[i].m1,t[i].f1) || !mg->node(t[i].m2,t[i].f2) ) errors++;
+		if ( fabs(mg->distance(t[i].m1,t[i].f1,t[i].m2,t[i].f2)-t[i].dist)>1.0E-5f ) errors++;
+	}
+	if ( between==0 ) { gsout<<"Graph: no transitions between the two clips\n"; errors++; }
+
+	GsArray<KnMgNode*> path;
+	float cost=0;
+	int last = int(m->frames())-1;
+	if ( !mg->search(mg->node(0,0),second_clip_end,&last,path,&cost) || path.empty() || path.top()->motion!=1 )
+	{	gsout<<"Graph: the end of the second clip was not reached\n"; errors++; }
+	else if ( cost>m->duration()+1.0E-4f )
+	{	gsout<<"Graph: path cost is larger than the clip duration\n"; errors++; }
+
+	gsout<<"Graph: "<<mg->nodes()<<" nodes, "<<n<<" transitions, "<<between<<" between clips, path with "
+		 <<path.size()<<" nodes and cost "<<cost<<", "<<errors<<" errors\n";
+	mg->unref ();
+	return errors;
+}
+
+static bool same ( const GsVec& a, const GsVec& b ) { return dist(a,b)<1.0E-5f; }
+
+static GsPnt joint_center ( const KnJoint* j ) { GsPnt p; j->gmat().getrans(p); return p; }
+
+// Builds a skeleton from four boxes: a base with an arm and a side part, and a hand
+// attached to the arm. The arm is given at the origin and placed with a matrix.
+// The joints must follow the parts in names, parents and offsets, and at rest the
+// geometry of each joint must be placed where its part was. Rotating the base
+// must then move the arm and the hand around the base pivot.
+// Returns the number of errors found.
+static int check_rig ()
+{
+	GsBox boxes[4] = { GsBox(GsPnt(-0.5f,0,-0.5f),GsPnt(0.5f,1,0.5f)),
+					   GsBox(GsPnt(-0.2f,0,-0.2f),GsPnt(0.2f,1,0.2f)),
+					   GsBox(GsPnt(-0.1f,2,-0.1f),GsPnt(0.1f,2.5f,0.1f)),
+					   GsBox(GsPnt(0.5f,0.2f,-0.2f),GsPnt(1.5f,0.8f,0.2f)) };
+	GsPnt pivots[4] = { GsPnt(0,0,0), GsPnt(0,1,0), GsPnt(0,2,0), GsPnt(0.5f,0.5f,0) };
+	int parents[4] = { -1, 0, 1, 0 };
+	const char* names[4] = { "base", "arm", 0, "side" };
+	GsMat place;
+	place.translation ( 0, 1, 0 );
+
+	KnRigBuilder rig;
+	int errors=0;
+	for ( int i=0; i<4; i++ )
+	{	GsModel m;
+		m.make_box ( boxes[i] );
+		if ( rig.add(&m,i==1?place:GsMat::id,parents[i],pivots[i],names[i])!=i ) errors++;
+	}
+	if ( rig.add(rig.part(0).model,GsMat::id,-1,GsPnt::null)!=-1 ) errors++; // a second root is not valid
+	if ( errors ) { gsout<<"Rig: parts not added\n"; return errors; }
+
+	KnSkeleton* sk = rig.build ();
+	sk->ref ();
+	if ( sk->joints().size()!=4 ) { gsout<<"Rig: "<<sk->joints().size()<<" joints instead of 4\n"; sk->unref(); return 1; }
+	sk->root()->update_gmat ();
+
+	for ( int i=0; i<4; i++ )
+	{	KnJoint* j = sk->joints()[i];
+		if ( j->name()!=(names[i]? names[i]:"part2") ) errors++;
+		if ( (j->parent()? j->parent()->index():-1)!=parents[i] ) errors++;
+		if ( !same(j->offset(),parents[i]<0? pivots[i]:pivots[i]-pivots[parents[i]]) ) errors++;
+
+		GsBox part, geo;
+		rig.part(i).model->get_bounding_box ( part );
+		if ( !j->visgeo() || j->visgeo()->F.size()!=rig.part(i).model->F.size() ) { errors++; continue; }
+		j->visgeo()->get_bounding_box ( geo );
+		GsPnt c = joint_center ( j );
+		if ( !same(c,pivots[i]) || !same(geo.a+c,part.a) || !same(geo.b+c,part.b) ) errors++;
+	}
+
+	sk->root()->rot()->value ( GsQuat(GsVec::k,float(GS_PIDIV2)) );
+	sk->root()->update_gmat ();
+	if ( !same(joint_center(sk->joints()[1]),GsPnt(-1,0,0)) ) errors++;
+	if ( !same(joint_center(sk->joints()[2]),GsPnt(-2,0,0)) ) errors++;
+	if ( !same(joint_center(sk->joints()[3]),GsPnt(-0.5f,0.5f,0)) ) errors++;
+
+	gsout<<"Rig: "<<sk->joints().size()<<" joints, "<<errors<<" errors\n";
+	sk->unref ();
+	return errors;
+}
+
+int main ( int argc, char** argv )
+{
+	const char *skfile=0, *mfile=0, *tfile=0, *cfile=0;
+	int frames=600;
+	double dt=1.0/60.0;
+	bool col=false, scene=false, index=false, graph=false, rig=false;
+
+	for ( int i=1; i<argc; i++ )
+	{	const char* a = argv[i];
+		bool next = i+1<argc;
+		if ( strcmp(a,"-m")==0 && next ) mfile=argv[++i];
+		else if ( strcmp(a,"-n")==0 && next ) frames=atoi(argv[++i]);
+		else if ( strcmp(a,"-dt")==0 && next ) dt=atof(argv[++i]);
+		else if ( strcmp(a,"-t")==0 && next ) tfile=argv[++i];
+		else if ( strcmp(a,"-c")==0 && next ) cfile=argv[++i];
+		else if ( strcmp(a,"-col")==0 ) col=true;
+		else if ( strcmp(a,"-scene")==0 ) scene=true;
+		else if ( strcmp(a,"-index")==0 ) index=true;
+		else if ( strcmp(a,"-graph")==0 ) graph=true;
+		else if ( strcmp(a,"-rig")==0 ) rig=true;
+		else if ( a[0]!='-' && !skfile ) skfile=a;
+		else { usage(); return 2; }
+	}
+	if ( rig && !skfile ) return check_rig()>0? 1:0;
+	if ( !skfile || frames<0 || dt<=0 || (cfile&&!tfile) ) { usage(); return 2; }
+
+	KnSkeleton* sk = new KnSkeleton;
+	sk->ref();
+	if ( !sk->load(skfile) ) { gsout<<"Could not load skeleton "<<skfile<<gsnl; return 1; }
+
+	KnMotion* m = 0;
+	if ( mfile )
+	{	m = new KnMotion;
+		if ( !m->load(mfile) ) { gsout<<"Could not load motion "<<mfile<<gsnl; delete m; return 1; }
+	}
+	else m = postures_motion ( sk );
+	if ( m ) m->ref(); // also referenced by the motion controller
+
+	KnRunner* runner = new KnRunner ( sk, dt );
+	runner->ref();
+
+	if ( m )
+	{	KnCtMotion* cm = new KnCtMotion;
+		cm->init ( m );
+		cm->loop ( true );
+		KnCtScheduler* sched = new KnCtScheduler;
+		sched->init ( sk );
+		sched->schedule ( cm, 0, 0, 0, KnCtScheduler::Static );
+		runner->controller ( sched );
+	}
+	else gsout<<"No motion given and less than 2 postures in the skeleton: simulating the rest posture.\n";
+
+	if ( scene )
+	{	KnScene* sc = new KnScene;
+		sc->connect ( sk );
+		runner->scene ( sc );
+	}
+	if ( col )
+	{	KnColdet* cd = new KnColdet;
+		cd->connect ( sk, "DAC" );
+		runner->coldet ( cd );
+	}
+	if ( tfile && !runner->open_trace(tfile) ) { gsout<<"Could not open "<<tfile<<gsnl; return 1; }
+
+	int n = runner->run ( frames, false );
+	runner->close_trace ();
+
+	const KnRunner::Stats& s = runner->stats();
+	gsout<<"Frames: "<<n<<" joints: "<<sk->joints().size()<<" frames with collisions: "<<s.colframes<<gsnl;
+	gsout<<"Time: "<<s.time<<"s, "<<(s.time>0? s.frames/s.time:0)<<" frames per second\n";
+
+	int result = 0;
+	if ( cfile )
+	{	int f = KnRunner::compare_traces ( tfile, cfile );
+		if ( f==-1 ) gsout<<"Trace matches "<<cfile<<gsnl;
+		else if ( f==-2 ) { gsout<<"Traces have different headers or could not be read\n"; result=1; }
+		else { gsout<<"Traces differ at frame "<<f<<gsnl; result=1; }
+	}
+
+	if ( index || graph )
+	{	KnMotion* sm = m? sampled_motion ( sk, m, frames, dt ) : 0;
+		if ( !sm ) { gsout<<"No motion to check\n"; result=1; }
+		else
+		{	sm->ref();
+			if ( index && check_index(sk,sm)>0 ) result=1;
+			if ( graph && check_graph(sk,sm)>0 ) result=1;
+			sm->unref();
+		}
+	}
+
+	if ( rig && check_rig()>0 ) result=1;
+
+	runner->unref();
+	if ( m ) m->unref();
+	sk->unref();
+	return result;
+}
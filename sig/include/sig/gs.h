@@ -59,6 +59,10 @@ namespace sig { }
 #  define GS_LINUX	//!< Defined if not compiled in windows
 # endif
 
+# if !defined(GS_NO_SSE) && ( defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2) )
+#  define GS_SSE	//!< Defined if SSE2 instructions are available, define GS_NO_SSE to disable their use
+# endif
+
 # ifdef GS_DEF_BOOL
 enum bool { false, true }; //!< use this for old compilers without bool/true/false keywords
 # endif
@@ -73,6 +77,7 @@ typedef uint16_t gsuint16; //!< 2 bytes unsigned int, from 0 to 65,535
 typedef int16_t	 gsint16;  //!< 2 bytes integer, from -32,768 to 32,767
 typedef uint32_t gsuint32; //!< 4 bytes unsigned int, from 0 to 4294967295
 typedef int32_t	 gsint32;  //!< 4 bytes signed integer, from -2147483648 to 2147483647
+typedef uint64_t gsuint64; //!< 8 bytes unsigned int
 typedef int		 gsint;	   //!< 4 or 8 bytes int depending on the compiler
 typedef unsigned int gsuint; //!< 4 or 8 bytes unsigned int depending on the compiler
 
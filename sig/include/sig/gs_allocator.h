@@ -0,0 +1,43 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_ALLOCATOR_H
+# define GS_ALLOCATOR_H
+
+/** \file gs_allocator.h
+ * Memory allocator interface */
+
+# include <stddef.h>
+
+/*! \class GsAllocator gs_allocator.h
+	\brief Interface for custom memory allocators
+
+	GsAllocator provides blocks of memory to containers accepting a custom
+	allocator, as GsSmallArray. The size of a block is always given back when
+	it is resized or freed, so that pools and arenas do not need to store it. */
+class GsAllocator
+{  public :
+	/*! Virtual destructor */
+	virtual ~GsAllocator () {}
+
+	/*! Returns a block of n>0 bytes */
+	virtual void* alloc ( size_t n )=0;
+
+	/*! Resizes block p of n bytes to nn>0 bytes, keeping its contents up to the smallest
+		size. The default implementation allocates a new block, copies the data and frees p. */
+	virtual void* realloc ( void* p, size_t n, size_t nn );
+
+	/*! Releases block p of n bytes */
+	virtual void free ( void* p, size_t n )=0;
+
+	/*! Returns an allocator using the C functions malloc(), realloc() and free() */
+	static GsAllocator* heap ();
+};
+
+//============================== end of file ===============================
+
+# endif // GS_ALLOCATOR_H
@@ -0,0 +1,79 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_ARENA_H
+# define GS_ARENA_H
+
+/** \file gs_arena.h
+ * Region allocator */
+
+# include <new>
+# include <sig/gs_allocator.h>
+
+/*! \class GsArena gs_arena.h
+	\brief Region allocator releasing all its blocks at once
+
+	GsArena places consecutive allocations contiguously in large chunks of memory,
+	which are only released by clear() or by the destructor. It is meant for groups
+	of objects built and destroyed together, as the joints of a skeleton, improving
+	the locality of their traversals and replacing many deletions by a single one.
+	Method free() only recovers the memory of the last allocated block, and realloc()
+	resizes the last block in place when possible.
+	Objects created with make() or make_array() must have their destructors called
+	by the user, if needed, before the arena is cleared. GsArena is not thread safe. */
+class GsArena : public GsAllocator
+{  private :
+	struct Chunk;
+	Chunk* _chunks;		// chunks in use, the current one first
+	char* _cur;			// next free position in the current chunk
+	char* _end;			// end of the current chunk
+	char* _last;		// last block allocated in the current chunk
+	size_t _chunksize;
+	size_t _used;
+	void* _alloc_chunk ( size_t n, bool current );
+
+   public :
+	/*! Constructor with the size of the chunks to allocate. Memory is only
+		allocated at the first allocation. */
+	GsArena ( size_t chunksize=65536 );
+
+	/*! Destructor releases all memory */
+   ~GsArena ();
+
+	/*! Returns a block of n bytes aligned to 16 bytes. Blocks larger than a
+		quarter of the chunk size receive their own chunk. */
+	virtual void* alloc ( size_t n ) override;
+
+	/*! Resizes block p of n bytes to nn bytes. The block is kept in place if it
+		shrinks or if it is the last allocated one and fits in the current chunk,
+		otherwise a new block is returned with its contents copied. */
+	virtual void* realloc ( void* p, size_t n, size_t nn ) override;
+
+	/*! Only recovers the memory if p was the last block allocated */
+	virtual void free ( void* p, size_t n ) override;
+
+	/*! Constructs an object of type X in the arena */
+	template <typename X, typename... Args>
+	X* make ( Args... args ) { return new(alloc(sizeof(X))) X(args...); }
+
+	/*! Constructs an array of n default-constructed objects of type X in the arena */
+	template <typename X>
+	X* make_array ( int n ) { X* a=(X*)alloc(sizeof(X)*(n>0?n:1)); for ( int i=0; i<n; i++ ) new(a+i) X; return a; }
+
+	/*! Makes all memory available again, keeping the first chunk allocated for reuse */
+	void clear ();
+
+	/*! Number of bytes given to blocks since the last clear */
+	size_t used () const { return _used; }
+
+	/*! Number of bytes currently reserved from the heap */
+	size_t reserved () const;
+};
+
+//============================== end of file ===============================
+
+# endif // GS_ARENA_H
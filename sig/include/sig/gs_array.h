@@ -11,10 +11,13 @@
 /** \file gs_array.h 
  * fast resizeable array template */
 
+# include <string.h>
 # include <sig/gs.h> 
 # include <sig/gs_input.h> 
 # include <sig/gs_output.h> 
 
+class GsAllocator;
+
 /*! \class GsArrayBase gs_array.h
 	\brief Fast resizeable array base class
 
@@ -129,6 +132,16 @@ class GsArrayBase
 	/*! Frees the current data of GsArrayBase, and then makes GsArrayBase to control
 		the given buffer pt, with size and capacity as given.  */
 	void adopt (  void* pt, int s, int c );
+
+	/*! Changes the capacity of an array which owns the inline buffer inl of ninl elements
+		(inl is null if ninl is 0). Blocks are obtained from allocator a, or with malloc()
+		if a is null. The capacity is never made smaller than ninl, and the inline buffer
+		is used again whenever it is enough. The size is kept inside [0,nc]. */
+	void recapacity ( unsigned sizeofx, int nc, void* inl, int ninl, GsAllocator* a );
+
+	/*! Frees the data of an array managed with recapacity(), making it an empty
+		array using its inline buffer. */
+	void free_data ( unsigned sizeofx, void* inl, int ninl, GsAllocator* a );
 };
 
 /*! \class GsArray gs_array.h
@@ -280,6 +293,15 @@ class GsArray : protected GsArrayBase
 		then copies the content of x using operator=(). */
 	void push ( const X& x ) { push()=x; }
 
+	/*! Appends n positions with at most one reallocation, and returns a pointer to the
+		first of them. No reallocation is done if the capacity is enough, for example
+		after reserve(); otherwise capacity is set to two times the new size. */
+	X* push_n ( int n ) { int s=_size; if(_size+n<=_capacity) _size+=n; else GsArrayBase::insert(sizeof(X),s,n); return ((X*)_data)+s; }
+
+	/*! Appends a copy of the n elements at pt with memcpy(), which must not point to
+		elements of the array itself. */
+	void push ( const X* pt, int n ) { if ( n>0 ) memcpy ( push_n(n), pt, sizeof(X)*n ); }
+
 	/*! Duplicates the element at the top of the array by pushing a copy of it. */
 	void push_top () { push(); top()=top(1); }
 
@@ -554,6 +576,128 @@ class GsArrayRef : protected GsArray<X*>
 	{	for ( int i=0; i<size(); i++ ) { if (cget(i)==x) return i; } return -1; }
 };
 
+/*! \class GsSmallArray gs_array.h
+	\brief GsArray with inline storage and custom allocators
+
+	GsSmallArray keeps up to N elements in a buffer inside the object, so that
+	small arrays need no allocation at all. Only when more elements are needed
+	a block is obtained from the allocator given to the constructor, or with
+	malloc() if none is given (see GsAllocator). Capacity grows by doubling, and
+	compress() moves the elements back to the inline buffer when they fit.
+	The same restrictions of GsArray about the type X apply. With N=0 it behaves
+	as a GsArray with a custom allocator. */
+template <typename X, int N>
+class GsSmallArray : protected GsArray<X>
+ { private :
+	GsAllocator* _alloc;
+	X _buf[N>0? N:1];
+	void* _inl () const { return N>0? (void*)_buf : 0; }
+	void _grow ( int ns ) { if ( ns>this->_capacity ) GsArrayBase::recapacity ( sizeof(X), GS_MAX(ns,2*this->_capacity), _inl(), N, _alloc ); }
+
+   public:
+	/*! Constructs an empty array using allocator a for blocks that do not fit in the
+		inline storage; malloc() is used if a is null. The allocator cannot be changed. */
+	GsSmallArray ( GsAllocator* a=0 ) : GsArray<X> ( 0, 0 ) { _alloc=a; this->_data=_inl(); this->_capacity=N; }
+
+	/*! Copy constructor, using the same allocator as a */
+	GsSmallArray ( const GsSmallArray& a ) : GsArray<X> ( 0, 0 )
+	{	_alloc=a._alloc; this->_data=_inl(); this->_capacity=N; *this=a; }
+
+	/*! Destructor frees the allocated block if any. Elements' destructors are not called! */
+   ~GsSmallArray () { GsArrayBase::free_data ( sizeof(X), _inl(), N, _alloc ); this->_data=0; }
+
+	/*! Returns the allocator given to the constructor, which may be null */
+	GsAllocator* allocator () const { return _alloc; }
+
+	/*! Returns true if the elements are in the inline storage */
+	bool inlined () const { return this->_data==_inl(); }
+
+	/* Access to the base class function of same name. */
+	bool empty () const { return GsArray<X>::empty(); }
+
+	/* Access to the base class function of same name. */
+	int size () const { return GsArray<X>::size(); }
+
+	/* Access to the base class function of same name. */
+	int capacity () const { return GsArray<X>::capacity(); }
+
+	/*! Changes the size, with capacity growing by doubling when needed */
+	void size ( int ns ) { _grow(ns); this->_size=ns; }
+
+	/*! Changes the capacity, which is never made smaller than N */
+	void capacity ( int nc ) { GsArrayBase::recapacity ( sizeof(X), nc, _inl(), N, _alloc ); }
+
+	/*! Defines a minimum capacity to use */
+	void reserve ( int c ) { if ( this->_capacity<c ) capacity(c); }
+
+	/*! Makes capacity equal to the size, or to N if the elements fit in the inline storage */
+	void compress () { capacity ( this->_size ); }
+
+	/* Access to the base class function of same name. */
+	void setall ( const X& x ) { GsArray<X>::setall(x); }
+
+	/* Access to the base class function of same name. */
+	const X& cget ( int i ) const { return GsArray<X>::cget(i); }
+
+	/* Access to the base class function of same name. */
+	X& get ( int i ) const { return GsArray<X>::get(i); }
+
+	/* Access to the base class operator of same name. */
+	X& operator[] ( int i ) const { return GsArray<X>::operator[](i); }
+
+	/* Access to the base class operator of same name. */
+	const X& operator() ( int i ) const { return GsArray<X>::operator()(i); }
+
+	/* Access to the base class operator of same name. */
+	operator const X* () const { return GsArray<X>::pt(); }
+
+	/* Access to the base class function of same name. */
+	X* pt () const { return GsArray<X>::pt(); }
+
+	/* Access to the base class function of same name. */
+	X& top () const { return GsArray<X>::top(); }
+
+	/* Access to the base class function of same name. */
+	X& pop () { return GsArray<X>::pop(); }
+
+	/*! Appends one position and returns a reference to it */
+	X& push () { _grow(this->_size+1); return ((X*)this->_data)[this->_size++]; }
+
+	/*! Appends one position and copies x to it with operator=() */
+	void push ( const X& x ) { push()=x; }
+
+	/*! Appends n positions with at most one reallocation and returns a pointer to the first */
+	X* push_n ( int n ) { int s=this->_size; _grow(s+n); this->_size+=n; return ((X*)this->_data)+s; }
+
+	/*! Appends a copy of the n elements at pt, which must not point to elements of the array */
+	void push ( const X* pt, int n ) { if ( n>0 ) memcpy ( push_n(n), pt, sizeof(X)*n ); }
+
+	/*! Inserts n positions starting at i in [0,size()], returning a reference to the first */
+	X& insert ( int i, int n=1 ) { push_n(n); GsArray<X>::copy(i+n,i,this->_size-n-i); return get(i); }
+
+	/* Access to the base class function of same name. */
+	void remove ( int i, int n=1 ) { GsArray<X>::remove(i,n); }
+
+	/* Access to the base class function of same name. */
+	void reverse () { GsArray<X>::reverse(); }
+
+	/* Access to the base class function of same name. */
+	void sort ( GS_COMPARE_FUNC ) { GsArray<X>::sort(cmpfunc); }
+
+	/* Access to the base class function of same name. */
+	int lsearch ( const X& x, GS_COMPARE_FUNC ) const { return GsArray<X>::lsearch(x,cmpfunc); }
+
+	/* Access to the base class function of same name. */
+	int bsearch ( const X& x, GS_COMPARE_FUNC, int *pos=NULL ) const { return GsArray<X>::bsearch(x,cmpfunc,pos); }
+
+	/*! Copies the elements of a with memcpy(), keeping the allocator of this array */
+	void operator = ( const GsSmallArray& a )
+	{	if ( &a==this ) return; this->_size=0; push(a.pt(),a.size()); }
+
+	/*! Output of all elements in format [e0 e1 ... en] */
+	friend GsOutput& operator<< ( GsOutput& o, const GsSmallArray& a ) { return o<<(const GsArray<X>&)a; }
+};
+
 //============================== end of file ===============================
 
 #endif // GS_ARRAY_H
@@ -0,0 +1,98 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_BVH_H
+# define GS_BVH_H
+
+/** \file gs_bvh.h
+ * Bounding volume hierarchy of boxes */
+
+# include <sig/gs_box.h>
+# include <sig/gs_line.h>
+# include <sig/gs_array.h>
+
+class GsMat;
+
+/*! \class GsBvh gs_bvh.h
+	\brief Bounding volume hierarchy of axis-aligned boxes
+
+	GsBvh organizes a set of items, each one described by its bounding box,
+	in a binary tree of boxes built with the surface area heuristic. Items are
+	identified by their index in the array of boxes given to build(). The tree
+	can be refit to new boxes of the same items without being rebuilt, what is
+	efficient when items move without changing much their relative positions.
+	Queries for rays, boxes and view frustums are available. */
+class GsBvh
+{  public :
+	/*! Ray callback: must test the intersection of item i with the ray and return
+		the parametric distance t of the closest intersection in [0,tmax), or
+		a negative value if there is no such intersection. */
+	typedef float (*RayFunc) ( int i, const GsLine& ray, float tmax, void* udata );
+
+   private :
+	struct Node
+	{	GsBox box;
+		int first;	// leaf: index of the first item in _items, inner node: index of the left child
+		int count;	// leaf: number of items, inner node: 0; right child is at first+1
+	};
+	GsArray<Node> _nodes;
+	GsArray<int> _items;	// item indices in leaf order
+	GsArray<GsBox> _boxes;	// item boxes in leaf order
+	int _depth;				// depth of the tree, used to size traversal stacks
+	bool _split ( int ni, GsArray<GsPnt>& centers, int leafsize );
+
+   public :
+	/*! Constructs an empty hierarchy */
+	GsBvh ();
+
+	/*! Removes all items */
+	void init ();
+
+	/*! Returns true if there are no items */
+	bool empty () const { return _nodes.empty(); }
+
+	/*! Returns the number of items in the hierarchy */
+	int items () const { return _items.size(); }
+
+	/*! Returns the number of nodes of the tree */
+	int nodes () const { return _nodes.size(); }
+
+	/*! Returns the box of the root node containing all items; it is empty if there are no items */
+	GsBox box () const { return _nodes.empty()? GsBox() : _nodes[0].box; }
+
+	/*! Builds the hierarchy for the given boxes, with at most leafsize items per leaf.
+		Empty boxes are not inserted and will never be returned by queries. */
+	void build ( const GsArray<GsBox>& boxes, int leafsize=4 );
+
+	/*! Recomputes the boxes of all nodes keeping the tree structure. The given array
+		must have the same size as the one given to build(), with updated boxes. */
+	void refit ( const GsArray<GsBox>& boxes );
+
+	/*! Finds the item intersected first by the ray (p1,p2), considering the parametric
+		distances t in [0,tmax) along the ray, where t=0 at p1 and t=1 at p2. Function f
+		is called only for items with boxes crossed by the ray, in approximately front to
+		back order, and items farther than the closest intersection found are skipped.
+		Returns the index of the item found or -1; t will contain its distance. */
+	int ray ( const GsLine& ray, RayFunc f, void* udata, float& t, float tmax=1.0E+30f ) const;
+
+	/*! Appends to items the indices of all items with boxes intersecting box b */
+	void overlap ( const GsBox& b, GsArray<int>& items ) const;
+
+	/*! Appends to items the indices of all items with boxes not entirely outside the
+		view frustum of the full camera matrix m, as given by GsCamera::getmat(m).
+		The test is conservative and may include some items which are not visible. */
+	void frustum ( const GsMat& m, GsArray<int>& items ) const;
+
+	/*! Returns the parametric distances [t1,t2] where the ray crosses box b, with t2>=0,
+		or false if the ray does not cross the box. Parameter invd must contain the inverse
+		of the coordinates of the ray direction (p2-p1). */
+	static bool ray_box ( const GsPnt& p1, const GsVec& invd, const GsBox& b, float& t1, float& t2 );
+};
+
+//============================== end of file ===============================
+
+# endif // GS_BVH_H
@@ -55,8 +55,10 @@ class GsGraphNode : public GsListNode
 	GsArray<GsGraphLink*> _links;
 	gsuint _index;
 	int _blocked; // used as boolean or as a ref counter
+	int _sid;	  // index in the search tree while marked by a search
 	GsGraphBase* _graph;
 	friend class GsGraphBase;
+	friend class GsGraphPathTree;
    public :
 	float fparam; // generic parameter for algorithms
 
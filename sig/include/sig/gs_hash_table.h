@@ -0,0 +1,192 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+/** \file gs_hash_table.h
+ * Open addressing hash table */
+
+# ifndef GS_HASH_TABLE_H
+# define GS_HASH_TABLE_H
+
+# include <sig/gs_array.h>
+
+//================================ GsHashTableBase ===============================
+
+/*! \class GsHashTableBase gs_hash_table.h
+	Stores user data associated with string keys, with the same interface and
+	the same case-sensitive comparison of keys as GsTableBase. Entries are kept
+	in an array and their indices, or ids, do not change while they are in the
+	table; the hash table itself only stores entry ids, searched with linear
+	probing, and grows automatically to keep its load below 50%. The hash of
+	each key is kept in its entry so that growing the table does not access the
+	keys and that most comparisons of non-matching keys are avoided.
+	Keys can be allocated, referenced, or interned. Interned keys are stored in a
+	global pool keeping one copy of each string, which is never released; they
+	are suited to tables of names, as joint names, that live during the whole
+	application, and comparing keys given by key() of an interned table only
+	requires a pointer comparison. The interning pool is not thread safe.
+	As in GsTableBase, the user is responsible for the allocation of the user data. */
+class GsHashTableBase
+{  public :
+	struct Entry { char* key;	// the string key of this entry, or null if removed
+				   void* data;	// the user data associated or null if none
+				   gsuint hash;	// the hash value of the key
+				 };
+	enum KeyStorage { ReferencedKeys=0, AllocatedKeys=1, InternedKeys=2 };
+
+   protected:
+	GsArray<Entry> _entries; // entries indexed by their ids
+	GsArray<int> _slots;	 // entry ids in the hash table, -1 if free and -2 if removed
+	GsArray<int> _free;		 // ids of removed entries
+	int _elements;
+	int _removed;			 // number of slots marked as removed
+	int _last_id;
+	gscenum _key_storage;
+
+   protected:
+
+	/*! Constructor reserving space for hsize elements. The table does not need
+		to be initialized before inserting elements, as it grows as needed. */
+	GsHashTableBase ( int hsize=0, KeyStorage ks=AllocatedKeys );
+
+	/*! Destructor deletes allocated keys but no action is taking regarding the user data */
+   ~GsHashTableBase ();
+
+	/*! Removes all entries and reserves space for hsize elements */
+	void init ( int hsize, KeyStorage ks=AllocatedKeys );
+
+   public :
+
+	/*! Rebuilds the hash table in order to hold at least newhsize elements
+		without growing; entry ids are not changed */
+	void rehash ( int newhsize );
+
+	/*! Returns the number of entry ids in use, including removed entries, which have null keys */
+	int size () const { return _entries.size(); }
+
+	/*! Returns the current number of slots in the hash table */
+	int hashsize () const { return _slots.size(); }
+
+	/*! Returns the number of elements not found in their first probed slot */
+	int collisions () const;
+
+	/*! Returns the maximum number of keys compared when searching for a key in the table */
+	int longest_entry () const;
+
+	/*! Total number of elements in the table */
+	int elements () const { return _elements; }
+
+	/*! Returns the id of the next element probed after element id when searching
+		for a key with the same hash slot, or -1 if there is no such element */
+	int collidingid ( int id ) const;
+
+	/*! Returns the string key associated with the given id (can be null).
+		No validity checkings in the index are done! */
+	const char* key ( int id ) const { return _entries[id].key; }
+
+	/*! Returns the user data associated with the given id (can be null).
+		No validity checkings in the index are done! */
+	void* data ( int id ) const { return _entries[id].data; }
+
+	/*! Returns the id of the entry with the given key, or -1 if it is not
+		in the table or if key is null */
+	int lookup_index ( const char *key ) const;
+
+	/*! Returns the user data associated with the given key, or null if not found */
+	void* lookup ( const char* key ) const;
+
+	/*! Returns the id involved in the last call to the insert method, there are 3 cases,
+		it will be: a) the index of the added entry, b) the index of the found
+		duplicated entry, or c) -1 if the string key was null. */
+	int lastid () const { return _last_id; }
+
+	/*! Returns the copy of s stored in the global pool of interned strings, adding
+		it if needed. Returns null if s is null. */
+	static const char* intern ( const char* s );
+
+   protected:
+
+	/*! Inserts a key and user data in the table and returns true in case of success.
+		False is returned if the key already exists, its id can then be retrieved with
+		lastid(), or if key is null. */
+	bool insert ( const char *key, void* data );
+
+	/*! Removes and returns the data associated with key. Returns 0 if key was not found.
+		The id of the removed entry may be reused by the next insertions. */
+	void* remove ( const char *key );
+
+   private :
+	int _find_slot ( const char* key, gsuint h ) const;
+	void _rebuild ( int nslots );
+};
+
+//================================ GsHashTable ===============================
+
+/*! \class GsHashTable gs_hash_table.h
+	Template version of the hash table with typecasts to a user type X, with
+	the same interface as GsTable. Type X is considered to be a pointer. */
+template <class X>
+class GsHashTable : public GsHashTableBase
+ { public:
+	/*! This constructor simply calls the constructor of the base class */
+	GsHashTable ( int hsize=0, KeyStorage ks=AllocatedKeys ) : GsHashTableBase(hsize,ks) {}
+
+	/*! Removes all entries and reserves space for hsize elements */
+	void init ( int hsize, KeyStorage ks=AllocatedKeys ) { GsHashTableBase::init(hsize,ks); }
+
+	/*! Simple type cast to the base class method */
+	X data ( int id ) const { return (X)GsHashTableBase::data(id); }
+
+	/*! Simple type cast to the base class method */
+	X lookup ( const char* st ) const { return (X)GsHashTableBase::lookup(st); }
+
+	/*! Simple type cast to the base class method */
+	bool insert ( const char *st, X data ) { return GsHashTableBase::insert(st,(void*)data); }
+
+	/*! Simple type cast to the base class method */
+	X remove ( const char *st ) { return (X)GsHashTableBase::remove(st); }
+};
+
+//================================ GsHashTablePt ===============================
+
+/*! \class GsHashTablePt gs_hash_table.h
+	Version of the hash table owning the user objects, with the same
+	interface as GsTablePt. */
+template <class X>
+class GsHashTablePt : public GsHashTable<X*>
+ { public:
+	/* Access to the base class contructor */
+	GsHashTablePt ( int hsize=0, GsHashTableBase::KeyStorage ks=GsHashTableBase::AllocatedKeys ) : GsHashTable<X*>(hsize,ks) {}
+
+	/* Destructor will delete all user data and destroy the table */
+   ~GsHashTablePt () { _delete_data(); }
+
+	/*! Will delete all user data in the table and then initialize an empty table for hsize elements */
+	void init ( int hsize, GsHashTableBase::KeyStorage ks=GsHashTableBase::AllocatedKeys )
+	 { _delete_data(); GsHashTable<X*>::init(hsize,ks); }
+
+	/*! Inserts a string key and allocates the corresponding user data to it.
+		Returns a valid pointer in case of success and 0 otherwise, in which
+		case the user object is not allocated. */
+	X* insert ( const char *st )
+	 { if ( GsHashTableBase::insert(st,0) )
+		{ X* x=new X; GsHashTableBase::_entries[GsHashTableBase::_last_id].data=x; return x; } return 0; }
+
+	/*! Inserts a string key and associates the already allocated user data x to it.
+		Returns x in case of success, otherwise x is deleted and 0 is returned. */
+	X* insert ( const char *st, X* x )
+	 { if ( GsHashTableBase::insert(st,x) ) return x; delete x; return 0; }
+
+   private :
+	void _delete_data ()
+	 { for ( int i=0; i<GsHashTableBase::_entries.size(); i++ )
+		{ delete (X*)GsHashTableBase::_entries[i].data; GsHashTableBase::_entries[i].data=0; }
+	 }
+};
+
+//============================== end of file ===============================
+
+# endif  // GS_HASH_TABLE_H
@@ -177,6 +177,141 @@ class GsHeapPt : protected GsHeap<X*,Y>
     void compress () { GsHeap<X*,Y>::compress(); }
 };
 
+/*! \class GsIndexedHeap gs_heap.h
+	\brief D-ary heap of integer ids supporting decrease-key
+
+	GsIndexedHeap orders integer ids in [0,n) by their costs, keeping at most
+	one entry per id, as needed by searches over nodes with dense indices.
+	The position of each id in the heap is maintained, so that contains() takes
+	constant time and the cost of an id already in the heap can be lowered with
+	decrease_key() instead of inserting a duplicate entry. Each element has D
+	children: the default D=4 makes the heap shallower than a binary heap, with
+	the children of an element next to each other in memory. The remove() method
+	always removes the element with minimum cost. */
+template <typename Y, int D=4>
+class GsIndexedHeap
+{  protected :
+	struct Elem { int id; Y c; };
+	GsArray<Elem> _heap;
+	GsArray<int> _pos; // position of each id in the heap, or -1 if not in the heap
+
+	void _place ( int k, const Elem& e ) { _heap[k]=e; _pos[e.id]=k; }
+
+	void _swim ( int k )
+	{	Elem e = _heap[k];
+		while ( k>0 )
+		{	int p = (k-1)/D;
+			if ( !(_heap[p].c>e.c) ) break;
+			_place ( k, _heap[p] );
+			k = p;
+		}
+		_place ( k, e );
+	}
+
+	void _sink ( int k )
+	{	Elem e = _heap[k];
+		int n = _heap.size();
+		while ( true )
+		{	int c = k*D+1;
+			if ( c>=n ) break;
+			int m=c, cmax = c+D<n? c+D:n;
+			for ( c++; c<cmax; c++ ) if ( _heap[m].c>_heap[c].c ) m=c;
+			if ( !(e.c>_heap[m].c) ) break;
+			_place ( k, _heap[m] );
+			k = m;
+		}
+		_place ( k, e );
+	}
+
+   public :
+
+	/*! Default constructor. */
+	GsIndexedHeap () {}
+
+	/*! Makes ids in [0,n) valid. Ids are also made valid by insert() as needed. */
+	void ids ( int n )
+	{	int s=_pos.size(); if ( n<=s ) return;
+		_pos.size(n); for ( int i=s; i<n; i++ ) _pos[i]=-1;
+	}
+
+	/*! Set the capacity of the internal array of elements */
+	void capacity ( int c ) { _heap.capacity(c); }
+
+	/*! Returns true if the heap is empty, false otherwise. */
+	bool empty () const { return _heap.empty(); }
+
+	/*! Returns the number of elements in the queue. */
+	int size () const { return _heap.size(); }
+
+	/*! Initializes as an empty heap, in time proportional to its size */
+	void init () { for ( int i=0; i<_heap.size(); i++ ) _pos[_heap[i].id]=-1; _heap.size(0); }
+
+	/*! Compress the internal arrays */
+	void compress () { _heap.compress(); _pos.compress(); }
+
+	/*! Returns true if id is in the heap */
+	bool contains ( int id ) const { return id>=0 && id<_pos.size() && _pos[id]>=0; }
+
+	/*! Inserts id, which cannot be already in the heap, with the given cost */
+	void insert ( int id, Y cost )
+	{	ids ( id+1 );
+		Elem& e = _heap.push();
+		e.id = id;
+		e.c = cost;
+		_swim ( _heap.size()-1 );
+	}
+
+	/*! Lowers the cost of id, which must be in the heap. If the given cost is not
+		lower than the current one nothing is done and false is returned. */
+	bool decrease_key ( int id, Y cost )
+	{	int k = _pos[id];
+		if ( !(_heap[k].c>cost) ) return false;
+		_heap[k].c = cost;
+		_swim ( k );
+		return true;
+	}
+
+	/*! Removes the element in the top of the heap, which is always
+		the element with lowest cost. */
+	void remove ()
+	{	_pos[_heap[0].id] = -1;
+		Elem e = _heap.pop();
+		if ( _heap.size()>0 ) { _place(0,e); _sink(0); }
+	}
+
+	/*! Removes id from the heap if it is there */
+	void remove ( int id )
+	{	if ( !contains(id) ) return;
+		int k = _pos[id];
+		_pos[id] = -1;
+		Elem e = _heap.pop();
+		if ( k<_heap.size() ) { _place(k,e); _swim(k); _sink(_pos[e.id]); }
+	}
+
+	/*! Returns the id in the top of the heap, which always has the lowest cost. */
+	int top () const { return _heap[0].id; }
+
+	/*! Get the lowest cost in the heap, which is always the cost of the top element. */
+	Y lowest_cost () const { return _heap[0].c; }
+
+	/*! Returns the cost of id, which must be in the heap */
+	Y idcost ( int id ) const { return _heap[_pos[id]].c; }
+
+	/*! Returns the id in position i (0<=i<size) for inspection */
+	int elem ( int i ) const { return _heap[i].id; }
+
+	/*! Returns the cost in position i (0<=i<size) for inspection */
+	Y cost ( int i ) const { return _heap[i].c; }
+
+	/*! Output all elements of the heap in an ordered fashion for debugging. */
+	friend GsOutput& operator<< ( GsOutput& o, const GsIndexedHeap<Y,D>& ch )
+	{	GsIndexedHeap<Y,D> h(ch);
+		o << '[';
+		while ( h.size()>0 ) { o << gspc << h.top() << ':' << h.lowest_cost(); h.remove(); }
+		return o << ' ' << ']';
+	}
+};
+
 //============================== end of file ===============================
 
 #endif // GS_HEAP_H
@@ -272,14 +272,15 @@ class GsMat
 	void ortho ( float left, float right, float bottom, float top, float near, float far );
 
 	/*! Fast invertion by direct calculation, no loops, no gauss, no pivot searching, 
-		but with more numerical errors. The result is returned in the 'inv' parameter. */
+		but with more numerical errors. The result is returned in the 'inv' parameter,
+		which can be GsMat itself. If the determinant is zero inv is not changed. */
 	void inverse ( GsMat& inv ) const;
 
 	/*! Returns the inverse in a new matrix returned by value, callinf the inverse(GsMat&) method*/
 	GsMat inverse () const  { GsMat inv(NoInit); inverse(inv); return inv; }
 
 	/*! Makes GsMat to be its inverse, calling the inverse() method. */
-	void invert () { *this=inverse(); }
+	void invert () { inverse(*this); }
 
 	/*! Fast 4x4 determinant by direct calculation, no loops, no gauss. */
 	float det () const;
@@ -295,11 +296,13 @@ class GsMat
 	float norm () const;
 
 	/*! Set GsMat to be the result of the multiplication of m1 with m2.
-		This method is safe if one of the given parameters is equal to 'this'. */
+		This method is safe if one of the given parameters is equal to 'this',
+		no memory is allocated, and SSE instructions are used if GS_SSE is defined. */
 	void mult ( const GsMat& m1, const GsMat& m2 );
 
 	/*! Set GsMat to be the result of the multiplication of affine matrices m1 and m2,
-		i.e., with 4th line 0,0,0,1. GsMat must be different than m1 and m2. */
+		i.e., with 4th line 0,0,0,1. Only the first 3 lines of GsMat are set, and
+		as in mult() one of the parameters can be equal to 'this'. */
 	void multaff ( const GsMat& m1, const GsMat& m2 );
 
 	/*! Sets GsMat to be the addition of m1 with m2. */
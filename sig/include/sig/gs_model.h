@@ -194,6 +194,17 @@ class GsModel : public GsShareable
 		in which case the GeoMode will be Smooth. */
 	void smooth ( float crease_angle=GS_TORAD(35.0f) );
 
+	/*! Simplifies the model by collapsing edges in the order given by the quadric error
+		metric of Garland and Heckbert, until at most nfaces faces remain or no more edges
+		can be collapsed. Each collapse removes one vertex into one of its neighbors, so
+		that the normals, texture coordinates and colors of the remaining vertices are kept.
+		Open borders, borders between groups or materials, texture seams and normal creases
+		are kept as feature lines: their vertices are only collapsed along the lines and
+		their corners are never removed. Collapses creating duplicated faces are not done,
+		so that a closed mesh keeps at least 4 faces. The order of the faces inside groups is kept.
+		Models representing primitives are not changed. Returns the final number of faces. */
+	int simplify ( int nfaces );
+
   public : // query functions:
 
 	/*! Returns 3F/2, which is the number of edges for "well connected" manifold meshes */
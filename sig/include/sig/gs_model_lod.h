@@ -0,0 +1,89 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_MODEL_LOD_H
+# define GS_MODEL_LOD_H
+
+/** \file gs_model_lod.h
+ * Levels of detail of a model */
+
+# include <sig/gs_model.h>
+
+/*! \class GsModelLod gs_model_lod.h
+	\brief Chain of simplified versions of a model
+
+	GsModelLod keeps a model and a chain of simplified versions of it, see
+	GsModel::simplify(). Each level has a minimum projected size, which is the
+	diameter of the bounding sphere of the model projected in the screen, as a
+	fraction of the viewport height. Level i is selected for projected sizes
+	smaller than the minimum size of level i-1 and greater or equal to its own.
+	All models are referenced, and the levels have to be built again if the
+	original model is changed. */
+class GsModelLod : public GsShareable
+{  private :
+	GsArray<GsModel*> _levels;	// level 0 is the original model
+	GsArray<float> _minsize;	// minimum projected size of each level
+	GsPnt _center;				// bounding sphere of the original model
+	float _radius;
+
+   public :
+	/*! Constructor of an empty chain */
+	GsModelLod ();
+
+	/*! Constructor calling build() with default parameters */
+	GsModelLod ( GsModel* m );
+
+	/*! Destructor unreferences all models */
+	virtual ~GsModelLod ();
+
+	/*! Unreferences all models and empties the chain */
+	void init ();
+
+	/*! Builds up to maxlevels levels including m, which becomes level 0. Each level
+		is simplified from m to have the number of faces of the previous level multiplied
+		by ratio, and no more levels are built once minfaces is reached or when a level
+		cannot be simplified further. Minimum sizes are then set with detail(). */
+	void build ( GsModel* m, int maxlevels=4, float ratio=0.5f, int minfaces=64 );
+
+	/*! Sets the minimum projected sizes so that level 0 is used for sizes greater
+		or equal to s, and each following level is used down to a size reduced by the
+		square root of its face ratio, so that the number of faces per screen area is
+		kept. The last level has minimum size 0. The default s is 0.5. */
+	void detail ( float s );
+
+	/*! Returns the number of levels, which is 0 for an empty chain */
+	int levels () const { return _levels.size(); }
+
+	/*! Returns level i, with level 0 being the original model */
+	GsModel* level ( int i ) const { return _levels[i]; }
+
+	/*! Returns the minimum projected size of level i */
+	float min_size ( int i ) const { return _minsize[i]; }
+
+	/*! Sets the minimum projected size of level i, sizes must decrease with i */
+	void min_size ( int i, float s ) { _minsize[i]=s; }
+
+	/*! Returns the center of the bounding sphere of the original model */
+	const GsPnt& center () const { return _center; }
+
+	/*! Returns the radius of the bounding sphere of the original model */
+	float radius () const { return _radius; }
+
+	/*! Returns the projected size of the bounding sphere given the projection and
+		modelview matrices, considering the largest scaling factor of the modelview */
+	float projected_size ( const GsMat& proj, const GsMat& modelview ) const;
+
+	/*! Returns the level to be used for the given projected size */
+	int select ( float size ) const;
+
+	/*! Returns the level to be used with the given matrices, see projected_size() */
+	int select ( const GsMat& proj, const GsMat& modelview ) const { return select(projected_size(proj,modelview)); }
+};
+
+//============================== end of file ===============================
+
+# endif // GS_MODEL_LOD_H
@@ -0,0 +1,89 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_MODEL_REGISTRY_H
+# define GS_MODEL_REGISTRY_H
+
+/** \file gs_model_registry.h
+ * Registry of shared models */
+
+# include <sig/gs_model.h>
+# include <sig/gs_hash_table.h>
+
+/*! \class GsModelRegistry gs_model_registry.h
+	\brief Keeps shared models loaded only once
+
+	GsModelRegistry keeps references to models indexed by file name, so that
+	loading a same file several times returns the same GsModel, which can then
+	be shared by many SnModel nodes. Optionally models are also indexed by a hash
+	of their contents, so that equal models loaded from different files or
+	created in code are also shared. Shared models should not be modified. */
+class GsModelRegistry
+{  private :
+	GsHashTable<GsModel*> _files;	// models by file name
+	GsHashTable<GsModel*> _hashes;	// models by content hash
+	GsArray<GsModel*> _models;	// all referenced models
+	gscbool _bycontent;
+	static void _key ( const char* filename, GsString& key );
+	static void _key ( gsuint64 hash, GsString& key );
+	GsModel* _find ( GsModel* m, gsuint64 h ) const;
+
+   public :
+	/*! Constructor of an empty registry, with content deduplication on or off */
+	GsModelRegistry ( bool bycontent=false );
+
+	/*! Destructor unreferences all models */
+   ~GsModelRegistry ();
+
+	/*! Unreferences all models and empties the registry */
+	void init ();
+
+	/*! Turns on or off the sharing of models with equal contents, default is off.
+		Only models added after the call are affected. */
+	void dedup_by_content ( bool b ) { _bycontent=b; }
+
+	/*! Returns the content deduplication state */
+	bool dedup_by_content () const { return _bycontent!=0; }
+
+	/*! Number of different models in the registry */
+	int size () const { return _models.size(); }
+
+	/*! Returns model i */
+	GsModel* get ( int i ) const { return _models[i]; }
+
+	/*! Returns the model loaded from the given file, or null if not in the registry */
+	GsModel* get ( const char* filename ) const;
+
+	/*! Returns the model of the given file, loading it if it is not already in the
+		registry. The returned model is referenced by the registry. If the file
+		cannot be loaded null is returned. */
+	GsModel* load ( const char* filename );
+
+	/*! Adds model m, which is then referenced, and returns it. If the content
+		deduplication is on and an equal model is already in the registry, the
+		existing model is returned instead and m is referenced and unreferenced,
+		what deletes m if it is not referenced anywhere else. If m has a file name
+		it is also indexed by it. */
+	GsModel* add ( GsModel* m );
+
+	/*! Removes and unreferences all models which are only referenced by the
+		registry, returning the number of models removed */
+	int purge ();
+
+	/*! Returns a 64 bit hash of the geometry, materials and group data of m */
+	static gsuint64 hash ( const GsModel& m );
+
+	/*! Returns true if the data considered by hash() is the same in a and b */
+	static bool equal ( const GsModel& a, const GsModel& b );
+
+	/*! Returns a registry shared by the application, without content deduplication */
+	static GsModelRegistry& shared ();
+};
+
+//============================== end of file ===============================
+
+# endif // GS_MODEL_REGISTRY_H
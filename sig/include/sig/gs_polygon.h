@@ -145,6 +145,14 @@ class GsPolygon : public GsArray<GsPnt2>
 		collinear vertices in order to improve robustness. */
 	void ear_triangulation ( GsArray<int>& tris, float prec=0.00001f ) const;
 
+	/*! Divides the polygon in triangles defined by indices to the vertices in O(n log n)
+		time, by first partitioning it in y-monotone pieces. Convex polygons are directly
+		triangulated as a fan. The polygon is expected to be simple, and it can be in
+		CW or CCW orientation; triangles are given in the same orientation as the polygon.
+		Vertices closer than prec to the previous vertex are skipped. If the partition
+		fails, for example due to self-intersections, ear_triangulation() is used. */
+	void triangulation ( GsArray<int>& tris, float prec=0.00001f ) const;
+
 	/*! Returns the min,max coords of the bounding square of the polygon.
 		If this polygon is empty, (1,1),(0,0) is returned. */
 	void get_bounding_box ( float& minx, float& miny, float& maxx, float& maxy ) const;
@@ -10,7 +10,32 @@
 
 /*! \file gs_shared.h 
 	Reference counter for smart pointer behavior.
-	Note: attention is required to avoid circular references */
+	Note: attention is required to avoid circular references.
+	By default the counter is a plain integer and objects cannot be shared by
+	several threads. Defining GS_ATOMIC_REF in the compiler options of both the
+	sig libraries and the application makes ref() and unref() atomic, so that
+	threads can hold and release references to the same objects. Increments are
+	then relaxed and decrements have acquire/release order, making all changes
+	done by other threads visible when the object is deleted. Other accesses to
+	shared objects still require synchronization by the user. */
+
+# ifdef GS_ATOMIC_REF
+#  if defined(_MSC_VER)
+#   include <intrin.h>
+#   define GS_REF_INC(r) _InterlockedIncrement((volatile long*)&r)
+#   define GS_REF_DEC(r) _InterlockedDecrement((volatile long*)&r)
+#   define GS_REF_GET(r) (*(volatile unsigned*)&r)
+#  else
+#   define GS_REF_INC(r) __atomic_fetch_add(&r,1u,__ATOMIC_RELAXED)
+#   define GS_REF_DEC(r) __atomic_sub_fetch(&r,1u,__ATOMIC_ACQ_REL)
+#   define GS_REF_GET(r) __atomic_load_n(&r,__ATOMIC_RELAXED)
+#  endif
+# else
+#  define GS_REF_INC(r) (++r)
+#  define GS_REF_DEC(r) (--r)
+#  define GS_REF_GET(r) (r)
+# endif
+
 class GsShareable
 { private :
 	unsigned int _ref;
@@ -27,18 +52,21 @@ class GsShareable
   public :
 
 	/*! Returns true if the reference counter has 0 or 1, and false otherwise. */
-	bool singleref () const { return _ref<=1; }
+	bool singleref () const { return GS_REF_GET(_ref)<=1; }
 
 	/*! Returns the current reference counter value. */
-	unsigned getref () const { return _ref; }
+	unsigned getref () const { return GS_REF_GET(_ref); }
 
 	/*! Increments the reference counter. */
-	void ref () { _ref++; }
+	void ref () { GS_REF_INC(_ref); }
 
 	/*! Decrements the reference counter, and if the counter becomes 0,
 		the object is automatically self deleted. A fatal error is generated
 		in case unref is called with the number of references being zero. */
 	void unref();
+
+	/*! Returns true if sig was compiled with GS_ATOMIC_REF */
+	static bool atomicref ();
 };
 
 /*! Unreferences obj1 (if not null) and references obj2 (if not null). */
@@ -0,0 +1,78 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GS_THREAD_POOL_H
+# define GS_THREAD_POOL_H
+
+/** \file gs_thread_pool.h
+ * Pool of worker threads */
+
+# include <sig/gs.h>
+
+/*! \class GsThreadPool gs_thread_pool.h
+	\brief Pool of worker threads for parallel loops and asynchronous tasks.
+
+	GsThreadPool keeps a fixed number of worker threads waiting for work.
+	Method run() executes a parallel loop and returns when all indices were
+	processed; the calling thread also takes part in the loop. Method push()
+	queues a single asynchronous task, and wait() blocks until all queued tasks
+	are done. Each call of a loop function receives a slot index in [0,slots()),
+	which is unique among the threads running at the same time and can be used
+	to select per-thread scratch data. A pool with zero workers runs everything
+	in the calling thread. */
+class GsThreadPool
+{  public :
+	/*! Parallel loop function: i is the loop index, slot identifies the running thread */
+	typedef void (*LoopFunc) ( int i, int slot, void* udata );
+
+	/*! Asynchronous task function */
+	typedef void (*TaskFunc) ( void* udata );
+
+   private :
+	struct Data;
+	Data* _data;
+
+   public :
+	/*! Creates the pool with the given number of worker threads. If workers<0 (the
+		default) the number of hardware threads minus one is used, so that together
+		with the calling thread all cores are used. */
+	GsThreadPool ( int workers=-1 );
+
+	/*! Destructor waits for queued tasks to finish and joins all threads */
+   ~GsThreadPool ();
+
+	/*! Returns the number of worker threads */
+	int workers () const;
+
+	/*! Returns the number of slot indices passed to loop functions, which is workers()+1 */
+	int slots () const { return workers()+1; }
+
+	/*! Calls f(i,slot,udata) for all i in [0,n) using the workers and the calling
+		thread, and returns when all calls are completed. Indices are dispatched in
+		chunks of the given size; if chunk<=0 a size is chosen from n and slots().
+		Calling run() from inside a loop function is allowed: the nested loop is
+		always completed by its caller even if no workers are available. */
+	void run ( int n, LoopFunc f, void* udata, int chunk=0 );
+
+	/*! Queues the asynchronous task f(udata) and returns immediately. If the pool
+		has no workers the task is executed before returning. */
+	void push ( TaskFunc f, void* udata );
+
+	/*! Returns the number of queued or running tasks pushed with push() */
+	int pending () const;
+
+	/*! Blocks until all tasks pushed with push() are completed */
+	void wait ();
+
+	/*! Returns a pool shared by the whole application, created at first use with
+		the default number of workers and deleted at exit. */
+	static GsThreadPool* shared ();
+};
+
+//============================== end of file ===============================
+
+# endif // GS_THREAD_POOL_H
@@ -0,0 +1,136 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef SA_BVH_H
+# define SA_BVH_H
+
+/** \file sa_bvh.h
+ * Scene bounding volume hierarchy
+ */
+
+# include <sig/gs_bvh.h>
+# include <sig/sa_action.h>
+
+class GsModel;
+
+/*! \class SaBvh sa_bvh.h
+	\brief Bounding volume hierarchy of a scene
+
+	SaBvh keeps a two-level acceleration structure for ray, box and frustum
+	queries over the visible shapes of a scene graph. Each shape is an instance
+	with the global matrix accumulated from the transforms and editors above it.
+	SnModel shapes (and derived classes) have a triangle hierarchy in local
+	coordinates, which is shared by all instances of a same GsModel, and a top
+	level hierarchy organizes the global bounding boxes of all instances.
+	After matrices change, update() refits the top level hierarchy without
+	rebuilding the triangle hierarchies. Helpers of editors are not included.
+	If triangle hierarchies are not needed, for example for culling, models can
+	be represented only by their bounding boxes. Shapes are referenced while in
+	the structure. */
+class SaBvh : public SaAction
+{  public :
+	/*! Result of a ray query */
+	struct Hit
+	{	SnShape* shape;	//!< shape hit, or null if none
+		int instance;	//!< index of the instance hit, or -1
+		int face;		//!< index of the face hit for SnModel shapes, or -1
+		float t;		//!< parametric distance along the ray
+		GsPnt p;		//!< intersection point in global coordinates
+	};
+
+   private :
+	struct Mesh;
+	struct Instance
+	{	SnShape* shape;
+		Mesh* mesh;	// triangle hierarchy for models, or null
+		GsMat mat;	// global matrix
+		GsMat inv;	// inverse of the global matrix
+		GsBox box;	// local bounding box
+	};
+	GsArray<Instance> _inst;
+	GsArray<GsBox> _boxes;	// global bounding boxes of the instances
+	GsArray<Mesh*> _meshes;
+	GsBvh _top;
+	int _cur;				// instance visited during update()
+	gscbool _updating;
+	gscbool _rebuild;
+	gscbool _moved;
+	gscbool _usemeshes;
+	Mesh* _getmesh ( const GsModel* m );
+	static float _rayinst ( int i, const GsLine& ray, float tmax, void* udata );
+	static float _raytri ( int i, const GsLine& ray, float tmax, void* udata );
+
+   public :
+	/*! Constructor of an empty structure. If meshes is false, models are represented
+		by their bounding boxes, which are only updated when the shapes are changed,
+		and ray queries will not be at the triangle level. */
+	SaBvh ( bool meshes=true );
+
+	/*! Destructor unreferences all shapes and deletes all hierarchies */
+	virtual ~SaBvh ();
+
+	/*! Removes all instances and hierarchies */
+	void init ();
+
+	/*! Builds the structure for the scene graph starting at root, reusing the
+		triangle hierarchies of models which were already in the structure */
+	void build ( SnNode* root );
+
+	/*! Traverses the scene graph to update the matrices and boxes of the instances.
+		If only matrices or boxes changed, the top level hierarchy is refit and 1 is
+		returned. If the shapes or the models changed, the structure is rebuilt and
+		2 is returned. If nothing changed 0 is returned. The scene graph must not be
+		changed while in the structure without calling update() or build(). */
+	int update ( SnNode* root );
+
+	/*! Models are only checked for changes in their number of vertices and faces, or
+		in their array pointers. This method forces the triangle hierarchy of m to be
+		rebuilt in the next update, and should be called after changing vertices in place. */
+	void model_changed ( const GsModel* m );
+
+	/*! Finds the closest visible shape intersected by the ray (p1,p2), considering
+		only intersections after p1. Models are tested at the triangle level, and other
+		shapes by their local bounding boxes. Returns false if nothing is hit. */
+	bool pick ( const GsLine& ray, Hit& hit ) const;
+
+	/*! Appends to shapes all shapes with global bounding boxes intersecting b */
+	void overlap ( const GsBox& b, GsArray<SnShape*>& shapes ) const;
+
+	/*! Appends to shapes all shapes with global bounding boxes not entirely outside
+		the view frustum of the full camera matrix m, see GsBvh::frustum() */
+	void frustum ( const GsMat& m, GsArray<SnShape*>& shapes ) const;
+
+	/*! Same as the other frustum() method but appending the indices of the instances,
+		which follow the traversal order of the visible shapes in the scene graph */
+	void frustum ( const GsMat& m, GsArray<int>& instances ) const { _top.frustum(m,instances); }
+
+	/*! Returns the global bounding box of the scene, without traversing it */
+	GsBox box () const { return _top.box(); }
+
+	/*! Returns the number of instances */
+	int instances () const { return _inst.size(); }
+
+	/*! Returns the shape of instance i */
+	SnShape* shape ( int i ) const { return _inst[i].shape; }
+
+	/*! Returns the global matrix of instance i */
+	const GsMat& matrix ( int i ) const { return _inst[i].mat; }
+
+	/*! Returns the global bounding box of instance i */
+	const GsBox& box ( int i ) const { return _boxes[i]; }
+
+	/*! Returns the number of distinct models with triangle hierarchies */
+	int meshes () const { return _meshes.size(); }
+
+   private : // virtual methods
+	virtual bool shape_apply ( SnShape* s ) override;
+	virtual bool editor_apply ( SnEditor* e ) override;
+};
+
+//================================ End of File =================================================
+
+# endif  // SA_BVH_H
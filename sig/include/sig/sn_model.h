@@ -13,6 +13,7 @@
  */
 
 # include <sig/gs_model.h>
+# include <sig/gs_model_lod.h>
 # include <sig/sn_shape.h>
 
 /*! \class SnModel sn_model.h
@@ -23,10 +24,12 @@
 	For simplicity, the OpenGL calls are not optimized to use buffers, 
 	if higher performance is required, for example for deformable meshes,
 	a specialized node rendered with OpenGL buffers from specific mesh formats
-	can be defined. */
+	can be defined. In the level of detail mode, the model rendered at each frame is
+	selected from a GsModelLod according to its projected size, see lod(). */
 class SnModel : public SnShape
  { protected :
 	GsModel* _model;
+	GsModelLod* _lod; // levels of detail, or null
 
    public :
 	static const char* class_name; //<! Contains string SnModel
@@ -58,6 +61,15 @@ class SnModel : public SnShape
 	/*! Const access to the (always valid) shared GsModel. No call to touch() */
 	const GsModel* cmodel () const { return _model; }
 
+	/*! Turns on the level of detail mode with the given referenced chain, which also
+		becomes the model of the node, or turns it off if null is given. Bounding boxes,
+		picking and all other queries consider the model of the node. The level rendered
+		is selected at every frame by the renderer with GsModelLod::select(). */
+	void lod ( GsModelLod* l );
+
+	/*! Returns the levels of detail, or null if the mode is off */
+	GsModelLod* lod () const { return _lod; }
+
 	/*! Returns the bounding box of all vertices used.
 		The returned box can be empty. */
 	virtual void get_bounding_box ( GsBox &b ) const override;
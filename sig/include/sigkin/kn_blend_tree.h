@@ -0,0 +1,222 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_BLEND_TREE_H
+# define KN_BLEND_TREE_H
+
+/** \file kn_blend_tree.h
+ * Posture blend trees */
+
+# include <sig/gs_array.h>
+# include <sig/gs_shareable.h>
+# include <sigkin/kn_channels.h>
+
+class KnJoint;
+class KnPosture;
+
+//================================ KnBlendMask =================================================
+
+/*! A mask assigns a weight in [0,1] to each float of the values of a channel
+	array, and is used by KnBlendLayer to restrict a layer to some joints. */
+class KnBlendMask : public GsShareable
+{  private :
+	KnChannels* _channels;
+	GsArray<float> _w;
+
+   public :
+	/*! Constructor for the given channels, which are referenced, with all weights set to w */
+	KnBlendMask ( KnChannels* ch, float w=0 );
+
+	/*! Destructor. Be sure to access it through unref() when needed. */
+   ~KnBlendMask ();
+
+	/*! Sets all weights to w */
+	void setall ( float w );
+
+	/*! Sets weight w to all channels of the joint with the given name.
+		Returns the number of channels found. */
+	int set ( const char* jname, float w );
+
+	/*! Sets weight w to all channels of joint j, and of all its descendants if
+		subtree is true. Returns the number of channels found. */
+	int set ( KnJoint* j, float w, bool subtree=true );
+
+	/*! Returns the weight of the given float index of the values array */
+	float weight ( int f ) const { return _w[f]; }
+
+	/*! Returns the array of weights, one per float of the values array */
+	const float* weights () const { return _w.pt(); }
+};
+
+//================================ KnBlendNode =================================================
+
+/*! Base class of the nodes of a posture blend tree. All nodes of a tree work
+	on the same channel array, and each node produces an array of channel values
+	in the same layout as KnPosture::values. Quaternions are blended by normalized
+	linear interpolation, and all other channels are blended linearly. The
+	buffers of the nodes are allocated at construction time, and evaluation of
+	a tree does not allocate memory. */
+class KnBlendNode : public GsShareable
+{  public :
+	enum Type { Pose, Space, Layer };
+
+   protected :
+	gscenum _type;
+	KnChannels* _channels;
+	int _floats;			// size of the values array
+	GsArray<int> _quats;	// float index of each quaternion in the values array
+	GsArray<float> _buffer; // values computed by evaluate(), not used by all nodes
+	const float* _values;	// values of the last evaluation
+	KnBlendNode ( Type t, KnChannels* ch );
+
+   public :
+	/*! Destructor. Be sure to access it through unref() when needed. */
+	virtual ~KnBlendNode ();
+
+	/*! Returns the node type */
+	Type type () const { return (Type)_type; }
+
+	/*! Returns the referenced channel array defining the layout of the values */
+	KnChannels* channels () const { return _channels; }
+
+	/*! Returns the number of floats of the values array */
+	int floats () const { return _floats; }
+
+	/*! Evaluates the node and all its inputs; values() is then valid */
+	virtual void evaluate ()=0;
+
+	/*! Returns the values computed in the last call to evaluate() */
+	const float* values () const { return _values; }
+
+	/*! Evaluates the node and copies the result to the values of posture p,
+		which must have the same channels of the node */
+	void evaluate_to ( KnPosture& p );
+
+	/*! Computes out[k] = sum of w[i]*v[i][k] for i in [0,n) and k in [0,size).
+		Four inputs are accumulated per pass, using SSE instructions if GS_SSE is defined. */
+	static void wsum ( const float* const* v, const float* w, int n, int size, float* out );
+
+	/*! Normalizes the nq quaternions starting at the float indices qpos in v */
+	static void normalize_quats ( float* v, const int* qpos, int nq );
+};
+
+//================================ KnBlendPose =================================================
+
+/*! Leaf node giving the values of a posture, which are not copied. */
+class KnBlendPose : public KnBlendNode
+{  private :
+	KnPosture* _posture;
+
+   public :
+	/*! Constructor referencing posture p, the channels of the node are the ones of p */
+	KnBlendPose ( KnPosture* p );
+
+	/*! Destructor */
+   ~KnBlendPose ();
+
+	/*! Changes the referenced posture, which must have the same channels */
+	void posture ( KnPosture* p );
+
+	/*! Returns the referenced posture */
+	KnPosture* posture () const { return _posture; }
+
+	virtual void evaluate ();
+};
+
+//================================ KnBlendSpace =================================================
+
+/*! N-way weighted blend of its inputs, as needed by blend spaces with many
+	samples. Weights are not normalized and inputs with zero weight are not evaluated.
+	Quaternions are brought to the hemisphere of the first evaluated input before
+	being summed, and the results are then normalized. */
+class KnBlendSpace : public KnBlendNode
+{  private :
+	GsArray<KnBlendNode*> _inputs;
+	GsArray<float> _weights;
+	GsArray<const float*> _ev;	// values of the evaluated inputs
+	GsArray<float> _evw;		// weights of the evaluated inputs
+
+   public :
+	/*! Constructor with no inputs */
+	KnBlendSpace ( KnChannels* ch );
+
+	/*! Destructor unreferences the inputs */
+   ~KnBlendSpace ();
+
+	/*! Adds and references an input with the given weight. Returns its index. */
+	int add ( KnBlendNode* n, float w=0 );
+
+	/*! Number of inputs */
+	int inputs () const { return _inputs.size(); }
+
+	/*! Returns input i */
+	KnBlendNode* input ( int i ) const { return _inputs[i]; }
+
+	/*! Sets the weight of input i */
+	void weight ( int i, float w ) { _weights[i]=w; }
+
+	/*! Returns the weight of input i */
+	float weight ( int i ) const { return _weights[i]; }
+
+	/*! Sets all the weights from the given array of inputs() floats */
+	void weights ( const float* w );
+
+	/*! Scales the weights so that they sum to 1, if their sum is not zero */
+	void normalize_weights ();
+
+	virtual void evaluate ();
+};
+
+//================================ KnBlendLayer =================================================
+
+/*! Combines a layer on top of a base node, with a global weight and an optional mask.
+	In Override mode the result moves from the base values towards the layer values.
+	In Additive mode the difference between the layer and a reference node is added
+	to the base; for quaternions the difference is the rotation taking the reference
+	to the layer, which is applied after the base rotation. If no reference is given
+	the layer values are themselves taken as the differences. */
+class KnBlendLayer : public KnBlendNode
+{  public :
+	enum Mode { Override, Additive };
+
+   private :
+	gscenum _mode;
+	KnBlendNode* _base;
+	KnBlendNode* _layer;
+	KnBlendNode* _reference;
+	KnBlendMask* _mask;
+	float _weight;
+
+   public :
+	/*! Constructor referencing all the given nodes and mask, which can be null
+		except for the base and the layer. The initial weight is 1. */
+	KnBlendLayer ( Mode m, KnBlendNode* base, KnBlendNode* layer, KnBlendMask* mask=0, KnBlendNode* reference=0 );
+
+	/*! Destructor unreferences all used objects */
+   ~KnBlendLayer ();
+
+	/*! Returns the blend mode */
+	Mode mode () const { return (Mode)_mode; }
+
+	/*! Sets the global weight of the layer, usually in [0,1] */
+	void weight ( float w ) { _weight=w; }
+
+	/*! Returns the global weight of the layer */
+	float weight () const { return _weight; }
+
+	/*! Changes the mask, which can be null */
+	void mask ( KnBlendMask* m );
+
+	/*! Returns the mask, can be null */
+	KnBlendMask* mask () const { return _mask; }
+
+	virtual void evaluate ();
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_BLEND_TREE_H
@@ -137,7 +137,7 @@ class KnIk : public GsShareable
 		The result is the same as _base->gmat(), after calling _base->init_rot(),
 		but we dont change any joint values here.
 		Global matrices are required to be up to date, see update_base_up(). */
-	void base_frame ( GsMat& bframe );
+	void base_frame ( GsMat& bframe ) const;
 
 	/*! Transforms the goal matrix in global coordinates to local coordinates with:
 		local = goal * base_frame().inverse(); */
@@ -146,6 +146,11 @@ class KnIk : public GsShareable
 	/*! Returns the length of the base-end linkage in maximum extension */
 	float linkage_len ();
 
+	/*! Computes the linkage lengths and brings the joint parameterizations used by
+		the limit tests in sync, so that the const solve() can afterwards be called
+		from several threads without any lazy update happening inside the calls. */
+	void prepare_concurrent_solve ();
+
 	/*! If true (default) the 6DOF pos/orientation are considered as goal in
 		solve() methods. If set to false only the position is solved */
 	void solve_rot_goal ( bool b ) { _solve_rot_goal=b; }
@@ -170,6 +175,12 @@ class KnIk : public GsShareable
 		Use apply_last_result() to apply the values to the skeleton.
 		Make sure the global matrices are up to date. */
 	Result solve ( const GsMat& goal, float oang );
+
+	/*! Same as solve(goal,oang) but the 7 values found are stored in the given array
+		instead of in last_result(), and no lines are drawn. This version changes
+		neither KnIk nor the skeleton, and can be called concurrently from several
+		threads as long as the skeleton is not modified at the same time. */
+	Result solve ( const GsMat& goal, float oang, float values[7] ) const;
 	
 	/*! If coldet is null, this method is the same as the prior solve() method,
 		except that **this method always call apply_last_result() in case of success**.
@@ -225,6 +236,10 @@ class KnIk : public GsShareable
 	/*! Configures local parameterizations and pre/post frames as expected by the IK
 		solver with the typical recommended settings for the given linkage type. */
 	static bool configure_skeleton ( KnJoint* e, Type t );
+
+   private :
+	void _lengths ( float& d1, float& d2 ) const;
+	Result _solve ( const GsMat& goal, float oang, float* res, bool draw ) const;
 };
 
 /*! This structure provides the parameters used for the automatic orbit angle search
@@ -0,0 +1,107 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_IK_BATCH_H
+# define KN_IK_BATCH_H
+
+# include <sig/gs_array.h>
+# include <sigkin/kn_ik.h>
+
+class KnIkBody;
+class GsThreadPool;
+
+//==================================== KnIkBatch ===================================
+
+/*! Solves many analytical IK problems at once, for example the legs of all
+	characters of a crowd, using a thread pool. Goals are collected with the add()
+	methods and solved with solve(), which does not modify any skeleton: each
+	solution is kept in the batch until commit() applies the successful ones.
+	When the orbit search is requested, all candidate orbit angles of the search
+	are also evaluated in parallel, and the selected angle is the same one the
+	serial search in KnIk::solve(goal,osearch) would find. Collisions are not
+	considered. Several limbs of a same skeleton can be added to a batch as long
+	as they do not share joints. */
+class KnIkBatch : public GsShareable
+{  private :
+	struct Item
+	{	KnIk* ik;			// solver, referenced while in the batch
+		GsMat globgoal;		// goal in global coordinates
+		GsMat goal;			// goal in local coordinates, computed in solve()
+		KnIkOrbitSearch os;	// search parameters, os.init is the orbit angle to use
+		gscbool search;		// if the orbit search is active
+		KnIk::Result result;
+		float values[7];
+	};
+	struct Candidate
+	{	int item;			// index of the item
+		float oang;			// orbit angle to test
+		KnIk::Result result;
+		float values[7];
+	};
+	GsArray<Item> _items;
+	GsArray<Candidate> _cands;
+	GsArray<int> _first;		// index of the first candidate of each item
+	GsThreadPool* _pool;		// pool used by solve(), null to use the shared pool
+	static void _solve_item ( int i, int slot, void* udata );
+	static void _solve_cand ( int i, int slot, void* udata );
+
+   public :
+	/*! Constructor with an empty batch */
+	KnIkBatch ();
+
+	/*! Destructor unreferences the solvers in the batch */
+	virtual ~KnIkBatch ();
+
+	/*! Sets the thread pool to be used by solve(); if null (the default)
+		GsThreadPool::shared() is used. The pool is not deleted by KnIkBatch. */
+	void pool ( GsThreadPool* p ) { _pool=p; }
+
+	/*! Removes all entries from the batch */
+	void init ();
+
+	/*! Number of entries in the batch */
+	int size () const { return _items.size(); }
+
+	/*! Adds a goal in global coordinates to be solved with the fixed orbit angle oang.
+		The index of the new entry is returned. */
+	int add ( KnIk* ik, const GsMat& globgoal, float oang );
+
+	/*! Adds a goal in global coordinates to be solved with the orbit angle search
+		defined by osearch. The index of the new entry is returned. */
+	int add ( KnIk* ik, const GsMat& globgoal, const KnIkOrbitSearch& osearch );
+
+	/*! Adds a goal for the i-th ik of a KnIkBody using its orbit search settings,
+		as in KnIkBody::solve(i,globgoal). Returns the index of the new entry, or -1
+		if the body has no ik of index i. */
+	int add ( KnIkBody* body, int i, const GsMat& globgoal );
+
+	/*! Solves all entries in parallel. Global goals are transformed to local
+		coordinates here, updating first the global matrices of the involved
+		skeletons if needed; no other changes are made to the skeletons.
+		Returns the number of entries solved with result KnIk::Ok. */
+	int solve ();
+
+	/*! Applies to the skeletons the values of all entries solved with success
+		in the last call to solve(). */
+	void commit ();
+
+	/*! Result of entry k after solve() */
+	KnIk::Result result ( int k ) const { return _items[k].result; }
+
+	/*! The 7 values found for entry k, in the same format as KnIk::last_result() */
+	const float* values ( int k ) const { return _items[k].values; }
+
+	/*! Orbit angle of the solution of entry k, or the last one tested if not solved */
+	float oangle ( int k ) const { return _items[k].os.oangle; }
+
+	/*! Number of orbit angles tested for entry k, as in KnIkOrbitSearch::iterations */
+	int iterations ( int k ) const { return _items[k].os.iterations; }
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_IK_BATCH_H
@@ -76,7 +76,7 @@ class KnIkBody : public GsShareable
 	/*! If orbit search is not activated, osearch(i).init is used as the
 		requested, fixed, orbit angle */
 	void osearch_activation ( int i, bool b ) { _osearch_active[i]=b?1:0; }
-	bool osearch_activation ( int i );
+	bool osearch_activation ( int i ) const { return _osearch_active[i]==1; }
 
 	/*! Declares the coldet to be considered, which must be connected to the used skeleton.
 		Null can be set in case no collision detection is to be used */
@@ -0,0 +1,146 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_IK_CHAIN_H
+# define KN_IK_CHAIN_H
+
+# include <sig/gs_matn.h>
+# include <sig/gs_quat.h>
+# include <sig/gs_array.h>
+# include <sigkin/kn_ik.h>
+
+//==================================== KnIkChain ===================================
+
+/*! Iterative IK solver for joint chains of any length, such as spines, tails and
+	robot arms. Two methods are available: damped least squares (DLS) over the chain
+	Jacobian, and FABRIK. Each joint is treated as a 3-DOF rotation; frozen joints
+	are kept fixed by DLS, and joint limits are enforced when results are applied.
+	The solver works on its own copy of the chain rotations, which is kept between
+	calls so that each solve is warm-started from the previous result. The skeleton
+	is only changed when apply() is called.
+	All buffers are allocated in init(), solve() does not allocate memory. */
+class KnIkChain : public GsShareable
+{  public :
+	enum Method { DampedLS, Fabrik };
+
+   private :
+	GsArray<KnJoint*> _joints;	// chain joints from base to end
+	GsArray<GsQuat> _lq;		// local (full) rotations being solved, kept for warm start
+	GsArray<GsVec> _lt;			// local translations (offset plus translation values)
+	GsArray<GsQuat> _gq;		// global rotations computed in the last fk pass
+	GsArray<GsPnt> _gp;			// global positions computed in the last fk pass
+	GsArray<GsPnt> _fp;			// fabrik point buffer
+	GsArray<float> _fd;			// fabrik link lengths
+	GsMatn _jac, _jjt;			// dls jacobian and damped normal matrix
+	GsMatn _err;				// dls error vector
+	GsQuat _pq;					// global rotation of the base parent
+	GsPnt _pp;					// global position of the base parent
+	GsVec _tip;					// end effector offset in the end joint frame
+	gscenum _method;			// current Method
+	gscbool _warmstart;			// if false values are read from the skeleton in each solve
+	gscbool _synced;			// true if _lq holds valid values
+	int _maxit;					// maximum number of iterations
+	int _iterations;			// iterations performed in the last solve
+	float _postol, _rottol;		// convergence tolerances
+	float _damping;				// dls damping factor
+	float _maxstep;				// dls maximum angle change per joint per iteration
+	float _error;				// final position error of the last solve
+	void _init ();				// private init method
+
+   public :
+	/*! Constructor sets default parameters; init() must be called before solving */
+	KnIkChain ();
+
+	/*! Constructor that calls init(base,end) */
+	KnIkChain ( KnJoint* base, KnJoint* end );
+
+	/*! Destructor */
+	virtual ~KnIkChain ();
+
+	/*! Initializes the chain with all joints from base to end. The base joint must
+		be an ancestor of the end joint, or the end joint itself. Internal buffers are
+		allocated here. Returns false if the joints do not define a valid chain. */
+	bool init ( KnJoint* base, KnJoint* end );
+
+	/*! Number of joints in the chain */
+	int size () const { return _joints.size(); }
+
+	/*! Access the i-th joint of the chain, where 0 is the base joint */
+	KnJoint* joint ( int i ) const { return _joints[i]; }
+
+	KnJoint* base () const { return _joints.size()? _joints[0]:0; } //<! Returns the base joint or null
+	KnJoint* end () const { return _joints.size()? _joints.top():0; } //<! Returns the end joint or null
+
+	/*! Sets the method used by solve(), default is DampedLS */
+	void method ( Method m ) { _method=(gscenum)m; }
+	Method method () const { return (Method)_method; }
+
+	/*! Offset of the end effector in the frame of the end joint, default is (0,0,0) */
+	void tip ( const GsVec& t ) { _tip=t; }
+	const GsVec& tip () const { return _tip; }
+
+	/*! Maximum number of iterations per solve, default is 32 */
+	void max_iterations ( int i ) { _maxit=i; }
+	int max_iterations () const { return _maxit; }
+
+	/*! Position and orientation (in radians) tolerances used for early termination.
+		Defaults are 0.001 and 0.005. */
+	void tolerance ( float postol, float rottol ) { _postol=postol; _rottol=rottol; }
+
+	/*! Damping factor used by the DLS method, default is 0.1. Larger values give more
+		stable solutions near singularities but slower convergence. */
+	void damping ( float d ) { _damping=d; }
+	float damping () const { return _damping; }
+
+	/*! Maximum rotation in radians a joint may receive in one DLS iteration, default is 0.2 */
+	void max_step ( float s ) { _maxstep=s; }
+
+	/*! If true (the default) each solve starts from the values of the previous solve.
+		Otherwise the current skeleton values are taken as starting point in each call. */
+	void warmstart ( bool b ) { _warmstart=b; }
+	bool warmstart () const { return _warmstart==1; }
+
+	/*! Copies the current skeleton values to the internal solver state */
+	void sync ();
+
+	/*! Solves for the given end effector position in global coordinates.
+		The global matrix of the parent of the base joint must be up to date.
+		Returns KnIk::Ok if the goal was reached within tolerance, KnIk::NotReachable
+		if the closest solution found was kept, or KnIk::Undef if not initialized. */
+	KnIk::Result solve ( const GsPnt& p );
+
+	/*! Solves for the given end effector position and orientation in global coordinates.
+		With the Fabrik method the orientation is imposed to the end joint after
+		solving for the position of the end joint, which is placed to let the tip
+		reach the goal. */
+	KnIk::Result solve ( const GsPnt& p, const GsQuat& q );
+
+	/*! Number of iterations performed in the last solve */
+	int iterations () const { return _iterations; }
+
+	/*! Final distance between the end effector and the goal in the last solve */
+	float error () const { return _error; }
+
+	/*! Returns the local rotation of the i-th joint found by the last solve */
+	const GsQuat& result ( int i ) const { return _lq[i]; }
+
+	/*! Applies the last solution to the skeleton joints. Joint limits of the
+		Euler and Swing-Twist parameterizations are enforced here, and the
+		internal state is updated with the values that were accepted. */
+	void apply ();
+
+   protected :
+	void _fk ();
+	void _readparent ();
+	bool _converged ( const GsPnt& p, const GsQuat* q, GsVec& perr, GsVec& rerr );
+	KnIk::Result _solve_dls ( const GsPnt& p, const GsQuat* q );
+	KnIk::Result _solve_fabrik ( const GsPnt& p, const GsQuat* q );
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_IK_CHAIN_H
@@ -38,10 +38,11 @@ class KnJoint
 	GsModel* _visgeo;		// the attached geometry to visualize this joint
 	GsModel* _colgeo;		// the attached geometry used for collision detection
 	KnJoint* _parent;		// the parent joint
-	GsArray<KnJoint*> _children; // the children joints
+	GsSmallArray<KnJoint*,3> _children; // the children joints, most joints have up to 3
 	GsMat _gmat;			// global matrix: from the root to the children of this joint
 	GsMat _lmat;			// local matrix: from this joint to its children
 	gscbool _lmattodate;	// true if lmat is up to date
+	gsuint64 _changes;		// value of KnSkeleton::changes() at the last lmat change
 	gscenum _rtype;			// one of the RotType enumerator
 	KnJointName _name;		// the given name
 	int   _index;			// its index in KnSkeleton::_joints
@@ -190,9 +191,14 @@ class KnJoint
 
 	/*! Will force the reconstruction of the local matrix from the
 		rotation and position parameters. The skeleton is also notified
-		with a call to invalidate_global_matrices() */
+		with a call to invalidate_global_matrices(), and the change is recorded
+		in the skeleton change counter (see KnSkeleton::changes()) */
 	void set_lmat_changed ();
 
+	/*! Returns the value of KnSkeleton::changes() when the local matrix of this
+		joint was last changed, or 0 if it was never changed */
+	gsuint64 changes () const { return _changes; }
+
 	/*! Returns the current global matrix. Be sure that it is up to
 		date by calling one of the several updated methods. It gives
 		the transformation from the root to the children of this joint */
@@ -8,7 +8,7 @@
 # ifndef KN_JOINT_NAME_H
 # define KN_JOINT_NAME_H
 
-# include <sig/gs_table.h>
+# include <sig/gs_hash_table.h>
 
 /*! KnJointName contains only one integer id, which is the id of
 	a name stored in a globally defined hash table.
@@ -19,7 +19,7 @@ class KnJointName
  { private :
 	gsword _id; // the id of this joint name (max is 65535, see gs.h)
 	static gsword _undefid; // to mark undefined ids (mark is max gsword value)
-	static GsTable<long> _htable;
+	static GsHashTable<long> _htable;
 
    public :
 
@@ -71,7 +71,7 @@ class KnJointName
 	static const char* st ( gsword id ) { return id==_undefid? "":_htable.key(id); }
 
    private :
-	void _check () { if ( _htable.hashsize()==0 ) _htable.init(256); }
+	void _check () { if ( _htable.hashsize()==0 ) _htable.init(256,GsHashTableBase::InternedKeys); }
 };
 
 //==================================== End of File ===========================================
@@ -0,0 +1,170 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_MOTION_GRAPH_H
+# define KN_MOTION_GRAPH_H
+
+# include <sig/gs_array.h>
+# include <sig/gs_graph.h>
+# include <sig/gs_shareable.h>
+
+class KnJoint;
+class KnMotion;
+class KnSkeleton;
+class GsThreadPool;
+
+//================================== KnMgNode / KnMgLink =====================================
+
+class KnMgNode;
+
+/*! A link of the motion graph: either the playback of a clip from the frame of its
+	source node to the frame of its target node, or a transition between two clips */
+class KnMgLink : public GsGraphLink
+{  public :
+	float dist;			// transition distance, or -1 for a clip segment
+   public :
+	GS_GRAPH_LINK_CASTED_METHODS(KnMgNode,KnMgLink);
+	KnMgLink () { dist=-1; }
+	KnMgLink ( const KnMgLink& l ) : GsGraphLink(), dist(l.dist) {}
+   ~KnMgLink () {}
+	bool transition () const { return dist>=0; }
+	friend GsOutput& operator<< ( GsOutput& out, const KnMgLink& l ) { return out<<l.dist; }
+	friend GsInput& operator>> ( GsInput& inp, KnMgLink& l ) { return inp>>l.dist; }
+	static inline int compare ( const KnMgLink* /*l1*/, const KnMgLink* /*l2*/ ) { return 0; }
+};
+
+/*! A node of the motion graph, which is a frame of a clip where transitions start or end */
+class KnMgNode : public GsGraphNode
+{  public :
+	int motion;			// index of the clip in KnMotionGraph
+	int frame;			// frame in the clip
+	int id;				// index of the node in KnMotionGraph::node()
+   public :
+	GS_GRAPH_NODE_CASTED_METHODS(KnMgNode,KnMgLink);
+	KnMgNode () : GsGraphNode() { motion=frame=id=-1; }
+	KnMgNode ( const KnMgNode& n ) : GsGraphNode(), motion(n.motion), frame(n.frame), id(n.id) {}
+   ~KnMgNode () {}
+	friend GsOutput& operator<< ( GsOutput& out, const KnMgNode& n ) { return out<<n.motion<<gspc<<n.frame; }
+	friend GsInput& operator>> ( GsInput& inp, KnMgNode& n ) { return inp>>n.motion>>n.frame; }
+	static inline int compare ( const KnMgNode* /*n1*/, const KnMgNode* /*n2*/ ) { return 0; }
+};
+
+//================================== KnMotionGraph =====================================
+
+/*! Builds a motion graph connecting clips of a same skeleton with transitions at
+	similar frames. The features of a frame are the positions of the feature joints in
+	the character frame of the root (the root position projected on the floor and its
+	heading), so that the distance does not depend on where the clips are performed.
+	The distance between two frames is the root mean square distance between their
+	feature joints over a window of frames starting at them, divided by the average
+	distance of the feature joints to the root over all frames, so that thresholds do
+	not depend on the size of the character.
+
+	build() computes the distance matrix between all frames in tiles processed in
+	parallel, never storing the whole matrix, and keeps as transitions the local minima
+	below the threshold. Forward kinematics is done only once per frame. The graph
+	then has nodes at the first and last frames of each clip and at the ends of all
+	transitions, links along each clip with cost equal to their duration in seconds,
+	and transition links with cost equal to their distance times the transition weight. */
+class KnMotionGraph : public GsShareable
+{  public :
+	struct Transition { int m1, f1, m2, f2; float dist; }; //!< from frame f1 of clip m1 to frame f2 of clip m2
+
+   private :
+	KnSkeleton* _sk;
+	GsArray<KnMotion*> _motions;
+	GsArray<KnJoint*> _fjoints;
+	GsArray<int> _first;		// first global frame of each clip, plus the total at the end
+	GsArray<float> _feat;		// features of all frames
+	GsArray<int> _clip;			// clip of each global frame
+	GsArray<Transition> _trans;
+	GsArray<KnMgNode*> _nodes;
+	GsArray<int> _nfirst;		// first node of each clip, plus the number of nodes at the end
+	GsGraph<KnMgNode,KnMgLink> _graph;
+	GsThreadPool* _pool;
+	int _window, _mingap, _tile, _dim;
+	float _threshold, _tweight;
+	void _extract ();
+	void _make_graph ();
+	float _wdist ( int a, int b ) const;
+	friend struct KnMgTileJob;
+
+   public :
+	/*! Constructor for clips of skeleton sk, which is referenced */
+	KnMotionGraph ( KnSkeleton* sk );
+
+	/*! Destructor unreferences the skeleton and the clips */
+	virtual ~KnMotionGraph ();
+
+	/*! Removes all clips, transitions and the graph; parameters are kept */
+	void init ();
+
+	/*! The skeleton of the clips */
+	KnSkeleton* skeleton () const { return _sk; }
+
+	/*! Adds a joint to be compared. If none are given all joints are used. */
+	void add_feature_joint ( KnJoint* j ) { _fjoints.push()=j; }
+
+	/*! Adds a clip, which is referenced. Returns its index. */
+	int add_motion ( KnMotion* m );
+
+	/*! Number of clips */
+	int motions () const { return _motions.size(); }
+
+	/*! Access clip i */
+	KnMotion* motion ( int i ) const { return _motions[i]; }
+
+	/*! Number of frames compared by the distance function, default is 5 */
+	void window ( int w ) { _window=w>0? w:1; }
+
+	/*! Distance below which local minima become transitions, default is 0.1 */
+	void threshold ( float t ) { _threshold=t; }
+
+	/*! Minimum number of frames between the ends of a transition in a same clip, default is 15 */
+	void min_gap ( int g ) { _mingap=g; }
+
+	/*! Multiplies the transition distances to give their costs in the graph, default is 1 */
+	void transition_weight ( float w ) { _tweight=w; }
+
+	/*! Sets the thread pool used by build(); if null (the default) GsThreadPool::shared()
+		is used. The pool is not deleted by KnMotionGraph. */
+	void pool ( GsThreadPool* p ) { _pool=p; }
+
+	/*! Computes the transitions between all added clips and builds the graph,
+		replacing the previous one. Returns the number of transitions. */
+	int build ();
+
+	/*! Distance between frame f1 of clip m1 and frame f2 of clip m2 as used by build(),
+		or -1 if a window starting at one of them does not fit in its clip */
+	float distance ( int m1, int f1, int m2, int f2 ) const;
+
+	/*! Transitions found by build() */
+	const GsArray<Transition>& transitions () const { return _trans; }
+
+	/*! The graph */
+	GsGraph<KnMgNode,KnMgLink>& graph () { return _graph; }
+
+	/*! Number of nodes */
+	int nodes () const { return _nodes.size(); }
+
+	/*! Access node i, the nodes of each clip are consecutive and in frame order */
+	KnMgNode* node ( int i ) const { return _nodes[i]; }
+
+	/*! Returns the node at frame f of clip m, or null if there is none */
+	KnMgNode* node ( int m, int f ) const;
+
+	/*! Searches for the path with lowest cost from node start to a node for which
+		goal(node,udata) returns true. Path receives the nodes from start to the goal
+		node, and true is returned if found. If maxcost>0 paths with larger costs
+		are not considered. If cost is given it receives the cost of the found path. */
+	bool search ( KnMgNode* start, bool (*goal)(const KnMgNode*,void*), void* udata,
+				  GsArray<KnMgNode*>& path, float* cost=0, float maxcost=-1 );
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_MOTION_GRAPH_H
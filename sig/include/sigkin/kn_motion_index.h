@@ -0,0 +1,136 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_MOTION_INDEX_H
+# define KN_MOTION_INDEX_H
+
+# include <sig/gs_array.h>
+# include <sig/gs_shareable.h>
+
+class KnJoint;
+class KnMotion;
+class KnSkeleton;
+
+//================================== KnMotionIndex =====================================
+
+/*! Search index for motion matching over a set of motions of a same skeleton.
+	Features are extracted once for every frame of the indexed motions, and queries
+	for the frame most similar to a given feature vector are answered with a kd-tree,
+	without posture applications or forward kinematics.
+
+	The features of a frame are expressed in the character frame of the root joint,
+	which is the root position projected on the floor (y=0) and rotated about the Y
+	axis to the root heading (the Z axis of the root projected on the floor).
+	For each feature joint they are its position and velocity, followed, for each
+	trajectory time, by the future root position (x,z) and heading direction (x,z)
+	at that time ahead. Each group of values is divided by its standard deviation
+	over all frames and multiplied by its weight, so that groups are comparable.
+	Euclidian distances between these normalized vectors are the matching costs. */
+class KnMotionIndex : public GsShareable
+{  public :
+	struct Entry { int motion; int frame; }; //!< the motion and frame of an indexed feature vector
+
+   private :
+	struct Node { float split; int dim; int a, b; }; // children a,b, or rows [a,b) for leaves (dim<0)
+	KnSkeleton* _sk;
+	GsArray<KnJoint*> _fjoints;
+	GsArray<float> _ttimes;
+	float _wpos, _wvel, _wtraj;
+	GsArray<KnMotion*> _motions;
+	GsArray<int> _first;		// first entry of each motion
+	GsArray<Entry> _entries;
+	GsArray<float> _raw;		// raw features of all entries
+	GsArray<float> _features;	// normalized features of all entries, in kd-tree order
+	GsArray<int> _order;		// entry index of each row in _features
+	GsArray<int> _row;			// row in _features of each entry
+	GsArray<float> _scale;		// normalization scale per dimension
+	GsArray<Node> _nodes;
+	int _dim;
+	int _build ( int i1, int i2 );
+	void _search ( int n, const float* q, int& best, float& bestd2 ) const;
+
+   public :
+	/*! Constructor for indexing motions of skeleton sk, which is referenced */
+	KnMotionIndex ( KnSkeleton* sk );
+
+	/*! Destructor unreferences the skeleton and the motions */
+	virtual ~KnMotionIndex ();
+
+	/*! Removes all motions, features and joints; the weights and times are kept */
+	void init ();
+
+	/*! The skeleton of the indexed motions */
+	KnSkeleton* skeleton () const { return _sk; }
+
+	/*! Adds a joint whose position and velocity are features. If no feature joints are
+		given, the leaf joints of the skeleton are used. Must be called before add_motion(). */
+	void add_feature_joint ( KnJoint* j ) { _fjoints.push()=j; }
+
+	/*! Feature joints, which are defined by the first added motion if none were given */
+	const GsArray<KnJoint*>& feature_joints () const { return _fjoints; }
+
+	/*! Times in seconds ahead of each frame where the root trajectory is sampled.
+		The default is 0.2, 0.4 and 0.6. Must be called before add_motion(). */
+	void trajectory_times ( const GsArray<float>& t ) { _ttimes=t; }
+
+	/*! Weights of the position, velocity and trajectory feature groups, with default 1.
+		They take effect in the next call to build(). */
+	void weights ( float pos, float vel, float traj ) { _wpos=pos; _wvel=vel; _wtraj=traj; }
+
+	/*! Extracts the features of all frames of m, which must be a motion for the indexed
+		skeleton and is referenced. The motion is connected to the skeleton, and the skeleton
+		is left in the posture of the last frame. Returns the motion index in this index. */
+	int add_motion ( KnMotion* m );
+
+	/*! Number of motions */
+	int motions () const { return _motions.size(); }
+
+	/*! Access motion i */
+	KnMotion* motion ( int i ) const { return _motions[i]; }
+
+	/*! Computes the normalization of all features and builds the kd-tree.
+		Must be called after adding motions and before searching. */
+	void build ();
+
+	/*! Number of features per frame */
+	int dimension () const { return _dim; }
+
+	/*! Number of indexed frames */
+	int entries () const { return _entries.size(); }
+
+	/*! Motion and frame of entry e */
+	const Entry& entry ( int e ) const { return _entries[e]; }
+
+	/*! Raw (not normalized) features of entry e, with dimension() values */
+	const float* raw_features ( int e ) const { return &_raw[e*_dim]; }
+
+	/*! Normalized features of entry e, available after build() */
+	const float* features ( int e ) const { return &_features[_row[e]*_dim]; }
+
+	/*! Returns the entry of frame f of motion m */
+	int entry ( int m, int f ) const { return _first[m]+f; }
+
+	/*! Position in the feature vectors of the trajectory features, which come last.
+		Queries are usually the raw features of the current frame with the trajectory
+		features replaced by the desired trajectory, and then normalized. */
+	int trajectory_offset () const { return _fjoints.size()*6; }
+
+	/*! Normalizes raw features in place, as done for the indexed frames by build() */
+	void normalize ( float* feat ) const;
+
+	/*! Returns the entry whose normalized features are the nearest to the given normalized
+		query vector, or -1 if the index is empty. If d is given it receives the distance. */
+	int search ( const float* query, float* d=0 ) const;
+
+	/*! Same as search() but with a linear search over all entries, for verification
+		and for very small indices. */
+	int search_linear ( const float* query, float* d=0 ) const;
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_MOTION_INDEX_H
@@ -0,0 +1,80 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_RIG_BUILDER_H
+# define KN_RIG_BUILDER_H
+
+# include <sig/gs_array.h>
+# include <sig/gs_mat.h>
+# include <sigkin/kn_joint.h>
+
+class GsModel;
+class SnNode;
+class KnSkeleton;
+
+//==================================== KnRigBuilder ===================================
+
+/*! Converts a hierarchy of rigid parts, for example models placed with one SnManipulator
+	each and animated by composing their matrices, into a KnSkeleton with one joint per
+	part and the geometry of each part as the visualization geometry of its joint.
+	The whole hierarchy is then posed with one KnPosture::apply() and one update of the
+	global matrices, and it can be displayed with a KnScene.
+	Each part has a pivot, the point in global coordinates around which the part rotates,
+	which becomes the joint center. The parts are given in their rest placement, which
+	becomes the skeleton posture with all rotations equal to zero. */
+class KnRigBuilder
+{  public :
+	struct Part
+	{	char* name;		// joint name, if null "part<i>" is used
+		GsModel* model;	// geometry in global coordinates
+		GsPnt pivot;	// center of rotation in global coordinates
+		int parent;		// index of the parent part, or -1 for the root
+	};
+
+   private :
+	GsArray<Part> _parts;
+
+   public :
+	/*! Constructor with no parts */
+	KnRigBuilder ();
+
+	/*! Destructor unreferences the part models */
+   ~KnRigBuilder ();
+
+	/*! Removes all parts */
+	void init ();
+
+	/*! Number of parts */
+	int parts () const { return _parts.size(); }
+
+	/*! Access to part i */
+	const Part& part ( int i ) const { return _parts[i]; }
+
+	/*! Adds a part with model m placed by mat. A copy of m is transformed by mat and
+		stored. The parent must be a part already added, or -1 for the root part, and only
+		one root part is allowed. Returns the index of the new part, or -1 if the parent is
+		not valid. */
+	int add ( const GsModel* m, const GsMat& mat, int parent, const GsPnt& pivot, const char* name=0 );
+
+	/*! Adds a part with the models found in the scene graph n, for example an SnManipulator,
+		with all the transformations in n applied. Invisible models are skipped.
+		The coordinate system of the parent node of n is taken as the global one, and
+		it should then be the same for all parts. Returns the index of the new part,
+		or -1 if the parent is not valid. */
+	int add ( SnNode* n, int parent, const GsPnt& pivot, const char* name=0 );
+
+	/*! Builds a new skeleton with one joint per part, in the order of the parts, which
+		is also the order of the joints in KnSkeleton::joints(). Rotations of type rtype
+		are activated for all joints, which should be TypeQuat or TypeEuler (the latter
+		with the XYZ order and no limits). If rootpos is true the position channels of the
+		root joint are also activated. Returns null if there are no parts. */
+	KnSkeleton* build ( KnJoint::RotType rtype=KnJoint::TypeQuat, bool rootpos=true ) const;
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_RIG_BUILDER_H
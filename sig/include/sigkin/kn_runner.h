@@ -0,0 +1,136 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef KN_RUNNER_H
+# define KN_RUNNER_H
+
+# include <stdio.h>
+# include <sig/gs_array.h>
+# include <sig/gs_shareable.h>
+
+class KnJoint;
+class KnSkeleton;
+class KnController;
+class KnScene;
+class KnColdet;
+
+//==================================== KnRunner ===================================
+
+/*! Runs the simulation of a skeleton without windows or event processing, at a
+	fixed time step and as fast as possible. Each step evaluates the controller
+	(usually a KnCtScheduler) at time frame*dt, applies its posture to the skeleton,
+	updates the global matrices, the skin, the scene and the collision detection,
+	and writes the state of the frame to a binary trace file if one is open.
+	The same inputs always produce the same trace, which can be used for regression
+	tests with compare_traces() and for measuring the throughput of the simulation.
+
+	The trace has a header with the characters "SIGTRACE", the version number (int),
+	the number of joints n (int), the time step (double), and the names of the n joints,
+	each one as its length (int) followed by its characters. Each frame then has the
+	frame number (int), the time (double), the number of colliding pairs (int) and
+	the n global joint matrices (16 floats each, as in GsMat). Joint positions are
+	the translations of the global matrices. Values use the byte order of the machine. */
+class KnRunner : public GsShareable
+{  public :
+	struct Stats
+	{	int frames;			// number of steps done since the last reset()
+		int colframes;		// number of frames with collisions
+		double time;		// seconds spent in the steps
+	};
+
+   private :
+	KnSkeleton* _sk;
+	KnController* _ctrl;
+	KnScene* _scene;
+	KnColdet* _coldet;
+	FILE* _trace;
+	double _dt;
+	int _frame;
+	gscbool _skin;
+	GsArray<KnJoint*> _pairs;
+	Stats _stats;
+	void (*_cb) ( KnRunner*, void* );
+	void* _udata;
+	void _write_frame ( double t );
+
+   public :
+	/*! Constructor for running the given skeleton, which is referenced, at the given time step */
+	KnRunner ( KnSkeleton* sk, double dt=1.0/60.0 );
+
+	/*! Destructor closes the trace and unreferences the used objects */
+	virtual ~KnRunner ();
+
+	/*! The simulated skeleton */
+	KnSkeleton* skeleton () const { return _sk; }
+
+	/*! Sets the controller to be evaluated at each step, which is connected to the skeleton.
+		The controller is referenced and null can be given to remove the current one. */
+	void controller ( KnController* c );
+
+	/*! The current controller, or null */
+	KnController* controller () const { return _ctrl; }
+
+	/*! Sets a scene graph connected to the skeleton to be updated at each step.
+		The scene is referenced and null can be given to remove the current one. */
+	void scene ( KnScene* s );
+
+	/*! Sets a collision detection manager, to which the skeleton has to be connected,
+		to be checked at each step. It is referenced and null removes the current one. */
+	void coldet ( KnColdet* cd );
+
+	/*! Determines if the skin of the skeleton, if any, is updated at each step.
+		The default is true, and as in KnSkin::update() only visible skins are updated. */
+	void skin ( bool b ) { _skin=b; }
+
+	/*! Changes the time step, which should only be done before the first step */
+	void dt ( double dt ) { _dt=dt; }
+
+	/*! The time step */
+	double dt () const { return _dt; }
+
+	/*! Number of the next frame to be simulated */
+	int frame () const { return _frame; }
+
+	/*! Time of the next frame to be simulated */
+	double time () const { return _frame*_dt; }
+
+	/*! Sets a function to be called after each step, for example to send inputs to
+		the controllers or to check the results */
+	void frame_cb ( void(*cb)(KnRunner*,void*), void* udata ) { _cb=cb; _udata=udata; }
+
+	/*! Colliding pairs found in the last step, as returned by KnColdet::collide() */
+	const GsArray<KnJoint*>& colliding_pairs () const { return _pairs; }
+
+	/*! Statistics since the last reset */
+	const Stats& stats () const { return _stats; }
+
+	/*! Goes back to frame 0 and clears the statistics; the trace is not changed */
+	void reset ();
+
+	/*! Opens the trace file and writes its header, closing any previous trace.
+		Returns false if the file could not be opened. */
+	bool open_trace ( const char* filename );
+
+	/*! Closes the trace file, if open */
+	void close_trace ();
+
+	/*! Simulates one frame. Returns false if the controller became inactive. */
+	bool step ();
+
+	/*! Simulates the given number of frames, or less if the controller becomes inactive
+		and stop is true. Returns the number of simulated frames. */
+	int run ( int frames, bool stop=true );
+
+	/*! Compares two traces, returning -1 if they have the same joints and frames with all
+		matrix values differing by at most toler, the number of the first different frame
+		otherwise, or -2 if the files cannot be read or have different headers. */
+	static int compare_traces ( const char* file1, const char* file2, float toler=0 );
+};
+
+//======================================= EOF =====================================
+
+# endif // KN_RUNNER_H
@@ -25,6 +25,7 @@ class KnScene : public SnGroup
 	GsArray<SnGroup*> _jgroup;
 	float _cradius, _sfactor, _axislen, _avgoffsetlen;
 	KnSkeleton* _skeleton;
+	gsuint64 _changes; // skeleton change counter at the last update
 
    public :
 	/*! Constructor  */
@@ -45,8 +46,10 @@ class KnScene : public SnGroup
 		The skeleton ref()/unref() methods are respected. */
 	virtual void connect ( KnSkeleton* s );
 
-	/*! Update the transformations of the scene graph according
-		to the joints in the skeleton sent to init(). */
+	/*! Update the transformations of the scene graph according to the joints in
+		the skeleton sent to init(). Only the joints with local matrices changed since
+		the last call are updated (see KnSkeleton::changes()), and nothing is done if
+		no joints changed, so that the transformations of idle skeletons are not touched. */
 	virtual void update ();
 
 	/*! Update the scene transformation relative to the given joint index j,
@@ -9,8 +9,9 @@
 # define KN_SKELETON_H
 
 # include <sig/gs_vars.h>
+# include <sig/gs_arena.h>
 # include <sig/gs_dirs.h>
-# include <sig/gs_table.h>
+# include <sig/gs_hash_table.h>
 # include <sig/gs_string.h>
 # include <sig/gs_shareable.h>
 # include <sigkin/kn_joint.h>
@@ -30,9 +31,12 @@ class KnSkeleton : public GsShareable
 	char* _filename;
 	KnJoint* _root;
 	GsArray<KnJoint*> _joints;
-	mutable GsTable<KnJoint*> _jhash;
+	GsArena _arena; // storage of the joints and of their children arrays
+	mutable GsHashTable<KnJoint*> _jhash;
 	bool _gmat_uptodate;
 	bool _enforce_rot_limits;
+	gsuint64 _changes; // counter of local matrix changes, see changes()
+	friend class KnJoint;
 
 	// collision detection:
 	GsArray<KnJoint*> _colfreepairs;
@@ -155,6 +159,13 @@ class KnSkeleton : public GsShareable
 		This method is automatically called each time a joint value is changed */
 	void invalidate_global_matrices ();
 
+	/*! Returns a counter incremented each time the local matrix of a joint is changed,
+		which is never reset. Each joint keeps in KnJoint::changes() the value of this counter
+		at its last change, so that an observer which saved the counter when it last
+		processed the skeleton finds the changed joints as the ones with a greater value,
+		and can skip the whole skeleton if the counter did not change. */
+	gsuint64 changes () const { return _changes; }
+
 	/*! Compress all internal arrays */
 	void compress ();
 
@@ -11,6 +11,7 @@
 //================================ KnSkin ===================================
 
 # include <sig/gs_array.h>
+# include <sig/gs_arena.h>
 # include <sig/sn_model.h>
 
 class SnLines;
@@ -27,6 +28,7 @@ class KnSkin : public SnModel
 	GsArray<SkinVtx> SV;
 	KnSkeleton* skeleton;
 	bool _intn;
+	GsArena _weights; // storage of all weight arrays in SV
 
    public :
 	/*! Constructor  */
@@ -0,0 +1,99 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# ifndef GL_CAPTURE_H
+# define GL_CAPTURE_H
+
+/** \file gl_capture.h
+ * Asynchronous frame capture */
+
+# include <stdio.h>
+# include <sig/gs_string.h>
+
+class GsThreadPool;
+
+//================================= GlCapture ===============================
+
+/*! Captures frames of the current framebuffer without stalling the rendering.
+	Each call to capture() starts a read of the viewport into one of a ring of pixel
+	buffer objects and returns; the pixels are only mapped a few frames later, when
+	the transfer has completed, and are then saved to image files or written to a
+	stream by background tasks. Frames are never dropped: if all buffers are still
+	in flight the oldest one is waited for, and if too many frames wait for encoding
+	capture() blocks until the encoders catch up.
+	All methods except errors() and frames() require the OpenGL context used for
+	the captures to be current. */
+class GlCapture
+{  public :
+	enum Mode { Off, Files, Stream };
+
+   private :
+	struct Data;
+	Data* _data;			// buffer ring and encoding state
+	int _next, _inflight;	// next slot to use and number of slots being transferred
+	Mode _mode;
+	GsString _name, _ext;
+	int _number, _frames;	// number of the next file and frames captured since start
+	FILE* _stream;
+	GsThreadPool* _pool;
+	int _maxpending;
+	void _retrieve ();
+
+   public :
+	/*! Constructor with the number of pixel buffers in the ring, at least 2 */
+	GlCapture ( int buffers=3 );
+
+	/*! Destructor calls finish() */
+   ~GlCapture ();
+
+	/*! Starts saving each captured frame to file name+number+"."+ext, where number
+		has at least 4 digits and starts at first. Ext defines the image format:
+		bmp, tga, or otherwise png. A previous capture is finished first. */
+	void start ( const char* name, const char* ext, int first=1 );
+
+	/*! Starts writing captured frames to s, in order, as raw RGBA pixels from the top
+		row to the bottom row. The stream can be a file or a pipe to an external video
+		encoder, for ex. obtained with popen(), and is not closed by GlCapture.
+		The frame size is the viewport size at each capture. A previous capture is
+		finished first. */
+	void start ( FILE* s );
+
+	/*! Current mode */
+	Mode mode () const { return _mode; }
+
+	/*! Returns true if a capture was started and not finished */
+	bool active () const { return _mode!=Off; }
+
+	/*! Sets the thread pool encoding image files; if null (the default)
+		GsThreadPool::shared() is used. The pool is not deleted by GlCapture, and only
+		the frames of the capture are waited for, not other tasks of the pool.
+		Streams always use an internal thread in order to keep the frame order. */
+	void pool ( GsThreadPool* p ) { _pool=p; }
+
+	/*! Maximum number of frames waiting to be encoded before capture() blocks, default is 8 */
+	void max_pending ( int n ) { _maxpending=n>0? n:1; }
+
+	/*! Starts reading the current viewport of the read buffer, which should be set to
+		GL_BACK before the buffers are swapped, and hands over the frames whose transfer
+		completed. Does nothing if no capture is active. */
+	void capture ();
+
+	/*! Waits for all frames to be transferred and encoded, flushes the stream if any,
+		releases the buffers and stops capturing. The number of errors is kept until
+		the next start. */
+	void finish ();
+
+	/*! Number of frames captured since the last start */
+	int frames () const { return _frames; }
+
+	/*! Number of frames that could not be saved or written since the last start */
+	int errors () const;
+};
+
+//================================= End of File ===============================
+
+# endif // GL_CAPTURE_H
@@ -42,7 +42,17 @@ class GlContext : public GsShareable
 	bool _cullface;
 	bool _depthtest;
 	GLuint _curprogram;
+	GLuint _curtexture;
+	gsuint _texstamp;		// value of the global texture stamp when _curtexture was bound
+	gscbool _texvalid;		// false when the bound texture is not known
 	GLenum _polygonmode;
+	gsuint _pass;
+	gsuint _programchanges;
+	gsuint _texturebinds;
+	// Shadows:
+	GLuint _shadowmap;
+	const GsMat* _shadowmat;
+	gscbool _depthpass;
 
    public :
 	GsLight light;
@@ -87,6 +97,46 @@ class GlContext : public GsShareable
 
 	void use_program ( GLuint pid );
 	void use_program ( const GlProgram* p ) { use_program(p->id); }
+
+	/*! Binds a 2D texture to the current texture unit, if different than the
+		last texture bound with this method. Renderers are expected to only use
+		texture unit 0, and to bind textures for rendering only with this method. */
+	void bind_texture ( GLuint id );
+
+	/*! Makes the next bind_texture() call bind its texture even if it is the last one
+		bound, to be called after binding textures outside of this context */
+	void reset_texture () { _texvalid=0; }
+
+	/*! Resets the bound texture of all contexts, as reset_texture(). Must be called
+		when texture objects are created or deleted outside of GlContext, since a new
+		texture object may receive the id of a deleted one which is still considered bound. */
+	static void invalidate_textures ();
+
+	/*! Returns the id of the program in use and of the texture bound */
+	GLuint cur_program () const { return _curprogram; }
+	GLuint cur_texture () const { return _curtexture; }
+
+	/*! Counters of the number of times the program in use and the bound texture
+		were effectively changed, which are never reset */
+	gsuint program_changes () const { return _programchanges; }
+	gsuint texture_binds () const { return _texturebinds; }
+
+	/*! Render pass counter, incremented by GlRenderer at each scene traversal.
+		Renderers sharing GPU data use it to avoid redundant uploads in a same pass. */
+	gsuint pass () const { return _pass; }
+	void next_pass () { _pass++; }
+
+	/*! Sets the depth texture bound to texture unit 1 to be used as shadow map, and the
+		matrix transforming eye coordinates into shadow map coordinates in [0,1].
+		Use 0 to render without shadows. This is set by GlRenderer at each frame. */
+	void shadow_map ( GLuint id, const GsMat* m ) { _shadowmap=id; _shadowmat=m; }
+	GLuint shadow_map () const { return _shadowmap; }
+	const GsMat* shadow_matrix () const { return _shadowmat; }
+
+	/*! True while GlRenderer renders a shadow map, when renderers supporting shadows
+		only need to draw their geometry with the current transformations */
+	void depth_pass ( bool b ) { _depthpass = b? 1:0; }
+	bool depth_pass () const { return _depthpass==1; }
 };
 
 //================================= End of File ===============================
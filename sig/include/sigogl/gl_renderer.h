@@ -12,24 +12,101 @@
  * OpenGL shader-based render action
  */
 
+# include <sig/gs_box.h>
 # include <sig/sa_action.h>
 # include <sig/sn_shape.h>
 # include <sigogl/gl_context.h>
 
+class SaBvh;
+
 /*! \class GlRenderer gl_renderer.h
 	\brief OpenGL 4 shader-based render action
 
 	GlRenderer traverses the scene graph invoking the scene node methods
-	for shader-based OpenGL 4 rendering. No particular scene optimization
-	strategy is incorporated. This class can be derived or serve as a guide
-	to write other renderers optimizing different aspects of an application. */
+	for shader-based OpenGL 4 rendering. In the default DirectTraversal mode
+	each shape is rendered when visited. In the Instanced mode, SnModel shapes
+	sharing a same GsModel, material and render mode are collected during the
+	traversal with their accumulated matrices, and each collection is then rendered
+	with one instanced draw call per group of faces, after all other shapes.
+	Shapes with transparent materials are not batched and are rendered last,
+	in traversal order.
+	In the RenderQueue mode, shapes are collected in a retained list which is
+	sorted by program, texture and material, and only sorted again when the
+	scene structure or the state used by a shape changes. Shapes with transparent
+	materials are rendered after all others, sorted back-to-front at every frame.
+	Programs and textures are only known after a shape is rendered, so the first
+	frame after a change is rendered in traversal order. In all modes, shapes can
+	be culled against the view frustum and against user-defined occluders, see
+	frustum_culling(), and shadows can be cast by SnModel shapes, see shadows().
+	This class can be derived or serve as a guide to write other renderers
+	optimizing different aspects of an application. */
 class GlRenderer : private SaAction
 {  public :
-	enum Mode { DirectTraversal };
+	enum Mode { DirectTraversal, Instanced, RenderQueue };
+
+	/*! Counters of the last apply() call */
+	struct Stats
+	{	int shapes;		//!< number of shapes rendered
+		int programs;	//!< number of effective program changes
+		int textures;	//!< number of effective texture binds
+		int materials;	//!< number of times the material differed from the previous shape
+		int culled;		//!< number of shapes culled
+		int casters;	//!< number of shapes rendered in the shadow map
+	};
 
    protected :
 	GlContext* _context;
 	Mode _mode;
+	Stats _stats;
+	gsuint _lastmtl;			// key of the last material rendered
+	struct Batch;
+	GsArray<Batch*> _batches;	// batches are kept to reuse their arrays
+	GsArray<int> _bhash;		// hash table of the first batch of each bucket
+	int _nbatches;				// number of batches used in the current traversal
+	int _draws;					// batches rendered with instancing in the last traversal
+	Batch* _getbatch ( SnShape* s );
+	GsArray<SnShape*> _tshapes;	// transparent shapes rendered after the batches
+	GsArray<GsMat> _tmats;		// modelview matrix of each transparent shape
+	void _flush ();
+	struct QEntry
+	{	SnShape* shape;
+		GsMat mat;			// modelview matrix
+		GsBox box;			// local bounding box
+		GLuint program;		// program used in the last rendering
+		GLuint texture;		// texture bound after the last rendering
+		gsuint mtlkey;		// key of the material
+		gscbool transparent;
+	};
+	struct QKey { gsuint64 key; float depth; int i; };
+	GsArray<QEntry> _queue;		// retained render list
+	GsArray<QKey> _opaque;		// sorted indices of the opaque entries
+	GsArray<QKey> _transp;		// indices of the transparent entries
+	int _qsize;					// number of entries in the current traversal
+	gscbool _qsort;				// the opaque entries need to be sorted again
+	void _enqueue ( SnShape* s );
+	void _render_queue ();
+	void _render ( SnShape* s );
+	SaBvh* _bvh;				// scene hierarchy for culling, or null if off
+	GsArray<GsBox> _occluders;	// world boxes of solid occluders
+	GsArray<gscbool> _visinst;	// visibility of each instance in _bvh
+	int _curinst;				// instance of the next visited shape
+	gscbool _occlusion;
+	gscbool _inhelpers;
+	void _cull ( SnNode* n );
+	bool _occluded ( const GsBox& b, const GsPnt& eye ) const;
+	struct SEntry { SnShape* shape; GsMat mat; GsBox box; };
+	GsArray<SEntry> _casters;	// shapes rendered in the shadow map, kept to reuse their boxes
+	int _ncasters;				// number of casters in the current traversal
+	int _ssize;					// shadow map resolution, 0 when shadows are off
+	int _stexsize;				// resolution of the current depth texture
+	GLuint _sfbo, _smap;		// framebuffer and depth texture of the shadow map
+	GsBox _sregion;				// region covered by the shadow map, or empty to fit the casters
+	GsMat _sproj, _sview, _smat;
+	gscbool _incasters;
+	void _shadow_pass ( SnNode* n );
+	void _addcaster ( SnShape* s );
+	static int _cmpkey ( const QKey* k1, const QKey* k2 );
+	static int _cmpdepth ( const QKey* k1, const QKey* k2 );
 
    public :
 	/*! Constructor requires a pointer to the (shared) GlContext to be used. 
@@ -42,6 +119,57 @@ class GlRenderer : private SaAction
 	/*! Set the rendering optimization mode */
 	void traversal_mode ( Mode m ) { _mode=m; }
 
+	/*! Returns the rendering optimization mode, default is DirectTraversal */
+	Mode traversal_mode () const { return _mode; }
+
+	/*! Returns the number of batches of at least 2 shapes rendered with
+		instanced draw calls in the last apply() in Instanced mode */
+	int instanced_batches () const { return _draws; }
+
+	/*! Returns the state change counters of the last apply() */
+	const Stats& stats () const { return _stats; }
+
+	/*! Clears the retained list of the RenderQueue mode */
+	void clear_queue () { _queue.size(0); _qsort=1; }
+
+	/*! Turns on or off view frustum culling, default is off. When on, a scene
+		hierarchy of world bounding boxes (a SaBvh without triangle hierarchies)
+		is updated before each apply(), which costs one traversal without rendering
+		but is only rebuilt when the scene structure changes. The hierarchy is then
+		used to cull subtrees entirely outside the view frustum. Shapes which are
+		marked as changed and helpers of editors are never culled. If occlusion
+		is true, shapes inside the frustum are also tested against the occluders. */
+	void frustum_culling ( bool b, bool occlusion=false );
+
+	/*! Returns true if frustum culling is on */
+	bool frustum_culling () const { return _bvh!=0; }
+
+	/*! Access to the list of occluders used when frustum culling is on with occlusion.
+		Occluders are world-space boxes entirely filled by solid geometry, for example
+		approximating large walls, which must be kept updated by the application.
+		A shape is culled if its world box is entirely hidden by one occluder. */
+	GsArray<GsBox>& occluders () { return _occluders; }
+
+	/*! Turns on or off shadows, default is off. When on, each apply() first renders
+		the depth of all visible SnModel shapes from the light of the context into a
+		shadow map of size x size texels, with an orthographic projection fitted to the
+		boxes of the shapes, which receive shadows in the Gouraud, Phong and textured
+		programs. The light is directional, with direction GlContext::light.position
+		in eye coordinates. Frustum culling does not apply to the shadow map pass. */
+	void shadows ( bool b, int size=2048 );
+
+	/*! Returns true if shadows are on */
+	bool shadows () const { return _ssize>0; }
+
+	/*! Sets the region, in the coordinates of the scene root, to be covered by the
+		shadow map. When the scene is much larger than the area where shadows are needed,
+		a smaller region increases the resolution of the shadows. An empty box, which is
+		the default, fits the shadow map to all shapes. */
+	void shadow_region ( const GsBox& b ) { _sregion=b; }
+
+	/*! Returns the region covered by the shadow map, which may be empty */
+	const GsBox& shadow_region () const { return _sregion; }
+
 	/*! Provides access to GsShareable::ref(). */
 	void ref () { GsShareable::ref(); }
 
@@ -76,6 +204,7 @@ class GlRenderer : private SaAction
 
    private :
 	virtual bool shape_apply ( SnShape* s ) override;
+	virtual bool editor_apply ( SnEditor* e ) override;
 	virtual void push_matrix () override;
 	virtual void pop_matrix () override;
 };
@@ -16,6 +16,9 @@
 
 class GsVar;
 class GsDirs;
+class GsModel;
+class SnNode;
+class GsThreadPool;
 class GlProgram;
 class GlShader;
 class GlTexture;
@@ -80,6 +83,29 @@ class GlResources
 	/*! Access the texture, loading it and sending it to OpenGL on first access. */
 	static const GlTexture* get_texture ( const char* txname );
 
+	/*! Declares the not yet declared textures of the groups of m, with their file names as
+		texture names, and adds the folder of the model file to the resources directories.
+		The renderer does this when a textured model is first drawn. */
+	static void declare_textures ( const GsModel* m );
+
+	/*! Declares the textures of all models in the scene graph starting at n */
+	static void declare_textures ( SnNode* n );
+
+	/*! Decodes in parallel the files of all declared textures not yet loaded, so that the
+		first access only sends them to OpenGL. OpenGL is not needed, so it can be called
+		right after loading models and declaring their textures. If p is null (the default)
+		GsThreadPool::shared() is used. Returns the number of decoded textures. */
+	static int load_textures ( GsThreadPool* p=0 );
+
+	/*! Sets a folder where decoded textures are saved, and from where they are read next
+		time instead of decoding their files, as long as the cached file is newer.
+		A null or empty dir (the default) disables the cache. The folder must exist. */
+	static void texture_cache ( const char* dir );
+
+	/*! Textures of models declared after this call will have mipmaps if b is true.
+		The default is false. */
+	static void mipmapped_textures ( bool b );
+
    public : // Fonts
 
 	/*! Declares the name and location of a .fnt font file to be later used */
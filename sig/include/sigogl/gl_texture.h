@@ -16,6 +16,9 @@ class GlTextureDecl;
 
 //====================== GlTexture =====================
 
+/*! Texture sent to OpenGL. When OpenGL 4.2 is available the texture uses immutable
+	storage, which is allocated once with all its mipmap levels and is reused by new
+	data of same size, format and settings; otherwise a new texture object replaces it. */
 class GlTexture
 {  public :
 	enum Settings { Filtered, MipMapped, Plain };
@@ -23,6 +26,9 @@ class GlTexture
 	gsword width, height;
    private : // resource management information
 	GlTextureDecl* _decl;
+	GLenum _storage; // internal format of the immutable storage, or 0 if none
+	gsbyte _levels;  // mipmap levels of the immutable storage
+	void _upload ( GLenum ifmt, GLenum fmt, int w, int h, const void* pixels, Settings s );
 	friend GlResources;
    public :
 	GlTexture (); // OGL id starts as 0
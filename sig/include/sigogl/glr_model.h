@@ -16,19 +16,37 @@
 # include <sigogl/gl_objects.h>
 # include <sigogl/glr_base.h>
 
+struct GlrModelBuffers;
+
 /*! \class GlrModel sr_model.h
 	\brief SnModel renderer
 
-	Renderer for SnModel */
+	Renderer for SnModel. Vertex arrays and buffers are kept in a cache keyed by
+	the GsModel, the GlContext and the buffer layout, so that all SnModels sharing
+	a same GsModel also share a single set of buffers in the GPU. Instances of a
+	same model can also be drawn with a single call, see render_instances().
+	If the SnModel has levels of detail, the level is selected at each render from
+	the projected size of the model, see SnModel::lod(). */
 class GlrModel : public GlrBase
  { protected :
-	GlObjects _glo; // indices for opengl vertex arrays and buffers
-	bool _normalspervertex;
+	GsArray<GlrModelBuffers*> _bufs; // shared vertex arrays and buffers of each level of detail
+	void _release ();
+	void _render ( SnShape* s, GlContext* c, const GsMat* mats, int ninst );
    public :
 	GlrModel ();
 	virtual ~GlrModel ();
 	virtual void init ( SnShape* s ) override;
 	virtual void render ( SnShape* s, GlContext* c ) override;
+
+	/*! Renders n instances of the model of s with a single instanced draw call per
+		group of faces. Each instance uses one of the given modelview matrices, and
+		the modelview of the context is not used. All instances are rendered with
+		the render mode and material of s, and with the finest level of detail
+		needed by the instances if s has levels of detail. */
+	void render_instances ( SnShape* s, GlContext* c, const GsMat* mats, int n );
+
+	/*! Returns the number of buffer sets currently allocated by all GlrModels */
+	static int buffer_sets ();
 };
 
 //================================ End of File =================================================
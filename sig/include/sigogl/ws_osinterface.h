@@ -66,6 +66,10 @@ extern void* wsi_get_ogl_procedure ( const char *name );
 // get window events and send them to the respective windows; returns number of open windows
 int wsi_check ();
 
+// waits up to the given time in seconds for window events, blocking in the system,
+// then processes them as wsi_check(); returns number of open windows
+int wsi_wait ( double secs );
+
 //========== Sys Info ===========
 
 // returns screen resolution of primary display in pixels 
@@ -29,14 +29,36 @@ void ws_remove_timer ( WsWindow* win, int ev );
 /*! Removes all timers registered for the given window. */
 void ws_remove_timers ( WsWindow* win );
 
-/*! Checks if a timer is to be executed. Can be called for controlling timers
+/*! Register a fixed-step simulation clock. Function update is called once for every
+	step seconds of elapsed time, always with the same step, and function draw (if not null)
+	is called after the updates of each frame with alpha in [0,1), the fraction of the next
+	step already elapsed, which can be used to interpolate the rendered state.
+	Frames are due every frame seconds, or every step if frame is 0.
+	When the application falls behind, at most maxsteps updates are done per frame and the
+	remaining time is dropped. */
+void ws_add_clock ( double step, void(*update)(void*), void(*draw)(float,void*), void* udata,
+					double frame=0, int maxsteps=5 );
+
+/*! Removes the clock with the given update function. Can be called from the callbacks. */
+void ws_remove_clock ( void(*update)(void*) );
+
+/*! Returns the number of update steps done by the clock with the given update function,
+	or -1 if there is no such clock. */
+int ws_clock_steps ( void(*update)(void*) );
+
+/*! Checks if a timer or a clock is to be executed. Can be called for controlling timers
 	outside of ws_run() or ws_check() */
 void ws_check_timers ();
 
+/*! Process events, timers and clocks for the given time in seconds, blocking in the system
+	while waiting. Returns the number of open windows. */
+int ws_wait ( double secs );
+
 /*! Process events until there are open windows. If sleepms>0 a sleep of time 
 	sleepms miliseconds is called between every event processed.
 	If sleepms<0, a sleep of 1ms is performed every |sleepms| iterations.
-	No sleep is performed if sleepms is 0. */  
+	No sleep is performed if sleepms is 0. While clocks are registered (see ws_add_clock())
+	the sleep is replaced by a blocking wait until the next frame or timer is due. */  
 void ws_run ( int sleepms=-100 );
 
 /*! Check function designed for local event processing such as for controlling an
@@ -12,6 +12,7 @@
 # ifndef WS_VIEWER_H
 # define WS_VIEWER_H
 
+# include <stdio.h>
 # include <sigogl/ws_window.h>
 # include <sig/gs_color.h>
 # include <sig/gs_quat.h>
@@ -61,7 +62,8 @@ class WsViewer : public WsWindow
 				   VCmdAxis,		//!< display the global axis
 				   VCmdBoundingBox,	//!< display the scence bounding box
 				   VCmdStatistics,	//!< display rendering statistics
-				   VCmdSpinAnim		//!< turn on/off spin animation
+				   VCmdSpinAnim,	//!< turn on/off spin animation
+				   VCmdShadows		//!< turn on/off shadows cast by the light, see GlRenderer::shadows()
 				};
 
    private : // internal data
@@ -203,14 +205,29 @@ class WsViewer : public WsWindow
 	/*! Sets new light parameters and mark the light as changed. */
 	void light ( const GsLight& l );
 
+	/*! Returns the renderer used for the scene, which is different than glrenderer().
+		It can be used for example to set the Instanced traversal mode. */
+	GlRenderer* scene_renderer ();
+
 	/*! Exports all GsModels in the scene to files, and in global coordinates */
 	void export_all_models ( const char* prefix=0, const char* dir=0 );
 
 	/*! Turns on or off snapshot saving per frame. Optional parameters specify the
 		desired base file name and the start number (>1) for enumerating files.
-		The file name extension defines the image format: bmp, tga, or otherwise png. */
+		The file name extension defines the image format: bmp, tga, or otherwise png.
+		Frames are read asynchronously and saved by background tasks (see GlCapture),
+		and turning off waits for all pending images to be saved. The scene is
+		captured without the user interface. */
 	void snapshots ( bool onoff, const char* file=0, int n=-1 );
 
+	/*! Turns on writing each frame to s as raw RGBA pixels, top row first, for ex.
+		to a pipe opened with popen() to a video encoder. Turn off with snapshots(false),
+		after which s can be closed. */
+	void snapshots_stream ( FILE* s );
+
+	/*! Number of frames captured since snapshots were last turned on */
+	int snapshots_taken () const;
+
    protected : //----> methods overriding WsWindow virtual methods
 
 	/*! Extends WsWindow::init() and initializes OpenGL depth test, back face culling, 
@@ -0,0 +1,11 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+
+uniform mat4 vProj;
+uniform mat4 vView;
+
+void main ()
+{
+	gl_Position = vec4(vPos,1.0) * vView * vProj;
+}
@@ -0,0 +1,12 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+layout (location = 4) in mat4 vInst; // per-instance modelview matrix
+
+uniform mat4 vProj;
+uniform mat4 vView;
+
+void main ()
+{
+	gl_Position = vec4(vPos,1.0) * vInst * vView * vProj;
+}
@@ -10,7 +10,9 @@ uniform vec3[3]  lInt;    // light intensities: ambient, diffuse, and specular
 uniform vec3[4]  mColors; // material colors  : ambient, diffuse, specular, and emission 
 uniform float[2] mParams; // material params  : shininess, transparency
 
-out vec4 Color;
+out vec4 Color; // fully illuminated color
+out vec4 Amb;   // color with only the ambient and emission terms, used in shadows
+out vec3 Pos;
 
 vec4 shade ( vec3 p, vec3 n, vec3 lp, vec3[3] li, vec3 ka, vec3 kd, vec3 ks, vec3 emi, float sh, float alpha );
 
@@ -22,6 +24,8 @@ void main ()
 	vec3 n = normalize ( vNorm*transpose(inverse(mat3(vView))) ); // vertex normal 
 
 	Color = shade ( p, n, lPos, lInt, mColors[0], mColors[1], mColors[2], mColors[3], mParams[0], mParams[1] );
+	Amb = shade ( p, n, lPos, vec3[3](lInt[0],vec3(0),vec3(0)), mColors[0], mColors[1], mColors[2], mColors[3], mParams[0], mParams[1] );
+	Pos = p;
 
 	gl_Position = vec4(p,1.0) * vProj;
 }
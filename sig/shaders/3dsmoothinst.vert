@@ -0,0 +1,18 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec4 vColor;
+layout (location = 4) in mat4 vInst; // per-instance modelview matrix
+
+uniform mat4 vProj;
+uniform mat4 vView;
+
+out vec4 Color; // note no flat keyword here
+
+void main ()
+{
+	mat4 mView = vInst * vView;
+
+	Color = vColor / 255.0;
+	gl_Position = vec4(vPos.x,vPos.y,vPos.z,1.0) * mView * vProj;
+}
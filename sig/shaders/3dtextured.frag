@@ -15,6 +15,7 @@ uniform int Mode;        // 0:textured, 1:not textured
 uniform sampler2D TexId; // diffuse color texture
 
 vec4 shade ( vec3 p, vec3 n, vec3 lp, vec3[3] li, vec3 ka, vec3 kd, vec3 ks, vec3 emi, float sh, float alpha );
+float shadow ( vec3 p );
 
 void main()
 {
@@ -33,5 +34,9 @@ void main()
 		alpha = mParams[1];
 	}
 
-	fColor = shade ( Pos, Norm, lPos, lInt, mColors[0], kd, mColors[2], mColors[3], mParams[0], alpha );
+	// diffuse and specular light are attenuated in shadows:
+	float s = shadow ( Pos );
+	vec3[3] li = vec3[3] ( lInt[0], lInt[1]*s, lInt[2]*s );
+
+	fColor = shade ( Pos, Norm, lPos, li, mColors[0], kd, mColors[2], mColors[3], mParams[0], alpha );
 }
@@ -0,0 +1,13 @@
+# version 330
+
+in  vec4 Color; // fully illuminated color
+in  vec4 Amb;   // color with only the ambient and emission terms
+in  vec3 Pos;
+out vec4 fColor;
+
+float shadow ( vec3 p );
+
+void main() 
+{
+	fColor = mix ( Amb, Color, shadow(Pos) );
+}
@@ -10,8 +10,13 @@ in vec3 Norm;
 out vec4 fColor;
 
 vec4 shade ( vec3 p, vec3 n, vec3 lp, vec3[3] li, vec3 ka, vec3 kd, vec3 ks, vec3 emi, float sh, float alpha );
+float shadow ( vec3 p );
 
 void main() 
 {
-	fColor = shade ( Pos, Norm, lPos, lInt, mColors[0], mColors[1], mColors[2], mColors[3], mParams[0], mParams[1] );
+	// diffuse and specular light are attenuated in shadows:
+	float s = shadow ( Pos );
+	vec3[3] li = vec3[3] ( lInt[0], lInt[1]*s, lInt[2]*s );
+
+	fColor = shade ( Pos, Norm, lPos, li, mColors[0], mColors[1], mColors[2], mColors[3], mParams[0], mParams[1] );
 } 
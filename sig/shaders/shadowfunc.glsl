@@ -0,0 +1,19 @@
+# version 330
+
+uniform mat4 sMat;             // eye coords to shadow map coords in [0,1]
+uniform sampler2DShadow sMap;  // depth map rendered from the light, always on texture unit 1
+uniform int sOn;               // 0:no shadows, 1:use shadow map
+
+float shadow ( vec3 p )
+{
+	if ( sOn==0 ) return 1.0;
+	vec4 s = vec4(p,1.0) * sMat;
+	if ( s.z>=1.0 ) return 1.0; // beyond the depth range of the map
+
+	// 4 filtered comparisons for soft borders:
+	float sum = textureOffset ( sMap, s.xyz, ivec2(-1,-1) );
+	sum += textureOffset ( sMap, s.xyz, ivec2(1,-1) );
+	sum += textureOffset ( sMap, s.xyz, ivec2(-1,1) );
+	sum += textureOffset ( sMap, s.xyz, ivec2(1,1) );
+	return sum * 0.25;
+}
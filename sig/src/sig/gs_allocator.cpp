@@ -0,0 +1,36 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <stdlib.h>
+# include <string.h>
+
+# include <sig/gs_allocator.h>
+
+//================================= GsAllocator ====================================
+
+void* GsAllocator::realloc ( void* p, size_t n, size_t nn )
+{
+	void* np = alloc ( nn );
+	memcpy ( np, p, n<nn? n:nn );
+	free ( p, n );
+	return np;
+}
+
+class GsHeapAllocator : public GsAllocator
+{  public :
+	virtual void* alloc ( size_t n ) override { return ::malloc(n); }
+	virtual void* realloc ( void* p, size_t /*n*/, size_t nn ) override { return ::realloc(p,nn); }
+	virtual void free ( void* p, size_t /*n*/ ) override { ::free(p); }
+};
+
+GsAllocator* GsAllocator::heap ()
+{
+	static GsHeapAllocator a;
+	return &a;
+}
+
+//============================== end of file ===============================
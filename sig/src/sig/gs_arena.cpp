@@ -0,0 +1,116 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <stdlib.h>
+# include <string.h>
+
+# include <sig/gs_arena.h>
+
+//================================= GsArena ====================================
+
+struct GsArena::Chunk
+{	Chunk* next;
+	size_t size; // usable bytes after the header
+	char* data () { return (char*)this+Header; }
+	static const size_t Header = 16; // keeps data aligned
+};
+
+static inline size_t align16 ( size_t n ) { return (n+15)&~size_t(15); }
+
+GsArena::GsArena ( size_t chunksize )
+{
+	_chunks = 0;
+	_cur = _end = _last = 0;
+	_chunksize = align16 ( chunksize<1024? 1024:chunksize );
+	_used = 0;
+}
+
+GsArena::~GsArena ()
+{
+	while ( _chunks ) { Chunk* c=_chunks; _chunks=c->next; ::free(c); }
+}
+
+void* GsArena::_alloc_chunk ( size_t n, bool current )
+{
+	Chunk* c = (Chunk*) ::malloc ( Chunk::Header+n );
+	c->size = n;
+	if ( current || !_chunks )
+	{	c->next = _chunks;
+		_chunks = c;
+	}
+	else // dedicated chunk: goes after the current one, which stays current
+	{	c->next = _chunks->next;
+		_chunks->next = c;
+	}
+	if ( current )
+	{	_cur = c->data();
+		_end = _cur+n;
+		_last = 0;
+	}
+	return c->data();
+}
+
+void* GsArena::alloc ( size_t n )
+{
+	n = align16 ( n? n:1 );
+	_used += n;
+	if ( size_t(_end-_cur)<n )
+	{	if ( n>_chunksize/4 ) return _alloc_chunk ( n, false );
+		_alloc_chunk ( _chunksize, true );
+	}
+	_last = _cur;
+	_cur += n;
+	return _last;
+}
+
+void* GsArena::realloc ( void* p, size_t n, size_t nn )
+{
+	if ( !p ) return alloc ( nn );
+	n = align16 ( n );
+	nn = align16 ( nn );
+	if ( p==_last && _last+nn<=_end ) // last block: grows or shrinks in place
+	{	_cur = _last+nn;
+		_used += nn-n;
+		return p;
+	}
+	if ( nn<=n ) return p;
+	void* np = alloc ( nn );
+	memcpy ( np, p, n );
+	return np;
+}
+
+void GsArena::free ( void* p, size_t /*n*/ )
+{
+	if ( p && p==_last )
+	{	_used -= _cur-_last;
+		_cur = _last;
+		_last = 0;
+	}
+}
+
+void GsArena::clear ()
+{
+	Chunk* keep = 0; // one regular chunk is kept for reuse
+	while ( _chunks )
+	{	Chunk* c=_chunks; _chunks=c->next;
+		if ( !keep && c->size==_chunksize ) keep=c; else ::free(c);
+	}
+	_chunks = keep;
+	if ( keep ) { keep->next=0; _cur=keep->data(); _end=_cur+keep->size; }
+	else { _cur=_end=0; }
+	_last = 0;
+	_used = 0;
+}
+
+size_t GsArena::reserved () const
+{
+	size_t n=0;
+	for ( Chunk* c=_chunks; c; c=c->next ) n += Chunk::Header+c->size;
+	return n;
+}
+
+//============================== end of file ===============================
@@ -9,6 +9,7 @@
 # include <string.h>
 
 # include <sig/gs_array.h>
+# include <sig/gs_allocator.h>
 
 # define DATA(i)	 ((char*)_data)+(sizeofx*(i))
 # define DESTDATA(i) ((char*)desta._data)+(sizeofx*(i))
@@ -208,4 +209,37 @@ void GsArrayBase::adopt ( void* pt, int s, int c )
 	_capacity = c;
 }
 
+void GsArrayBase::recapacity ( unsigned sizeofx, int nc, void* inl, int ninl, GsAllocator* a )
+{
+	if ( nc<ninl ) nc=ninl;
+	if ( nc==_capacity ) return;
+	if ( _size>nc ) _size=nc;
+
+	void* newdata;
+	if ( nc==ninl ) // back to the inline buffer, or empty if there is none
+	{	newdata = inl;
+		if ( _size>0 ) memcpy ( newdata, _data, sizeofx*_size );
+		if ( a ) a->free ( _data, sizeofx*_capacity ); else free ( _data );
+	}
+	else if ( _data==inl ) // from the inline buffer to a new block
+	{	newdata = a? a->alloc(sizeofx*nc) : malloc(sizeofx*nc);
+		if ( _size>0 ) memcpy ( newdata, _data, sizeofx*_size );
+	}
+	else // resize the current block
+	{	newdata = a? a->realloc(_data,sizeofx*_capacity,sizeofx*nc) : realloc(_data,sizeofx*nc);
+	}
+	_data = newdata;
+	_capacity = nc;
+}
+
+void GsArrayBase::free_data ( unsigned sizeofx, void* inl, int ninl, GsAllocator* a )
+{
+	if ( _data!=inl )
+	{	if ( a ) a->free ( _data, sizeofx*_capacity ); else free ( _data );
+	}
+	_data = inl;
+	_size = 0;
+	_capacity = ninl;
+}
+
 //============================== end of file ===============================
@@ -0,0 +1,322 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_bvh.h>
+# include <sig/gs_mat.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+//================================== helpers ====================================
+
+# define BINS 12
+
+// traversal stacks are kept in the local array if the tree is not too deep
+# define STACKSIZE 64
+
+static inline float halfarea ( const GsBox& b )
+{
+	GsVec d = b.b-b.a;
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+// GsBox::intersects() only tests the corners of one box, missing some overlaps
+static inline bool overlaps ( const GsBox& x, const GsBox& y )
+{
+	return x.a.x<=y.b.x && y.a.x<=x.b.x && x.a.y<=y.b.y && y.a.y<=x.b.y && x.a.z<=y.b.z && y.a.z<=x.b.z;
+}
+
+//================================== GsBvh ====================================
+
+GsBvh::GsBvh ()
+{
+	_depth = 0;
+}
+
+void GsBvh::init ()
+{
+	_nodes.size ( 0 );
+	_items.size ( 0 );
+	_boxes.size ( 0 );
+	_depth = 0;
+}
+
+// Splits node ni with the surface area heuristic evaluated on BINS bins along the axis
+// of largest extent of the item centers. Returns false if the node is to be a leaf.
+bool GsBvh::_split ( int ni, GsArray<GsPnt>& centers, int leafsize )
+{
+	int first = _nodes[ni].first;
+	int count = _nodes[ni].count;
+	if ( count<=leafsize ) return false;
+
+	int i, k;
+	GsBox cb;
+	for ( i=first; i<first+count; i++ ) cb.extend ( centers[i] );
+	GsVec ext = cb.size();
+	int axis = ext.x>=ext.y && ext.x>=ext.z? 0 : ext.y>=ext.z? 1:2;
+	float amin = cb.a.e[axis];
+	float aext = ext.e[axis];
+	if ( aext<=0 ) return false; // all centers coincide
+
+	// fill the bins:
+	GsBox bbox[BINS];
+	int bcount[BINS];
+	for ( k=0; k<BINS; k++ ) bcount[k]=0;
+	float f = BINS*0.9999f/aext;
+	for ( i=first; i<first+count; i++ )
+	{	k = int( f*(centers[i].e[axis]-amin) );
+		bcount[k]++;
+		bbox[k].extend ( _boxes[i] );
+	}
+
+	// sweep from the right to get the costs of the right sides, then from the left:
+	float rcost[BINS];
+	GsBox b;
+	int c=0;
+	for ( k=BINS-1; k>0; k-- )
+	{	c += bcount[k];
+		b.extend ( bbox[k] );
+		rcost[k] = c? c*halfarea(b) : 0;
+	}
+	float best = -1;
+	int bestk = 0;
+	b.set_empty(); c=0;
+	for ( k=0; k<BINS-1; k++ )
+	{	c += bcount[k];
+		b.extend ( bbox[k] );
+		float cost = ( c? c*halfarea(b):0 ) + rcost[k+1];
+		if ( c>0 && c<count && ( best<0 || cost<best ) ) { best=cost; bestk=k; }
+	}
+
+	// the node stays a leaf if it is not worth splitting it and it is not too large:
+	float leafcost = count*halfarea(_nodes[ni].box);
+	if ( best>=leafcost && count<=4*leafsize ) return false;
+
+	// partition items and boxes:
+	int l=first, r=first+count-1;
+	while ( l<=r )
+	{	k = int( f*(centers[l].e[axis]-amin) );
+		if ( k<=bestk ) { l++; continue; }
+		GsPnt tc=centers[l]; centers[l]=centers[r]; centers[r]=tc;
+		GsBox tb=_boxes[l]; _boxes[l]=_boxes[r]; _boxes[r]=tb;
+		int ti=_items[l]; _items[l]=_items[r]; _items[r]=ti;
+		r--;
+	}
+	int lcount = l-first;
+
+	// create children:
+	int left = _nodes.size();
+	_nodes.size ( left+2 );
+	Node& nl = _nodes[left];
+	Node& nr = _nodes[left+1];
+	nl.first=first; nl.count=lcount; nl.box.set_empty();
+	nr.first=l; nr.count=count-lcount; nr.box.set_empty();
+	for ( i=nl.first; i<nl.first+nl.count; i++ ) nl.box.extend ( _boxes[i] );
+	for ( i=nr.first; i<nr.first+nr.count; i++ ) nr.box.extend ( _boxes[i] );
+	_nodes[ni].first = left;
+	_nodes[ni].count = 0;
+	return true;
+}
+
+void GsBvh::build ( const GsArray<GsBox>& boxes, int leafsize )
+{
+	init ();
+	if ( leafsize<1 ) leafsize=1;
+
+	int i, n=0;
+	_items.reserve ( boxes.size() );
+	_boxes.reserve ( boxes.size() );
+	for ( i=0; i<boxes.size(); i++ )
+	{	if ( boxes[i].empty() ) continue;
+		_items.push() = i;
+		_boxes.push() = boxes[i];
+		n++;
+	}
+	if ( n==0 ) return;
+
+	GsArray<GsPnt> centers ( n );
+	for ( i=0; i<n; i++ ) centers[i] = _boxes[i].center();
+
+	_nodes.reserve ( 2*(n/leafsize)+1 );
+	Node& root = _nodes.push();
+	root.first=0; root.count=n; root.box.set_empty();
+	for ( i=0; i<n; i++ ) root.box.extend ( _boxes[i] );
+
+	// nodes are split in depth-first order with an explicit stack:
+	struct Entry { int node, depth; };
+	GsArray<Entry> stack;
+	stack.push().node=0; stack.top().depth=1;
+	while ( stack.size() )
+	{	Entry e = stack.pop();
+		if ( e.depth>_depth ) _depth=e.depth;
+		if ( !_split(e.node,centers,leafsize) ) continue;
+		int left = _nodes[e.node].first;
+		stack.push().node=left+1; stack.top().depth=e.depth+1;
+		stack.push().node=left; stack.top().depth=e.depth+1;
+	}
+	_nodes.compress();
+	GS_TRACE1 ( "built with "<<n<<" items, "<<_nodes.size()<<" nodes, depth "<<_depth );
+}
+
+void GsBvh::refit ( const GsArray<GsBox>& boxes )
+{
+	int i, k;
+	for ( k=0; k<_items.size(); k++ ) _boxes[k] = boxes[_items[k]];
+
+	// children always have greater indices than their parents:
+	for ( i=_nodes.size()-1; i>=0; i-- )
+	{	Node& n = _nodes[i];
+		n.box.set_empty();
+		if ( n.count==0 )
+		{	n.box.extend ( _nodes[n.first].box );
+			n.box.extend ( _nodes[n.first+1].box );
+		}
+		else
+		{	for ( k=n.first; k<n.first+n.count; k++ ) n.box.extend ( _boxes[k] );
+		}
+	}
+}
+
+bool GsBvh::ray_box ( const GsPnt& p1, const GsVec& invd, const GsBox& b, float& t1, float& t2 )
+{
+	float tx1 = (b.a.x-p1.x)*invd.x, tx2 = (b.b.x-p1.x)*invd.x;
+	float ty1 = (b.a.y-p1.y)*invd.y, ty2 = (b.b.y-p1.y)*invd.y;
+	float tz1 = (b.a.z-p1.z)*invd.z, tz2 = (b.b.z-p1.z)*invd.z;
+	t1 = GS_MAX ( GS_MAX ( GS_MIN(tx1,tx2), GS_MIN(ty1,ty2) ), GS_MIN(tz1,tz2) );
+	t2 = GS_MIN ( GS_MIN ( GS_MAX(tx1,tx2), GS_MAX(ty1,ty2) ), GS_MAX(tz1,tz2) );
+	return t2>=t1 && t2>=0;
+}
+
+int GsBvh::ray ( const GsLine& ray, RayFunc f, void* udata, float& t, float tmax ) const
+{
+	t = tmax;
+	if ( _nodes.empty() ) return -1;
+
+	GsVec d = ray.p2-ray.p1;
+	GsVec invd ( 1.0f/d.x, 1.0f/d.y, 1.0f/d.z );
+	float t1, t2;
+	if ( !ray_box(ray.p1,invd,_nodes[0].box,t1,t2) || t1>=tmax ) return -1;
+
+	struct Entry { int node; float t; };
+	Entry local[STACKSIZE];
+	GsArray<Entry> heap;
+	Entry* stack = local;
+	if ( _depth>=STACKSIZE ) { heap.size(_depth+1); stack=heap.pt(); }
+
+	int k, found=-1, s=0;
+	stack[s].node=0; stack[s].t=t1; s++;
+	while ( s>0 )
+	{	Entry e = stack[--s];
+		if ( e.t>=t ) continue; // farther than the closest intersection found
+		const Node& n = _nodes[e.node];
+		if ( n.count>0 )
+		{	for ( k=n.first; k<n.first+n.count; k++ )
+			{	if ( !ray_box(ray.p1,invd,_boxes[k],t1,t2) || t1>=t ) continue;
+				float ti = f ( _items[k], ray, t, udata );
+				if ( ti>=0 && ti<t ) { t=ti; found=_items[k]; }
+			}
+			continue;
+		}
+		float ta1, ta2, tb1, tb2;
+		bool a = ray_box ( ray.p1, invd, _nodes[n.first].box, ta1, ta2 ) && ta1<t;
+		bool b = ray_box ( ray.p1, invd, _nodes[n.first+1].box, tb1, tb2 ) && tb1<t;
+		if ( a && b ) // push the farther child first so that the nearer one is visited first
+		{	if ( ta1<=tb1 )
+			{	stack[s].node=n.first+1; stack[s].t=tb1; s++;
+				stack[s].node=n.first; stack[s].t=ta1; s++;
+			}
+			else
+			{	stack[s].node=n.first; stack[s].t=ta1; s++;
+				stack[s].node=n.first+1; stack[s].t=tb1; s++;
+			}
+		}
+		else if ( a ) { stack[s].node=n.first; stack[s].t=ta1; s++; }
+		else if ( b ) { stack[s].node=n.first+1; stack[s].t=tb1; s++; }
+	}
+	return found;
+}
+
+void GsBvh::overlap ( const GsBox& b, GsArray<int>& items ) const
+{
+	if ( _nodes.empty() || b.empty() ) return;
+
+	int local[STACKSIZE];
+	GsArray<int> heap;
+	int* stack = local;
+	if ( _depth>=STACKSIZE ) { heap.size(_depth+1); stack=heap.pt(); }
+
+	int k, s=0;
+	stack[s++] = 0;
+	while ( s>0 )
+	{	const Node& n = _nodes[stack[--s]];
+		if ( !overlaps(n.box,b) ) continue;
+		if ( n.count==0 )
+		{	stack[s++]=n.first+1;
+			stack[s++]=n.first;
+			continue;
+		}
+		for ( k=n.first; k<n.first+n.count; k++ )
+		{	if ( overlaps(_boxes[k],b) ) items.push()=_items[k];
+		}
+	}
+}
+
+// Returns -1 if the box is outside one of the planes, and otherwise clears from mask the
+// planes having the box entirely in their positive side. Plane i is given by the 4 floats
+// in pl[i*4], and a point is in the positive side if the plane equation is positive.
+static inline int classify ( const float* pl, int mask, const GsBox& b )
+{
+	for ( int i=0; i<6; i++ )
+	{	if ( !(mask&(1<<i)) ) continue;
+		const float* p = pl+i*4;
+		float pmax = p[3] + p[0]*(p[0]>0?b.b.x:b.a.x) + p[1]*(p[1]>0?b.b.y:b.a.y) + p[2]*(p[2]>0?b.b.z:b.a.z);
+		if ( pmax<0 ) return -1;
+		float pmin = p[3] + p[0]*(p[0]>0?b.a.x:b.b.x) + p[1]*(p[1]>0?b.a.y:b.b.y) + p[2]*(p[2]>0?b.a.z:b.b.z);
+		if ( pmin>=0 ) mask &= ~(1<<i);
+	}
+	return mask;
+}
+
+void GsBvh::frustum ( const GsMat& m, GsArray<int>& items ) const
+{
+	if ( _nodes.empty() ) return;
+
+	// frustum planes from the rows of the matrix, in the order left, right, bottom, top, near, far:
+	float pl[24];
+	int i, k;
+	for ( i=0; i<3; i++ )
+	{	for ( k=0; k<4; k++ )
+		{	pl[i*8+k]   = m.e[12+k] + m.e[i*4+k];
+			pl[i*8+4+k] = m.e[12+k] - m.e[i*4+k];
+		}
+	}
+
+	struct Entry { int node, mask; };
+	Entry local[STACKSIZE];
+	GsArray<Entry> heap;
+	Entry* stack = local;
+	if ( _depth>=STACKSIZE ) { heap.size(_depth+1); stack=heap.pt(); }
+
+	int s=0;
+	stack[s].node=0; stack[s].mask=63; s++;
+	while ( s>0 )
+	{	Entry e = stack[--s];
+		const Node& n = _nodes[e.node];
+		if ( e.mask ) e.mask = classify ( pl, e.mask, n.box );
+		if ( e.mask<0 ) continue;
+		if ( n.count==0 )
+		{	stack[s].node=n.first+1; stack[s].mask=e.mask; s++;
+			stack[s].node=n.first; stack[s].mask=e.mask; s++;
+			continue;
+		}
+		for ( k=n.first; k<n.first+n.count; k++ )
+		{	if ( e.mask==0 || classify(pl,e.mask,_boxes[k])>=0 ) items.push()=_items[k];
+		}
+	}
+}
+
+//============================== end of file ===============================
@@ -21,6 +21,7 @@ GsGraphNode::GsGraphNode ()
 	_index=0;
 	_graph=0;
 	_blocked=0;
+	_sid=-1;
 }
 
 GsGraphNode::~GsGraphNode ()
@@ -110,12 +111,11 @@ void GsGraphNode::output ( GsOutput& o ) const
 
 class GsGraphPathTree
 {  public :
-//	struct Node { int parent; float cost; GsGraphNode* node; };
-	struct Node { int parent; GsGraphNode* node; };
-	struct Leaf { int l; int d; }; // the leaf index in nodes array, and its depth
-	GsArray<Node> N;
-	GsHeap<Leaf,float> Q;
+	struct Node { int parent; int d; GsGraphNode* node; }; // parent index, depth, and graph node
+	GsArray<Node> N; // one entry per reached graph node, the index being its id in Q
+	GsIndexedHeap<float> Q;
 	GsGraphBase* graph;
+	int ifound;
 	GsGraphNode* closest;
 	int iclosest;
 	float cdist;
@@ -131,14 +131,15 @@ class GsGraphPathTree
 	void init ( GsGraphBase* g, GsGraphNode* n )
 	{	N.size(1);
 		N[0].parent = -1;
+		N[0].d = 0;
 		N[0].node = n;
 		n->fparam = 0; // cost to come
+		n->_sid = 0;
 		g->mark ( n );
-		Leaf l;
-		l.l = l.d = 0;
 		Q.init ();
-		Q.insert ( l, 0 );
+		Q.insert ( 0, 0 );
 		graph = g;
+		ifound = -1;
 		distfunc = 0;
 		udata = 0;
 		closest = 0;
@@ -146,45 +147,50 @@ class GsGraphPathTree
 		cdist = 0;
 	}
 
-	bool has_leaf () const { return Q.size()>=0; }
+	bool has_leaf () const { return Q.size()>0; }
 
 	float& ncost ( int i ) { return N[i].node->fparam; }
 
 	bool expand_lowest_cost_leaf ( GsGraphNode* goalnode )
-	{	int n = Q.top().l;
-		int nextd = Q.top().d+1;
+	{	int n = Q.top();
+		int nextd = N[n].d+1;
 		Q.remove ();
 		GsGraphNode* node = N[n].node;
-		if ( node==goalnode ) { N.size(n+1); return true; }
-		Leaf leaf;
+		if ( node==goalnode ) { ifound=n; return true; }
 		const GsArray<GsGraphLink*>& a = node->links();
 		for ( int i=0,s=a.size(); i<s; i++ )
-		{	//gsout<<a.size()<<gsnl;
-			GsGraphLink* li = a[i];
+		{	GsGraphLink* li = a[i];
 			GsGraphNode* lin = li->node();
 			if ( li->blocked() || lin->blocked() ) continue;
 			if ( bidirectional_block && lin->link(node)->blocked() ) continue;
 			float newcost = node->fparam + li->cost();
-			if ( graph->marked(lin) && newcost>=lin->fparam ) continue;
+			int id;
+			if ( graph->marked(lin) ) // already reached: only update it if the cost is lower
+			{	if ( newcost>=lin->fparam ) continue;
+				id = lin->_sid;
+				if ( Q.contains(id) ) Q.decrease_key ( id, newcost );
+				else Q.insert ( id, newcost ); // already expanded, can only happen with negative costs
+			}
+			else
+			{	graph->mark ( lin );
+				id = lin->_sid = N.size();
+				N.push().node = lin;
+				Q.insert ( id, newcost );
+			}
 			lin->fparam = newcost;
-			graph->mark ( lin );
-			N.push();
-			N.top().parent = n;
-			N.top().node = lin;
-			leaf.l = N.size()-1;
-			leaf.d = nextd;
-			Q.insert ( leaf, lin->fparam );
+			N[id].parent = n;
+			N[id].d = nextd;
 			if ( distfunc )
 			{	float d = distfunc ( lin, goalnode, udata );
 				if ( !closest || d<cdist )
-				{	closest=N.top().node; iclosest=N.size()-1; cdist=d; }
+				{	closest=lin; iclosest=id; cdist=d; }
 			}
 		}
 		return false;
 	 }
 
 	float make_path ( int i, GsArray<GsGraphNode*>& path )
-	{	float cost = N[i].node->fparam;   
+	{	float cost = N[i].node->fparam;
 		path.size(0);
 		while ( i>=0 )
 		{	path.push() = N[i].node;
@@ -529,8 +535,8 @@ bool GsGraphBase::shortest_path
 	}
 	end_marking ();
 
-	if ( _pt->N.top().node==n1 ) // found
-	{	cost = _pt->make_path ( _pt->N.size()-1, path );
+	if ( _pt->ifound>=0 ) // found
+	{	cost = _pt->make_path ( _pt->ifound, path );
 		GS_TRACE2 ( "Found! size:"<<path.size()<<" cost:"<<cost );
 		return true;
 	}
@@ -565,8 +571,8 @@ bool GsGraphBase::local_search ( GsGraphNode* startn, GsGraphNode* endn,
 	while ( !end )
 	{	if ( !_pt->has_leaf() ) { not_found=true; break; } // not found!
 
-		dist = _pt->ncost ( _pt->Q.top().l );
-		depth = _pt->Q.top().d;
+		dist = _pt->ncost ( _pt->Q.top() );
+		depth = _pt->N[_pt->Q.top()].d;
 
 		if ( maxdepth>0 && depth>maxdepth ) { break; } // max depth reached
 		if ( maxdist>0 && dist>maxdist ) { break; }	// max dist reached
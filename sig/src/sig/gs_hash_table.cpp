@@ -0,0 +1,241 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <string.h>
+
+# include <sig/gs_hash_table.h>
+# include <sig/gs_arena.h>
+
+//================================ hash functions =============================
+
+// FNV-1a hash with a final mix, as the table only uses the lower bits
+static inline gsuint hash ( const char* s )
+{
+	gsuint h = 2166136261u;
+	while ( *s ) { h = ( h^gsuint((unsigned char)*s) ) * 16777619u; s++; }
+	h ^= h>>16; h *= 0x85ebca6bu; h ^= h>>13; h *= 0xc2b2ae35u; h ^= h>>16;
+	return h;
+}
+
+static inline bool samekey ( const char* k1, const char* k2 )
+{
+	return k1==k2 || strcmp(k1,k2)==0;
+}
+
+// number of slots needed to keep n elements with a load of at most 50%, slots are
+// only integers so that a low load costs little memory and keeps probing short:
+static int slots_for ( int n )
+{
+	int s=8;
+	while ( s<n*2 ) s*=2;
+	return s;
+}
+
+//================================ GsHashTableBase ===============================
+
+GsHashTableBase::GsHashTableBase ( int hsize, KeyStorage ks )
+{
+	_elements = 0;
+	_removed = 0;
+	_last_id = -1;
+	_key_storage = ks;
+	init ( hsize, ks );
+}
+
+GsHashTableBase::~GsHashTableBase ()
+{
+	init ( 0, (KeyStorage)_key_storage );
+}
+
+void GsHashTableBase::init ( int hsize, KeyStorage ks )
+{
+	if ( _key_storage==AllocatedKeys )
+	{	for ( int i=0; i<_entries.size(); i++ ) delete[] _entries[i].key;
+	}
+	_key_storage = ks;
+	_entries.size ( 0 );
+	_free.size ( 0 );
+	_elements = 0;
+	_removed = 0;
+	_last_id = -1;
+	if ( hsize>0 )
+	{	_entries.capacity ( hsize );
+		_rebuild ( slots_for(hsize) );
+	}
+	else
+	{	_entries.capacity ( 0 );
+		_free.capacity ( 0 );
+		_slots.capacity ( 0 );
+	}
+}
+
+void GsHashTableBase::rehash ( int newhsize )
+{
+	_rebuild ( slots_for ( GS_MAX(newhsize,_elements) ) );
+}
+
+int GsHashTableBase::collisions () const
+{
+	int n=0, mask=_slots.size()-1;
+	for ( int s=0; s<_slots.size(); s++ )
+	{	int id = _slots[s];
+		if ( id>=0 && int(_entries[id].hash&mask)!=s ) n++;
+	}
+	return n;
+}
+
+int GsHashTableBase::longest_entry () const
+{
+	int longest=0, mask=_slots.size()-1;
+	for ( int s=0; s<_slots.size(); s++ )
+	{	int id = _slots[s];
+		if ( id<0 ) continue;
+		int len = ( (s-int(_entries[id].hash&mask)) & mask ) + 1;
+		if ( len>longest ) longest=len;
+	}
+	return longest;
+}
+
+int GsHashTableBase::collidingid ( int id ) const
+{
+	if ( id<0 || id>=_entries.size() || !_entries[id].key ) return -1;
+	int mask = _slots.size()-1;
+	int home = int(_entries[id].hash&mask);
+	int s = home;
+	while ( _slots[s]!=id ) s=(s+1)&mask;
+	for ( s=(s+1)&mask; _slots[s]!=-1; s=(s+1)&mask )
+	{	int i = _slots[s];
+		if ( i>=0 && int(_entries[i].hash&mask)==home ) return i;
+	}
+	return -1;
+}
+
+int GsHashTableBase::_find_slot ( const char* key, gsuint h ) const
+{
+	int mask = _slots.size()-1;
+	for ( int s=h&mask; ; s=(s+1)&mask )
+	{	int id = _slots[s];
+		if ( id==-1 ) return -1;
+		if ( id>=0 && _entries[id].hash==h && samekey(_entries[id].key,key) ) return s;
+	}
+}
+
+int GsHashTableBase::lookup_index ( const char *key ) const
+{
+	if ( !key || _elements==0 ) return -1;
+	int s = _find_slot ( key, hash(key) );
+	return s<0? -1 : _slots[s];
+}
+
+void* GsHashTableBase::lookup ( const char* key ) const
+{
+	int id = lookup_index ( key );
+	return id<0? 0: _entries[id].data;
+}
+
+bool GsHashTableBase::insert ( const char *key, void* data )
+{
+	if ( !key ) { _last_id=-1; return false; }
+	if ( (_elements+_removed+1)*2>_slots.size() ) _rebuild ( slots_for(_elements+1) );
+
+	gsuint h = hash ( key );
+	int mask = _slots.size()-1;
+	int s, reuse=-1;
+	for ( s=h&mask; _slots[s]!=-1; s=(s+1)&mask )
+	{	int id = _slots[s];
+		if ( id==-2 ) { if ( reuse<0 ) reuse=s; }
+		else if ( _entries[id].hash==h && samekey(_entries[id].key,key) ) { _last_id=id; return false; }
+	}
+	if ( reuse>=0 ) { s=reuse; _removed--; }
+
+	int id;
+	if ( _free.size()>0 ) { id=_free.pop(); }
+	else { id=_entries.size(); _entries.push(); }
+	Entry& e = _entries[id];
+	if ( _key_storage==AllocatedKeys ) e.key = gs_string_new ( key );
+	else if ( _key_storage==InternedKeys ) e.key = (char*)intern ( key );
+	else e.key = (char*)key;
+	e.data = data;
+	e.hash = h;
+
+	_slots[s] = id;
+	_elements++;
+	_last_id = id;
+	return true;
+}
+
+void* GsHashTableBase::remove ( const char *key )
+{
+	if ( !key || _elements==0 ) return 0;
+	int s = _find_slot ( key, hash(key) );
+	if ( s<0 ) return 0;
+
+	int id = _slots[s];
+	Entry& e = _entries[id];
+	void* data = e.data;
+	if ( _key_storage==AllocatedKeys ) delete[] e.key;
+	e.key = 0;
+	e.data = 0;
+	_slots[s] = -2;
+	_removed++;
+	_elements--;
+	_free.push() = id;
+	return data;
+}
+
+void GsHashTableBase::_rebuild ( int nslots )
+{
+	_slots.size ( nslots );
+	_slots.setall ( -1 );
+	_removed = 0;
+	int mask = nslots-1;
+	for ( int id=0; id<_entries.size(); id++ )
+	{	if ( !_entries[id].key ) continue;
+		int s = _entries[id].hash&mask;
+		while ( _slots[s]!=-1 ) s=(s+1)&mask;
+		_slots[s] = id;
+	}
+}
+
+//================================ interned strings ===============================
+
+const char* GsHashTableBase::intern ( const char* s )
+{
+	static GsArena strings ( 16384 );
+	static GsArray<const char*> slots;
+	static int count=0;
+
+	if ( !s ) return 0;
+	if ( (count+1)*2>slots.size() ) // grow the pool
+	{	GsArray<const char*> old;
+		old.adopt ( slots );
+		slots.size ( slots_for(count+1) );
+		slots.setall ( 0 );
+		int mask = slots.size()-1;
+		for ( int i=0; i<old.size(); i++ )
+		{	if ( !old[i] ) continue;
+			int k = hash(old[i])&mask;
+			while ( slots[k] ) k=(k+1)&mask;
+			slots[k] = old[i];
+		}
+	}
+
+	int mask = slots.size()-1;
+	int k = hash(s)&mask;
+	while ( slots[k] )
+	{	if ( strcmp(slots[k],s)==0 ) return slots[k];
+		k = (k+1)&mask;
+	}
+	size_t len = strlen(s)+1;
+	char* st = (char*)strings.alloc ( len );
+	memcpy ( st, s, len );
+	slots[k] = st;
+	count++;
+	return st;
+}
+
+//============================== end of file ===============================
@@ -7,6 +7,9 @@
 
 # include <sig/gs_mat.h>
 # include <math.h>
+# ifdef GS_SSE
+# include <xmmintrin.h>
+# endif
 
 //================================== Static Data ===================================
 
@@ -309,12 +312,14 @@ void GsMat::ortho ( float left, float right, float bottom, float top, float near
 	setl4 (   0,	0,	  0,	       1        );
 }
 
-void GsMat::inverse ( GsMat& inv ) const
+void GsMat::inverse ( GsMat& minv ) const
 {
 	float d = det();
 	if (d==0.0) return;
 	d = 1.0f/d;
 
+	GsMat inv(GsMat::NoInit); // computed on the stack so that minv can be this
+
 	float m12 = E21*E32 - E22*E31;
 	float m13 = E21*E33 - E23*E31;
 	float m14 = E21*E34 - E24*E31;
@@ -344,6 +349,7 @@ void GsMat::inverse ( GsMat& inv ) const
 	inv.E23 = (E21*m34 - E23*m14 + E24*m13) * d;
 	inv.E33 = (E22*m14 - E21*m24 - E24*m12) * d;
 	inv.E43 = (E21*m23 - E22*m13 + E23*m12) * d;
+	minv = inv;
 }
 
 float GsMat::det () const
@@ -382,51 +388,102 @@ float GsMat::norm () const
 	return sqrtf ( norm2() );
 }
 
+# ifdef GS_SSE
+
+// Each line of the result is the combination of the lines of m2 weighted by the
+// elements of the same line in m1. All lines are loaded before the result is
+// stored, so that r may be m1 or m2. For affine matrices the 4th line of m2 is
+// taken as 0,0,0,E44 and the 4th line of the result is not stored.
+# define LINE(i,l4) _mm_add_ps ( _mm_add_ps ( _mm_mul_ps(_mm_set1_ps(m1.e[i*4]),l1), _mm_mul_ps(_mm_set1_ps(m1.e[i*4+1]),l2) ), \
+								 _mm_add_ps ( _mm_mul_ps(_mm_set1_ps(m1.e[i*4+2]),l3), _mm_mul_ps(_mm_set1_ps(m1.e[i*4+3]),l4) ) )
+
 void GsMat::mult ( const GsMat& m1, const GsMat& m2 )
 {
-	GsMat* m = (this==&m1||this==&m2)? new GsMat(GsMat::NoInit) : this;
+	__m128 l1 = _mm_loadu_ps ( m2.e );
+	__m128 l2 = _mm_loadu_ps ( m2.e+4 );
+	__m128 l3 = _mm_loadu_ps ( m2.e+8 );
+	__m128 l4 = _mm_loadu_ps ( m2.e+12 );
+	__m128 r1 = LINE(0,l4);
+	__m128 r2 = LINE(1,l4);
+	__m128 r3 = LINE(2,l4);
+	__m128 r4 = LINE(3,l4);
+	_mm_storeu_ps ( e, r1 );
+	_mm_storeu_ps ( e+4, r2 );
+	_mm_storeu_ps ( e+8, r3 );
+	_mm_storeu_ps ( e+12, r4 );
+}
 
-	m->setl1 ( m1.E11*m2.E11 + m1.E12*m2.E21 + m1.E13*m2.E31 + m1.E14*m2.E41,
-			   m1.E11*m2.E12 + m1.E12*m2.E22 + m1.E13*m2.E32 + m1.E14*m2.E42,
-			   m1.E11*m2.E13 + m1.E12*m2.E23 + m1.E13*m2.E33 + m1.E14*m2.E43,
-			   m1.E11*m2.E14 + m1.E12*m2.E24 + m1.E13*m2.E34 + m1.E14*m2.E44 );
+void GsMat::multaff ( const GsMat& m1, const GsMat& m2 )
+{
+	__m128 l1 = _mm_loadu_ps ( m2.e );
+	__m128 l2 = _mm_loadu_ps ( m2.e+4 );
+	__m128 l3 = _mm_loadu_ps ( m2.e+8 );
+	__m128 t4 = _mm_setr_ps ( 0, 0, 0, m2.E44 );
+	__m128 r1 = LINE(0,t4);
+	__m128 r2 = LINE(1,t4);
+	__m128 r3 = LINE(2,t4);
+	_mm_storeu_ps ( e, r1 );
+	_mm_storeu_ps ( e+4, r2 );
+	_mm_storeu_ps ( e+8, r3 );
+}
+
+# undef LINE
+
+# else
 
-	m->setl2 ( m1.E21*m2.E11 + m1.E22*m2.E21 + m1.E23*m2.E31 + m1.E24*m2.E41,
-			   m1.E21*m2.E12 + m1.E22*m2.E22 + m1.E23*m2.E32 + m1.E24*m2.E42,
-			   m1.E21*m2.E13 + m1.E22*m2.E23 + m1.E23*m2.E33 + m1.E24*m2.E43,
-			   m1.E21*m2.E14 + m1.E22*m2.E24 + m1.E23*m2.E34 + m1.E24*m2.E44 );
+void GsMat::mult ( const GsMat& m1, const GsMat& m2 )
+{
+	GsMat m(GsMat::NoInit); // computed on the stack so that m1 or m2 can be this
 
-	m->setl3 ( m1.E31*m2.E11 + m1.E32*m2.E21 + m1.E33*m2.E31 + m1.E34*m2.E41,
-			   m1.E31*m2.E12 + m1.E32*m2.E22 + m1.E33*m2.E32 + m1.E34*m2.E42,
-			   m1.E31*m2.E13 + m1.E32*m2.E23 + m1.E33*m2.E33 + m1.E34*m2.E43,
-			   m1.E31*m2.E14 + m1.E32*m2.E24 + m1.E33*m2.E34 + m1.E34*m2.E44 );
+	m.setl1 ( m1.E11*m2.E11 + m1.E12*m2.E21 + m1.E13*m2.E31 + m1.E14*m2.E41,
+			  m1.E11*m2.E12 + m1.E12*m2.E22 + m1.E13*m2.E32 + m1.E14*m2.E42,
+			  m1.E11*m2.E13 + m1.E12*m2.E23 + m1.E13*m2.E33 + m1.E14*m2.E43,
+			  m1.E11*m2.E14 + m1.E12*m2.E24 + m1.E13*m2.E34 + m1.E14*m2.E44 );
 
-	m->setl4 ( m1.E41*m2.E11 + m1.E42*m2.E21 + m1.E43*m2.E31 + m1.E44*m2.E41,
-			   m1.E41*m2.E12 + m1.E42*m2.E22 + m1.E43*m2.E32 + m1.E44*m2.E42,
-			   m1.E41*m2.E13 + m1.E42*m2.E23 + m1.E43*m2.E33 + m1.E44*m2.E43,
-			   m1.E41*m2.E14 + m1.E42*m2.E24 + m1.E43*m2.E34 + m1.E44*m2.E44 );
+	m.setl2 ( m1.E21*m2.E11 + m1.E22*m2.E21 + m1.E23*m2.E31 + m1.E24*m2.E41,
+			  m1.E21*m2.E12 + m1.E22*m2.E22 + m1.E23*m2.E32 + m1.E24*m2.E42,
+			  m1.E21*m2.E13 + m1.E22*m2.E23 + m1.E23*m2.E33 + m1.E24*m2.E43,
+			  m1.E21*m2.E14 + m1.E22*m2.E24 + m1.E23*m2.E34 + m1.E24*m2.E44 );
 
-	if ( m!=this ) { *this=*m; delete m; }
+	m.setl3 ( m1.E31*m2.E11 + m1.E32*m2.E21 + m1.E33*m2.E31 + m1.E34*m2.E41,
+			  m1.E31*m2.E12 + m1.E32*m2.E22 + m1.E33*m2.E32 + m1.E34*m2.E42,
+			  m1.E31*m2.E13 + m1.E32*m2.E23 + m1.E33*m2.E33 + m1.E34*m2.E43,
+			  m1.E31*m2.E14 + m1.E32*m2.E24 + m1.E33*m2.E34 + m1.E34*m2.E44 );
+
+	m.setl4 ( m1.E41*m2.E11 + m1.E42*m2.E21 + m1.E43*m2.E31 + m1.E44*m2.E41,
+			  m1.E41*m2.E12 + m1.E42*m2.E22 + m1.E43*m2.E32 + m1.E44*m2.E42,
+			  m1.E41*m2.E13 + m1.E42*m2.E23 + m1.E43*m2.E33 + m1.E44*m2.E43,
+			  m1.E41*m2.E14 + m1.E42*m2.E24 + m1.E43*m2.E34 + m1.E44*m2.E44 );
+
+	*this = m;
 }
 
 void GsMat::multaff ( const GsMat& m1, const GsMat& m2 )
 {
-	setl1 ( m1.E11*m2.E11 + m1.E12*m2.E21 + m1.E13*m2.E31,
-			m1.E11*m2.E12 + m1.E12*m2.E22 + m1.E13*m2.E32,
-			m1.E11*m2.E13 + m1.E12*m2.E23 + m1.E13*m2.E33,
-			m1.E11*m2.E14 + m1.E12*m2.E24 + m1.E13*m2.E34 + m1.E14*m2.E44 );
+	GsMat m(GsMat::NoInit); // computed on the stack so that m1 or m2 can be this
+
+	m.setl1 ( m1.E11*m2.E11 + m1.E12*m2.E21 + m1.E13*m2.E31,
+			  m1.E11*m2.E12 + m1.E12*m2.E22 + m1.E13*m2.E32,
+			  m1.E11*m2.E13 + m1.E12*m2.E23 + m1.E13*m2.E33,
+			  m1.E11*m2.E14 + m1.E12*m2.E24 + m1.E13*m2.E34 + m1.E14*m2.E44 );
 
-	setl2 ( m1.E21*m2.E11 + m1.E22*m2.E21 + m1.E23*m2.E31,
-			m1.E21*m2.E12 + m1.E22*m2.E22 + m1.E23*m2.E32,
-			m1.E21*m2.E13 + m1.E22*m2.E23 + m1.E23*m2.E33,
-			m1.E21*m2.E14 + m1.E22*m2.E24 + m1.E23*m2.E34 + m1.E24*m2.E44 );
+	m.setl2 ( m1.E21*m2.E11 + m1.E22*m2.E21 + m1.E23*m2.E31,
+			  m1.E21*m2.E12 + m1.E22*m2.E22 + m1.E23*m2.E32,
+			  m1.E21*m2.E13 + m1.E22*m2.E23 + m1.E23*m2.E33,
+			  m1.E21*m2.E14 + m1.E22*m2.E24 + m1.E23*m2.E34 + m1.E24*m2.E44 );
 
-	setl3 ( m1.E31*m2.E11 + m1.E32*m2.E21 + m1.E33*m2.E31,
-			m1.E31*m2.E12 + m1.E32*m2.E22 + m1.E33*m2.E32,
-			m1.E31*m2.E13 + m1.E32*m2.E23 + m1.E33*m2.E33,
-			m1.E31*m2.E14 + m1.E32*m2.E24 + m1.E33*m2.E34 + m1.E34*m2.E44 );
+	m.setl3 ( m1.E31*m2.E11 + m1.E32*m2.E21 + m1.E33*m2.E31,
+			  m1.E31*m2.E12 + m1.E32*m2.E22 + m1.E33*m2.E32,
+			  m1.E31*m2.E13 + m1.E32*m2.E23 + m1.E33*m2.E33,
+			  m1.E31*m2.E14 + m1.E32*m2.E24 + m1.E33*m2.E34 + m1.E34*m2.E44 );
+
+	setl1 ( m.E11, m.E12, m.E13, m.E14 );
+	setl2 ( m.E21, m.E22, m.E23, m.E24 );
+	setl3 ( m.E31, m.E32, m.E33, m.E34 );
 }
 
+# endif // GS_SSE
+
 void GsMat::add ( const GsMat& m1, const GsMat& m2 )
 {
 	setl1 ( m1.E11+m2.E11, m1.E12+m2.E12, m1.E13+m2.E13, m1.E14+m2.E14 );
@@ -467,29 +524,7 @@ void GsMat::operator *= ( float r )
 
 void GsMat::operator *= ( const GsMat& m )
 {
-	GsMat* t = (this==&m)? new GsMat(GsMat::NoInit) : this;
-
-	t->setl1 ( E11*m.E11 + E12*m.E21 + E13*m.E31 + E14*m.E41,
-			   E11*m.E12 + E12*m.E22 + E13*m.E32 + E14*m.E42,
-			   E11*m.E13 + E12*m.E23 + E13*m.E33 + E14*m.E43,
-			   E11*m.E14 + E12*m.E24 + E13*m.E34 + E14*m.E44 );
-
-	t->setl2 ( E21*m.E11 + E22*m.E21 + E23*m.E31 + E24*m.E41,
-			   E21*m.E12 + E22*m.E22 + E23*m.E32 + E24*m.E42,
-			   E21*m.E13 + E22*m.E23 + E23*m.E33 + E24*m.E43,
-			   E21*m.E14 + E22*m.E24 + E23*m.E34 + E24*m.E44 );
-
-	t->setl3 ( E31*m.E11 + E32*m.E21 + E33*m.E31 + E34*m.E41,
-			   E31*m.E12 + E32*m.E22 + E33*m.E32 + E34*m.E42,
-			   E31*m.E13 + E32*m.E23 + E33*m.E33 + E34*m.E43,
-			   E31*m.E14 + E32*m.E24 + E33*m.E34 + E34*m.E44 );
-
-	t->setl4 ( E41*m.E11 + E42*m.E21 + E43*m.E31 + E44*m.E41,
-			   E41*m.E12 + E42*m.E22 + E43*m.E32 + E44*m.E42,
-			   E41*m.E13 + E42*m.E23 + E43*m.E33 + E44*m.E43,
-			   E41*m.E14 + E42*m.E24 + E43*m.E34 + E44*m.E44 );
-
-	if ( t!=this ) { *this=*t; delete t; }
+	mult ( *this, m );
 }
 
 void GsMat::operator += ( const GsMat& m )
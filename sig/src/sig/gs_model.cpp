@@ -29,12 +29,13 @@ void GsModel::Group::copy ( const Group& g )
 {
 	fi = g.fi;
 	fn = g.fn;
-	mtlname = g.mtlname;
+	mtlname.set ( g.mtlname ); // GsCharPt strings have to be duplicated
 	if ( !g.dmap )
 	{	delete dmap; dmap=0; }
 	else
 	{	if ( !dmap ) dmap = new Texture;
-		*dmap = *g.dmap; // copy operator
+		dmap->id = g.dmap->id;
+		dmap->fname.set ( g.dmap->fname );
 	}
 };
 
@@ -139,15 +140,16 @@ void GsModel::operator = ( const GsModel& m )
    T = m.T;
    F = m.F;
    Fn = m.Fn;
-   Ft = m.Fn;
+   Ft = m.Ft;
 
    name = m.name;
    filename = m.filename;
 
    clear_groups();
-   
+   for ( int i=0; i<m.G.size(); i++ ) G.push()->copy ( *m.G[i] );
 
    culling = m.culling;
+   textured = m.textured;
    _geomode = m._geomode;
    _mtlmode = m._mtlmode;
 
@@ -0,0 +1,99 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_model_lod.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+//================================ GsModelLod ==================================
+
+GsModelLod::GsModelLod ()
+{
+	_radius = 0;
+}
+
+GsModelLod::GsModelLod ( GsModel* m )
+{
+	_radius = 0;
+	build ( m );
+}
+
+GsModelLod::~GsModelLod ()
+{
+	init ();
+}
+
+void GsModelLod::init ()
+{
+	while ( _levels.size() ) _levels.pop()->unref();
+	_minsize.size ( 0 );
+	_center = GsPnt::null;
+	_radius = 0;
+}
+
+void GsModelLod::build ( GsModel* m, int maxlevels, float ratio, int minfaces )
+{
+	m->ref(); // in case m is already in the chain
+	init ();
+	_levels.push() = m;
+
+	GsBox box;
+	m->get_bounding_box ( box );
+	_center = box.center();
+	_radius = box.empty()? 0 : dist(box.a,box.b)/2.0f;
+
+	float target = float ( m->F.size() );
+	while ( _levels.size()<maxlevels )
+	{	target *= ratio;
+		if ( target<minfaces ) break;
+		GsModel* l = new GsModel;
+		*l = *m; // the file name is kept to locate textures
+		int nf = l->simplify ( int(target) );
+		if ( nf>=_levels.top()->F.size() ) { delete l; break; } // no more simplification
+		GS_TRACE1 ( "Level "<<_levels.size()<<": "<<nf<<" faces" );
+		l->ref();
+		_levels.push() = l;
+	}
+
+	detail ( 0.5f );
+}
+
+void GsModelLod::detail ( float s )
+{
+	int n = _levels.size();
+	_minsize.size ( n );
+	if ( n==0 ) return;
+	float f0 = float ( GS_MAX(_levels[0]->F.size(),1) );
+	for ( int i=0; i<n; i++ ) _minsize[i] = s * sqrtf ( float(_levels[i]->F.size())/f0 );
+	_minsize[n-1] = 0;
+}
+
+float GsModelLod::projected_size ( const GsMat& proj, const GsMat& modelview ) const
+{
+	const GsMat& m = modelview;
+	GsPnt c = m * _center;
+
+	// largest scaling factor of the linear part of the modelview:
+	float s = GS_MAX ( m.e11*m.e11 + m.e21*m.e21 + m.e31*m.e31, m.e12*m.e12 + m.e22*m.e22 + m.e32*m.e32 );
+	s = sqrtf ( GS_MAX ( s, m.e13*m.e13 + m.e23*m.e23 + m.e33*m.e33 ) );
+
+	// w is the distance to the eye with a perspective projection, and 1 with an orthographic one:
+	float w = proj.e41*c.x + proj.e42*c.y + proj.e43*c.z + proj.e44;
+	if ( w<=gstiny ) return 1.0E10f; // eye inside or in front of the sphere center
+	return _radius * s * proj.e22 / w;
+}
+
+int GsModelLod::select ( float size ) const
+{
+	int n = _minsize.size();
+	for ( int i=0; i<n; i++ ) if ( size>=_minsize[i] ) return i;
+	return n-1;
+}
+
+//============================== end of file ===============================
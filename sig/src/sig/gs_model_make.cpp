@@ -26,7 +26,7 @@ void GsModel::make_sweep ( const GsPolygon& pol, const GsVec& v )
 	name = "sweep";
 
 	GsArray<int> t;
-	pol.ear_triangulation ( t );
+	pol.triangulation ( t );
 
 	int i;
 	//for ( i=0; i<tris.size(); i++ ) t.push() = p.pick_vertex(tris[i],gstiny,true/*first*/);
@@ -0,0 +1,201 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <string.h>
+# include <sig/gs_model_registry.h>
+
+//# define GS_USE_TRACE1 // load and add
+# include <sig/gs_trace.h>
+
+//================================== helpers ====================================
+
+// FNV-1a hash accumulation
+static void fnv ( gsuint64& h, const void* data, int size )
+{
+	const gsbyte* b = (const gsbyte*)data;
+	for ( int i=0; i<size; i++ ) { h^=b[i]; h*=1099511628211ULL; }
+}
+
+template <class X>
+static void fnv ( gsuint64& h, const GsArray<X>& a )
+{
+	int s = a.size();
+	fnv ( h, &s, sizeof(int) );
+	fnv ( h, a.pt(), a.sizeofarray() );
+}
+
+static void fnv ( gsuint64& h, const char* st )
+{
+	if ( st ) fnv ( h, st, (int)strlen(st)+1 ); else fnv ( h, "", 1 );
+}
+
+template <class X>
+static bool same ( const GsArray<X>& a, const GsArray<X>& b )
+{
+	return a.size()==b.size() && memcmp(a.pt(),b.pt(),a.sizeofarray())==0;
+}
+
+static bool same ( const char* a, const char* b )
+{
+	if ( !a || !b ) return a==b;
+	return gs_comparecs(a,b)==0;
+}
+
+//============================== GsModelRegistry ================================
+
+GsModelRegistry::GsModelRegistry ( bool bycontent )
+{
+	_files.init ( 256 );
+	_hashes.init ( 256 );
+	_bycontent = bycontent;
+}
+
+GsModelRegistry::~GsModelRegistry ()
+{
+	init ();
+}
+
+void GsModelRegistry::init ()
+{
+	for ( int i=0; i<_models.size(); i++ ) _models[i]->unref();
+	_models.size ( 0 );
+	_files.init ( 256 );
+	_hashes.init ( 256 );
+}
+
+void GsModelRegistry::_key ( const char* filename, GsString& key )
+{
+	key = filename;
+	for ( int i=0; i<key.len(); i++ ) if ( key[i]=='\\' ) key[i]='/';
+}
+
+void GsModelRegistry::_key ( gsuint64 hash, GsString& key )
+{
+	key.setf ( "%08x%08x", gsuint32(hash>>32), gsuint32(hash) );
+}
+
+GsModel* GsModelRegistry::get ( const char* filename ) const
+{
+	GsString key;
+	_key ( filename, key );
+	return _files.lookup ( key );
+}
+
+GsModel* GsModelRegistry::load ( const char* filename )
+{
+	GsModel* m = get ( filename );
+	if ( m ) return m;
+
+	GS_TRACE1 ( "Loading " << filename );
+	m = new GsModel;
+	if ( !m->load(filename) ) { delete m; return 0; }
+	return add ( m );
+}
+
+GsModel* GsModelRegistry::_find ( GsModel* m, gsuint64 h ) const
+{
+	GsString key;
+	_key ( h, key );
+	GsModel* e = _hashes.lookup ( key );
+	return e && ( e==m || equal(*e,*m) )? e : 0;
+}
+
+GsModel* GsModelRegistry::add ( GsModel* m )
+{
+	m->ref();
+
+	GsString fkey;
+	if ( m->filename.len() )
+	{	_key ( m->filename, fkey );
+		GsModel* e = _files.lookup ( fkey );
+		if ( e ) { m->unref(); return e; }
+	}
+
+	if ( _bycontent )
+	{	gsuint64 h = hash ( *m );
+		GsModel* e = _find ( m, h );
+		if ( e )
+		{	GS_TRACE1 ( "Sharing model with equal contents" );
+			if ( fkey.len() ) _files.insert ( fkey, e );
+			m->unref();
+			return e;
+		}
+		GsString hkey;
+		_key ( h, hkey );
+		_hashes.insert ( hkey, m ); // fails in the rare case of a hash collision
+	}
+
+	if ( fkey.len() ) _files.insert ( fkey, m );
+	for ( int i=0; i<_models.size(); i++ )
+	{	if ( _models[i]==m ) { m->unref(); return m; } // was already in the registry
+	}
+	_models.push() = m; // keeps the reference
+	return m;
+}
+
+int GsModelRegistry::purge ()
+{
+	int i, k, count=0;
+	GsStrings keys;
+	for ( i=0; i<_models.size(); i++ )
+	{	GsModel* m = _models[i];
+		if ( m->getref()>1 ) continue;
+
+		keys.size ( 0 );
+		for ( k=0; k<_files.size(); k++ ) if ( _files.key(k) && _files.data(k)==m ) keys.push ( _files.key(k) );
+		for ( k=0; k<keys.size(); k++ ) _files.remove ( keys[k] );
+		keys.size ( 0 );
+		for ( k=0; k<_hashes.size(); k++ ) if ( _hashes.key(k) && _hashes.data(k)==m ) keys.push ( _hashes.key(k) );
+		for ( k=0; k<keys.size(); k++ ) _hashes.remove ( keys[k] );
+
+		m->unref();
+		_models[i] = _models.pop();
+		i--; count++;
+	}
+	return count;
+}
+
+gsuint64 GsModelRegistry::hash ( const GsModel& m )
+{
+	gsuint64 h = 14695981039346656037ULL;
+	fnv ( h, m.V ); fnv ( h, m.N ); fnv ( h, m.F ); fnv ( h, m.Fn );
+	fnv ( h, m.T ); fnv ( h, m.Ft ); fnv ( h, m.M );
+	gsbyte modes[4] = { (gsbyte)m.geomode(), (gsbyte)m.mtlmode(), m.culling, m.textured };
+	fnv ( h, modes, 4 );
+	for ( int i=0; i<m.G.size(); i++ )
+	{	const GsModel::Group& g = *m.G[i];
+		fnv ( h, &g.fi, sizeof(int) );
+		fnv ( h, &g.fn, sizeof(int) );
+		fnv ( h, g.mtlname );
+		fnv ( h, g.dmap? (const char*)g.dmap->fname : 0 );
+	}
+	return h;
+}
+
+bool GsModelRegistry::equal ( const GsModel& a, const GsModel& b )
+{
+	if ( a.geomode()!=b.geomode() || a.mtlmode()!=b.mtlmode() ) return false;
+	if ( a.culling!=b.culling || a.textured!=b.textured ) return false;
+	if ( !same(a.V,b.V) || !same(a.N,b.N) || !same(a.F,b.F) || !same(a.Fn,b.Fn) ) return false;
+	if ( !same(a.T,b.T) || !same(a.Ft,b.Ft) || !same(a.M,b.M) ) return false;
+	if ( a.G.size()!=b.G.size() ) return false;
+	for ( int i=0; i<a.G.size(); i++ )
+	{	const GsModel::Group& ga = *a.G[i];
+		const GsModel::Group& gb = *b.G[i];
+		if ( ga.fi!=gb.fi || ga.fn!=gb.fn || !same(ga.mtlname,gb.mtlname) ) return false;
+		if ( !same ( ga.dmap? (const char*)ga.dmap->fname:0, gb.dmap? (const char*)gb.dmap->fname:0 ) ) return false;
+	}
+	return true;
+}
+
+GsModelRegistry& GsModelRegistry::shared ()
+{
+	static GsModelRegistry r;
+	return r;
+}
+
+//============================== end of file ===============================
@@ -0,0 +1,442 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_heap.h>
+
+//# define GS_USE_TRACE1 // simplification
+# include <sig/gs_trace.h>
+
+//================================== Quadric ====================================
+
+// Symmetric 4x4 error quadric of Garland and Heckbert, kept in double precision
+struct Quadric
+{	double a[10]; // aa ab ac ad bb bc bd cc cd dd
+
+	void zero () { for ( int i=0; i<10; i++ ) a[i]=0; }
+
+	void add_plane ( double x, double y, double z, double d, double w )
+	{	a[0]+=w*x*x; a[1]+=w*x*y; a[2]+=w*x*z; a[3]+=w*x*d;
+		a[4]+=w*y*y; a[5]+=w*y*z; a[6]+=w*y*d;
+		a[7]+=w*z*z; a[8]+=w*z*d; a[9]+=w*d*d;
+	}
+
+	void operator += ( const Quadric& q ) { for ( int i=0; i<10; i++ ) a[i]+=q.a[i]; }
+
+	double error ( const GsPnt& p ) const
+	{	double x=p.x, y=p.y, z=p.z;
+		return a[0]*x*x + 2*(a[1]*x*y + a[2]*x*z + a[3]*x) +
+			   a[4]*y*y + 2*(a[5]*y*z + a[6]*y) +
+			   a[7]*z*z + 2*a[8]*z + a[9];
+	}
+};
+
+//================================== Simplifier ====================================
+
+// Weight of the planes added to the quadrics to keep the shape of feature lines
+# define FEATURE_WEIGHT 100.0
+
+// Collapse of vertex u into vertex v, valid while the stamps of both are unchanged
+struct Collapse { int u, v, su, sv; };
+
+static inline int* corners ( GsModel::Face& f ) { return &f.a; }
+
+// Edge (u,w) around a vertex u, with the fan indices of the faces sharing it
+struct FanEdge { int w, i1, i2, n; };
+
+// Edge collapse simplification keeping the corners of the faces linked per
+// vertex, where corner c is corner c%3 of face c/3. Faces around a vertex are
+// separated in arcs by feature edges: borders, seams, creases and borders between
+// materials. A vertex with no feature edges, or in the middle of a feature line,
+// can be collapsed into a neighbor, and the corners of each arc then receive the
+// attributes of the neighbor in the same arc.
+struct Simplifier
+{	GsModel& m;
+	GsArray<Quadric> Q;
+	GsArray<int> head;		// first corner of each vertex, or -1
+	GsArray<int> next;		// next corner of the same vertex, or -1
+	GsArray<int> stamp;		// incremented when the quadric or the position of a collapse changes
+	GsArray<int> mark;		// marks used to find common neighbors
+	GsArray<int> fgroup;	// group of each face, or -1
+	GsArray<gscbool> dead;	// removed faces
+	GsArray<int> fan;		// alive corners of the vertex being tested
+	GsArray<int> arc;		// union-find parent of each fan corner, giving its arc
+	GsArray<int> src;		// corner of v giving the attributes of each arc
+	GsArray<FanEdge> edges;	// edges of the vertex being tested
+	GsHeap<Collapse,double> heap;
+	int curmark;
+	int faces;				// number of faces not removed
+	bool pernormal, pertexture;
+
+	Simplifier ( GsModel& model ) : m(model) {}
+
+	bool sameclass ( int f1, int f2 ) const
+	{	if ( fgroup[f1]!=fgroup[f2] ) return false;
+		if ( m.mtlmode()==GsModel::PerFaceMtl ) return m.M[f1].diffuse==m.M[f2].diffuse;
+		return true;
+	}
+
+	bool sameattributes ( int c1, int c2 ) // checks if two corners of a same vertex have the same attributes
+	{	int f1=c1/3, f2=c2/3, k1=c1%3, k2=c2%3;
+		if ( pernormal && m.N[corners(m.Fn[f1])[k1]]!=m.N[corners(m.Fn[f2])[k2]] ) return false;
+		if ( pertexture && m.T[corners(m.Ft[f1])[k1]]!=m.T[corners(m.Ft[f2])[k2]] ) return false;
+		return true;
+	}
+
+	int corner ( int f, int v ) // corner of vertex v in face f, or -1
+	{	int* fc = corners(m.F[f]);
+		return fc[0]==v? f*3 : fc[1]==v? f*3+1 : fc[2]==v? f*3+2 : -1;
+	}
+
+	int root ( int i ) { while ( arc[i]!=i ) i=arc[i]; return i; }
+
+	bool feature ( const FanEdge& e )
+	{	if ( e.n!=2 ) return true;
+		int c1=fan[e.i1], c2=fan[e.i2];
+		if ( !sameclass(c1/3,c2/3) ) return true;
+		return !sameattributes(c1,c2) || !sameattributes(corner(c1/3,e.w),corner(c2/3,e.w));
+	}
+
+	void init ();
+	bool getfan ( int u );
+	void push ( int a, int b );
+	bool valid ( int u, int v );
+	void collapse ( int u, int v );
+	void compact ();
+};
+
+void Simplifier::init ()
+{
+	int f, k, v;
+	const int fsize=m.F.size(), vsize=m.V.size();
+	pernormal = m.Fn.size()==fsize && m.N.size()>0;
+	pertexture = m.Ft.size()==fsize && m.T.size()>0;
+	faces = fsize;
+	curmark = 0;
+
+	// groups and dead faces:
+	fgroup.size ( fsize );
+	fgroup.setall ( -1 );
+	if ( m.mtlmode()==GsModel::PerGroupMtl )
+	{	for ( int g=0; g<m.G.size(); g++ )
+		{	const GsModel::Group& G = *m.G[g];
+			for ( f=G.fi; f<G.fi+G.fn && f<fsize; f++ ) fgroup[f]=g;
+		}
+	}
+	dead.size ( fsize );
+	dead.setall ( 0 );
+
+	// quadrics weighted by face areas and lists of corners:
+	Q.size ( vsize );
+	for ( v=0; v<vsize; v++ ) Q[v].zero();
+	head.size ( vsize );
+	head.setall ( -1 );
+	next.size ( fsize*3 );
+	for ( f=0; f<fsize; f++ )
+	{	GsModel::Face& F = m.F[f];
+		GsVec n = cross ( m.V[F.b]-m.V[F.a], m.V[F.c]-m.V[F.a] );
+		float len = n.norm();
+		if ( len>0 )
+		{	n /= len;
+			double d = -dot ( n, m.V[F.a] );
+			for ( k=0; k<3; k++ ) Q[corners(F)[k]].add_plane ( n.x, n.y, n.z, d, 0.5*len );
+		}
+		for ( k=0; k<3; k++ )
+		{	v = corners(F)[k];
+			next[f*3+k] = head[v];
+			head[v] = f*3+k;
+		}
+	}
+
+	// planes perpendicular to the faces along feature edges keep feature lines in place:
+	for ( v=0; v<vsize; v++ )
+	{	if ( !getfan(v) ) continue;
+		for ( int e=0; e<edges.size(); e++ )
+		{	if ( !feature(edges[e]) ) continue;
+			const GsPnt& p = m.V[v];
+			GsVec ev = m.V[edges[e].w]-p;
+			for ( int i=0; i<edges[e].n; i++ )
+			{	GsVec n = cross ( ev, m.face_normal(fan[i? edges[e].i2:edges[e].i1]/3) );
+				float len = n.norm();
+				if ( len==0 ) continue;
+				n /= len;
+				Q[v].add_plane ( n.x, n.y, n.z, -dot(n,p), FEATURE_WEIGHT*ev.norm2() );
+			}
+		}
+	}
+
+	stamp.size ( vsize );
+	stamp.setall ( 0 );
+	mark.size ( vsize );
+	mark.setall ( 0 );
+
+	// initial collapses in both directions of each edge:
+	heap.init ();
+	heap.capacity ( fsize*4 );
+	for ( f=0; f<fsize; f++ )
+	{	int* c = corners(m.F[f]);
+		for ( k=0; k<3; k++ )
+		{	int a=c[k], b=c[(k+1)%3];
+			if ( a<b ) push ( a, b );
+		}
+	}
+}
+
+// Collects the alive corners and the edges around u, returning false if u has non-manifold edges
+bool Simplifier::getfan ( int u )
+{
+	int c, e, k;
+	fan.size ( 0 );
+	edges.size ( 0 );
+	for ( c=head[u]; c>=0; c=next[c] )
+	{	if ( dead[c/3] ) continue;
+		int i = fan.size();
+		fan.push() = c;
+		int* fc = corners(m.F[c/3]);
+		for ( k=1; k<=2; k++ ) // the two other vertices of the face
+		{	int w = fc[(c%3+k)%3];
+			for ( e=0; e<edges.size(); e++ ) if ( edges[e].w==w ) break;
+			if ( e==edges.size() ) { FanEdge& ne=edges.push(); ne.w=w; ne.i1=i; ne.i2=-1; ne.n=0; }
+			FanEdge& fe = edges[e];
+			if ( ++fe.n==2 ) fe.i2=i;
+			if ( fe.n>2 ) return false;
+		}
+	}
+	return true;
+}
+
+void Simplifier::push ( int a, int b )
+{
+	Collapse col;
+	double e = Q[a].error(m.V[b]) + Q[b].error(m.V[b]);
+	col.u=a; col.v=b; col.su=stamp[a]; col.sv=stamp[b];
+	heap.insert ( col, e );
+	e = Q[a].error(m.V[a]) + Q[b].error(m.V[a]);
+	col.u=b; col.v=a; col.su=stamp[b]; col.sv=stamp[a];
+	heap.insert ( col, e );
+}
+
+bool Simplifier::valid ( int u, int v )
+{
+	int c, e, i, common=0;
+	if ( !getfan(u) ) return false;
+
+	// u must have no feature edges or be in the middle of a feature line going to v:
+	int nfeatures=0, ev=-1;
+	for ( e=0; e<edges.size(); e++ )
+	{	if ( edges[e].w==v ) ev=e;
+		if ( feature(edges[e]) ) nfeatures++;
+	}
+	if ( ev<0 ) return false;
+	if ( nfeatures!=0 && ( nfeatures!=2 || !feature(edges[ev]) ) ) return false;
+
+	// link condition: u and v must have as many common neighbors as shared faces
+	curmark += 2;
+	for ( e=0; e<edges.size(); e++ ) mark[edges[e].w]=curmark;
+	for ( c=head[v]; c>=0; c=next[c] )
+	{	if ( dead[c/3] ) continue;
+		int* fc = corners(m.F[c/3]);
+		for ( int k=0; k<3; k++ )
+		{	int w = fc[k];
+			if ( w==u || w==v || mark[w]!=curmark ) continue;
+			mark[w] = curmark+1;
+			common++;
+		}
+	}
+	if ( common!=edges[ev].n ) return false;
+
+	// faces moving with u must not duplicate faces of v, as when collapsing a tetrahedron:
+	for ( i=0; i<fan.size(); i++ )
+	{	int* fc = corners(m.F[fan[i]/3]);
+		if ( fc[0]==v || fc[1]==v || fc[2]==v ) continue;
+		int a=fc[(fan[i]%3+1)%3], b=fc[(fan[i]%3+2)%3];
+		for ( c=head[v]; c>=0; c=next[c] )
+		{	if ( dead[c/3] ) continue;
+			int* gc = corners(m.F[c/3]);
+			if ( ( gc[0]==a || gc[1]==a || gc[2]==a ) && ( gc[0]==b || gc[1]==b || gc[2]==b ) ) return false;
+		}
+	}
+
+	// faces moving with u must not flip:
+	const GsPnt& p = m.V[v];
+	for ( i=0; i<fan.size(); i++ )
+	{	c = fan[i];
+		int* fc = corners(m.F[c/3]);
+		if ( fc[0]==v || fc[1]==v || fc[2]==v ) continue;
+		const GsPnt& p1 = m.V[fc[(c%3+1)%3]];
+		const GsPnt& p2 = m.V[fc[(c%3+2)%3]];
+		GsVec n1 = cross ( p1-m.V[u], p2-m.V[u] );
+		GsVec n2 = cross ( p1-p, p2-p );
+		float l1=n1.norm(), l2=n2.norm();
+		if ( l1==0 ) continue;
+		if ( l2==0 || dot(n1,n2)<0.2f*l1*l2 ) return false;
+	}
+
+	// each arc must have a face with edge (u,v) giving the attributes of v:
+	arc.size ( fan.size() );
+	src.size ( fan.size() );
+	for ( i=0; i<fan.size(); i++ ) { arc[i]=i; src[i]=-1; }
+	for ( e=0; e<edges.size(); e++ )
+	{	if ( feature(edges[e]) ) continue;
+		int r1=root(edges[e].i1), r2=root(edges[e].i2);
+		if ( r1!=r2 ) arc[r2]=r1;
+	}
+	for ( i=0; i<fan.size(); i++ )
+	{	int cv = corner ( fan[i]/3, v );
+		if ( cv>=0 ) src[root(i)]=cv;
+	}
+	for ( i=0; i<fan.size(); i++ ) if ( src[root(i)]<0 ) return false;
+	return true;
+}
+
+// Collapses u into v using the fan data computed by the last call to valid()
+void Simplifier::collapse ( int u, int v )
+{
+	int c, i, last=-1;
+
+	for ( i=0; i<fan.size(); i++ )
+	{	c = fan[i];
+		int f=c/3, k=c%3, *fc=corners(m.F[f]);
+		if ( fc[0]==v || fc[1]==v || fc[2]==v ) { dead[f]=1; faces--; continue; }
+		int cv = src[root(i)];
+		fc[k] = v;
+		if ( pernormal ) corners(m.Fn[f])[k] = corners(m.Fn[cv/3])[cv%3];
+		if ( pertexture ) corners(m.Ft[f])[k] = corners(m.Ft[cv/3])[cv%3];
+	}
+
+	// corners of u now belong to v:
+	for ( c=head[u]; c>=0; c=next[c] ) last=c;
+	if ( last>=0 ) { next[last]=head[v]; head[v]=head[u]; }
+	head[u] = -1;
+	Q[v] += Q[u];
+	stamp[u]++;
+	stamp[v]++;
+
+	// collapses of the edges around v have new costs:
+	curmark += 2;
+	mark[v] = curmark;
+	for ( c=head[v]; c>=0; c=next[c] )
+	{	if ( dead[c/3] ) continue;
+		int* fc = corners(m.F[c/3]);
+		for ( int k=0; k<3; k++ )
+		{	int w = fc[k];
+			if ( mark[w]==curmark ) continue;
+			mark[w] = curmark;
+			push ( v, w );
+		}
+	}
+}
+
+// Removes the elements of A which are not indexed by I
+template <class X>
+static void compact_indexed ( GsArray<X>& A, GsArray<GsModel::Face>& I, GsArray<int>& map )
+{
+	int i, k, n;
+	map.size ( A.size() );
+	map.setall ( -1 );
+	for ( i=0; i<I.size(); i++ ) for ( k=0; k<3; k++ ) map[corners(I[i])[k]]=0;
+	for ( n=0, i=0; i<A.size(); i++ )
+	{	if ( map[i]<0 ) continue;
+		map[i] = n;
+		A[n++] = A[i];
+	}
+	A.size ( n );
+	for ( i=0; i<I.size(); i++ ) for ( k=0; k<3; k++ ) corners(I[i])[k] = map[corners(I[i])[k]];
+}
+
+// Removes dead faces and unused vertices, normals and texture coordinates.
+// All maps are increasing so that the arrays are compacted in place.
+void Simplifier::compact ()
+{
+	int i, k, n;
+	const int fsize=m.F.size(), vsize=m.V.size();
+	GsModel::MtlMode mtlmode = m.mtlmode();
+
+	// per-vertex data:
+	GsArray<int> map ( vsize );
+	map.setall ( -1 );
+	for ( i=0; i<fsize; i++ )
+	{	if ( dead[i] ) continue;
+		for ( k=0; k<3; k++ ) map[corners(m.F[i])[k]]=0;
+	}
+	bool nv = !pernormal && m.N.size()==vsize && m.geomode()!=GsModel::Flat;
+	bool tv = !pertexture && m.T.size()==vsize;
+	bool mv = ( mtlmode==GsModel::PerVertexMtl || mtlmode==GsModel::PerVertexColor ) && m.M.size()>=vsize;
+	for ( n=0, i=0; i<vsize; i++ )
+	{	if ( map[i]<0 ) continue;
+		map[i] = n;
+		m.V[n] = m.V[i];
+		if ( nv ) m.N[n] = m.N[i];
+		if ( tv ) m.T[n] = m.T[i];
+		if ( mv ) m.M[n] = m.M[i];
+		n++;
+	}
+	m.V.size ( n );
+	if ( nv ) m.N.size ( n );
+	if ( tv ) m.T.size ( n );
+	if ( mv ) m.M.size ( n );
+
+	// per-face data, the face order is kept so that groups remain contiguous:
+	GsArray<int> prefix ( fsize+1 );
+	bool nf = !pernormal && m.geomode()==GsModel::Flat;
+	bool mf = mtlmode==GsModel::PerFaceMtl && m.M.size()>=fsize;
+	for ( n=0, i=0; i<fsize; i++ )
+	{	prefix[i] = n;
+		if ( dead[i] ) continue;
+		int* fc = corners(m.F[i]);
+		m.F[n].set ( map[fc[0]], map[fc[1]], map[fc[2]] );
+		if ( pernormal ) m.Fn[n] = m.Fn[i];
+		if ( pertexture ) m.Ft[n] = m.Ft[i];
+		if ( mf ) m.M[n] = m.M[i];
+		n++;
+	}
+	prefix[fsize] = n;
+	m.F.size ( n );
+	if ( pernormal ) m.Fn.size ( n );
+	if ( pertexture ) m.Ft.size ( n );
+	if ( mf ) m.M.size ( n );
+	if ( nf ) { m.N.size(n); for ( i=0; i<n; i++ ) m.N[i]=m.face_normal(i); }
+
+	for ( i=0; i<m.G.size(); i++ )
+	{	GsModel::Group& G = *m.G[i];
+		int fi = GS_BOUND ( G.fi, 0, fsize );
+		int fe = GS_BOUND ( G.fi+G.fn, 0, fsize );
+		G.fi = prefix[fi];
+		G.fn = prefix[fe]-prefix[fi];
+	}
+
+	// normals and texture coordinates indexed per face:
+	if ( pernormal ) compact_indexed ( m.N, m.Fn, map );
+	if ( pertexture ) compact_indexed ( m.T, m.Ft, map );
+}
+
+//=================================== GsModel =================================================
+
+int GsModel::simplify ( int nfaces )
+{
+	if ( nfaces<1 ) nfaces=1;
+	if ( F.size()<=nfaces || primitive ) return F.size();
+
+	Simplifier s ( *this );
+	s.init ();
+	GS_TRACE1 ( "Simplifying "<<F.size()<<" faces, "<<s.heap.size()<<" collapses..." );
+
+	while ( s.faces>nfaces && !s.heap.empty() )
+	{	Collapse c = s.heap.top();
+		s.heap.remove ();
+		if ( c.su!=s.stamp[c.u] || c.sv!=s.stamp[c.v] ) continue; // outdated
+		if ( !s.valid(c.u,c.v) ) continue;
+		s.collapse ( c.u, c.v );
+	}
+
+	s.compact ();
+	compress ();
+	GS_TRACE1 ( "Done with "<<F.size()<<" faces." );
+	return F.size();
+}
+
+//================================ End of File =================================================
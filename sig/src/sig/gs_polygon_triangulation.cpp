@@ -0,0 +1,298 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_polygon.h>
+# include <sig/gs_tree.h>
+
+//# define GS_USE_TRACE1 // fallbacks
+# include <sig/gs_trace.h>
+
+/* The triangulation is done in two steps, as described in the book
+   "Computational Geometry: Algorithms and Applications", de Berg et al.:
+   1. the polygon is partitioned in y-monotone pieces with a plane sweep,
+	  where the status is kept in a GsTree, giving O(n log n) time;
+   2. each monotone piece is triangulated in linear time with a stack. */
+
+//=================================== helpers ========================================
+
+// true if a comes before b in the sweep order (top to bottom, then left to right)
+static inline bool above ( const GsPnt2& a, const GsPnt2& b )
+{
+	return a.y>b.y || ( a.y==b.y && a.x<b.x );
+}
+
+struct SweepPnt
+{	GsPnt2 p;
+	int i;
+	static int compare ( const SweepPnt* a, const SweepPnt* b )
+	{	return above(a->p,b->p)? -1 : above(b->p,a->p)? 1 : a->i<b->i? -1:1; }
+};
+
+struct SweepEdge : public GsTreeNode
+{	int e; // edge (e,e+1) of the working polygon
+};
+
+enum VertexType { Start, End, Split, Merge, Regular };
+
+// Compares edges in the sweep status by their x coordinate at the current event.
+// Nodes are stored in an external array, so they are never allocated or deleted here.
+class SweepStatus : public GsManagerBase
+{  public :
+	const GsPnt2* P;
+	int n;
+	GsPnt2 ev; // current event point
+   public :
+	float xat ( int e ) const
+	{	const GsPnt2& a = P[e];
+		const GsPnt2& b = P[(e+1)%n];
+		if ( a.y==b.y ) return GS_BOUND ( ev.x, GS_MIN(a.x,b.x), GS_MAX(a.x,b.x) );
+		if ( ev.y==a.y ) return a.x;
+		if ( ev.y==b.y ) return b.x;
+		return a.x + (ev.y-a.y)*(b.x-a.x)/(b.y-a.y);
+	}
+	virtual void* alloc () { return 0; }
+	virtual void* alloc ( const void* /*obj*/ ) { return 0; }
+	virtual void free ( void* /*obj*/ ) {}
+	virtual int compare ( const void* obj1, const void* obj2 )
+	{	int e1 = ((const SweepEdge*)obj1)->e;
+		int e2 = ((const SweepEdge*)obj2)->e;
+		if ( e1==e2 ) return 0;
+		float x1=xat(e1), x2=xat(e2);
+		return x1<x2? -1 : x1>x2? 1 : e1<e2? -1:1;
+	}
+	// returns the edge directly to the left of the event point, or -1 if none
+	int left_edge ( GsTreeNode* root ) const
+	{	int found=-1;
+		GsTreeNode* x = root;
+		while ( x!=GsTreeNode::null )
+		{	int e = ((SweepEdge*)x)->e;
+			if ( xat(e)<ev.x ) { found=e; x=x->right; } else x=x->left;
+		}
+		return found;
+	}
+};
+
+//================================ monotone pieces ========================================
+
+// triangulates the monotone piece f, given in ccw order, pushing ccw triangles in t
+static void triangulate_monotone ( const GsPnt2* P, const int* f, int k, GsArray<int>& t,
+								   GsArray<int>& u, GsArray<gscbool>& chain, GsArray<int>& stack )
+{
+	int i, j, top=0, bot=0;
+
+	if ( k==3 ) { t.push()=f[0]; t.push()=f[1]; t.push()=f[2]; return; }
+
+	for ( i=1; i<k; i++ )
+	{	if ( above(P[f[i]],P[f[top]]) ) top=i;
+		if ( above(P[f[bot]],P[f[i]]) ) bot=i;
+	}
+
+	// merge the left chain (forward from top) and the right chain (backward from top):
+	u.size(0); chain.size(0);
+	u.push()=f[top]; chain.push()=0;
+	int l=(top+1)%k, r=(top-1+k)%k;
+	while ( l!=bot || r!=bot )
+	{	if ( r==bot || ( l!=bot && above(P[f[l]],P[f[r]]) ) )
+		{	u.push()=f[l]; chain.push()=0; l=(l+1)%k; }
+		else
+		{	u.push()=f[r]; chain.push()=1; r=(r-1+k)%k; }
+	}
+	u.push()=f[bot]; chain.push()=1;
+
+	# define TRI(a,b,c) if ( ccw(P[a],P[b],P[c])>=0 ) { t.push()=a; t.push()=b; t.push()=c; } \
+						else { t.push()=a; t.push()=c; t.push()=b; }
+
+	stack.size(0);
+	stack.push()=0; stack.push()=1;
+	for ( j=2; j<k-1; j++ )
+	{	if ( chain[j]!=chain[stack.top()] ) // on opposite chains: connect to all
+		{	while ( stack.size()>1 )
+			{	int a = stack.pop();
+				TRI ( u[j], u[a], u[stack.top()] );
+			}
+			stack.pop();
+			stack.push()=j-1; stack.push()=j;
+		}
+		else // on the same chain: connect while the diagonals are inside
+		{	int last = stack.pop();
+			while ( stack.size()>0 )
+			{	double o = ccw ( P[u[j]], P[u[last]], P[u[stack.top()]] );
+				if ( chain[j]==0? o>=0 : o<=0 ) break;
+				TRI ( u[j], u[last], u[stack.top()] );
+				last = stack.pop();
+			}
+			stack.push()=last; stack.push()=j;
+		}
+	}
+	for ( i=stack.size()-1; i>0; i-- ) // connect the bottom vertex to the remaining ones
+	{	TRI ( u[k-1], u[stack[i]], u[stack[i-1]] );
+	}
+
+	# undef TRI
+}
+
+//================================ triangulation ========================================
+
+// returns false if the polygon could not be triangulated, for example due to self-intersections
+static bool monotone_triangulation ( const GsPnt2* P, int n, GsArray<int>& tris )
+{
+	int i, e;
+
+	// 1. classify vertices and sort them in sweep order:
+	GsArray<gscenum> type(n);
+	GsArray<SweepPnt> ev(n);
+	for ( i=0; i<n; i++ )
+	{	const GsPnt2& a = P[(i-1+n)%n];
+		const GsPnt2& b = P[(i+1)%n];
+		bool convex = ccw ( a, P[i], b )>0;
+		if ( above(a,P[i]) && above(b,P[i]) ) type[i] = convex? End:Merge;
+		else if ( above(P[i],a) && above(P[i],b) ) type[i] = convex? Start:Split;
+		else type[i] = Regular;
+		ev[i].p=P[i]; ev[i].i=i;
+	}
+	ev.sort ( SweepPnt::compare );
+
+	// 2. sweep to find the diagonals of the monotone partition:
+	GsArray<SweepEdge> edges(n); // declared before the tree, which accesses them when destroyed
+	SweepStatus* status = new SweepStatus;
+	status->P=P; status->n=n;
+	GsTreeBase tree ( status );
+	GsArray<int> helper(n);
+	GsArray<int> diags;
+	# define INSERT(x) { edges[x].init(); edges[x].color=GsTreeNode::Red; edges[x].e=x; helper[x]=v; tree.insert(&edges[x]); }
+	# define REMOVE(x) { tree.extract(&edges[x]); }
+	# define DIAG(a,b) { diags.push()=a; diags.push()=b; }
+	# define FIXUP(x) { if ( type[helper[x]]==Merge ) DIAG(v,helper[x]); }
+	for ( i=0; i<n; i++ )
+	{	int v = ev[i].i;
+		int p = (v-1+n)%n; // previous edge (p,v)
+		status->ev = P[v];
+		switch ( type[v] )
+		{	case Start: INSERT(v); break;
+			case End: FIXUP(p); REMOVE(p); break;
+			case Split:
+				e = status->left_edge ( tree.root() );
+				if ( e<0 ) return false;
+				DIAG ( v, helper[e] );
+				helper[e] = v;
+				INSERT(v);
+				break;
+			case Merge:
+				FIXUP(p); REMOVE(p);
+				e = status->left_edge ( tree.root() );
+				if ( e<0 ) return false;
+				FIXUP(e);
+				helper[e] = v;
+				break;
+			default:
+				if ( above(P[p],P[v]) ) // interior to the right of v
+				{	FIXUP(p); REMOVE(p); INSERT(v); }
+				else
+				{	e = status->left_edge ( tree.root() );
+					if ( e<0 ) return false;
+					FIXUP(e);
+					helper[e] = v;
+				}
+		}
+	}
+	# undef INSERT
+	# undef REMOVE
+	# undef DIAG
+	# undef FIXUP
+	GS_TRACE1 ( "Diagonals: "<<diags.size()/2 );
+
+	// 3. build the half-edge adjacency with neighbors sorted by angle:
+	int d = diags.size()/2;
+	GsArray<int> deg(n), off(n+1);
+	for ( i=0; i<n; i++ ) deg[i]=2;
+	for ( i=0; i<d*2; i++ ) deg[diags[i]]++;
+	off[0]=0;
+	for ( i=0; i<n; i++ ) off[i+1]=off[i]+deg[i];
+	GsArray<int> adj(off[n]);
+	GsArray<float> ang(off[n]);
+	GsArray<gscbool> used(off[n]);
+	for ( i=0; i<n; i++ ) deg[i]=0;
+	# define ADD(a,b) { int s=off[a]+deg[a]++; adj[s]=b; ang[s]=atan2f(P[b].y-P[a].y,P[b].x-P[a].x); used[s]=0; }
+	for ( i=0; i<n; i++ ) { ADD(i,(i+1)%n); ADD(i,(i-1+n)%n); }
+	for ( i=0; i<d; i++ ) { ADD(diags[i*2],diags[i*2+1]); ADD(diags[i*2+1],diags[i*2]); }
+	# undef ADD
+	for ( i=0; i<n; i++ ) // insertion sort by angle, vertices have few neighbors
+	{	for ( int s=off[i]+1; s<off[i+1]; s++ )
+		{	for ( int r=s; r>off[i] && ang[r-1]>ang[r]; r-- )
+			{	float ta; int tv;
+				GS_SWAPT ( ang[r-1], ang[r], ta );
+				GS_SWAPT ( adj[r-1], adj[r], tv );
+			}
+		}
+	}
+	for ( i=0; i<n; i++ ) // mark backward polygon edges as used, they belong to the exterior
+	{	for ( int s=off[i]; s<off[i+1]; s++ ) if ( adj[s]==(i-1+n)%n && (i-1+n)%n!=(i+1)%n ) used[s]=1;
+	}
+
+	// 4. extract and triangulate each face:
+	GsArray<int> f, u, stack;
+	GsArray<gscbool> chain;
+	for ( i=0; i<n; i++ )
+	{	for ( int s=off[i]; s<off[i+1]; s++ )
+		{	if ( used[s] ) continue;
+			f.size(0);
+			int a=i, hs=s, steps=0;
+			while ( !used[hs] )
+			{	used[hs]=1;
+				f.push()=a;
+				int b = adj[hs];
+				int r; // position of a in the list of b
+				for ( r=off[b]; r<off[b+1] && adj[r]!=a; r++ );
+				if ( r==off[b+1] ) return false;
+				hs = r==off[b]? off[b+1]-1 : r-1; // next edge clockwise from (b,a)
+				a = b;
+				if ( ++steps>n ) return false;
+			}
+			if ( hs!=s || f.size()<3 ) return false;
+			triangulate_monotone ( P, f.pt(), f.size(), tris, u, chain, stack );
+		}
+	}
+
+	return tris.size()==3*(n-2);
+}
+
+void GsPolygon::triangulation ( GsArray<int>& tris, float prec ) const
+{
+	int i, s=size();
+	tris.size(0);
+	if ( s<3 ) return;
+
+	// working polygon in ccw order, skipping vertices too close to the previous one:
+	bool cw = area()<0;
+	GsPolygon W;
+	GsArray<int> map;
+	W.reserve(s); map.reserve(s);
+	for ( i=0; i<s; i++ )
+	{	int k = cw? s-1-i : i;
+		if ( W.size() && next(W.top(),cget(k),prec) ) continue;
+		W.push()=cget(k); map.push()=k;
+	}
+	while ( W.size()>1 && next(W.top(),W[0],prec) ) { W.pop(); map.pop(); }
+	int n = W.size();
+	if ( n<3 ) return;
+
+	if ( n==3 || W.convex() )
+	{	for ( i=1; i<n-1; i++ ) { tris.push()=0; tris.push()=i; tris.push()=i+1; }
+	}
+	else if ( !monotone_triangulation(W.pt(),n,tris) )
+	{	GS_TRACE1 ( "Monotone partition failed, using ear_triangulation" );
+		W.ear_triangulation ( tris, prec );
+	}
+
+	// map back to the original indices and orientation:
+	for ( i=0; i<tris.size(); i++ ) tris[i]=map[tris[i]];
+	int tmp;
+	if ( cw ) for ( i=0; i<tris.size(); i+=3 ) GS_SWAP ( tris[i+1], tris[i+2] );
+}
+
+//================================== End of File ========================================
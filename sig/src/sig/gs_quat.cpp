@@ -9,6 +9,9 @@
 # include <sig/gs_euler.h>
 # include <sig/gs_string.h>
 # include <sig/gs_random.h>
+# ifdef GS_SSE
+# include <xmmintrin.h>
+# endif
 
 //============================== Static Data ====================================
 
@@ -149,6 +152,27 @@ GsVec GsQuat::apply ( const GsVec &v ) const
 
 //=================================== Friend Functions ===================================
 
+# ifdef GS_SSE
+
+GsQuat operator * ( const GsQuat &q1, const GsQuat &q2 )
+ {
+   GsQuat q;
+
+   // the product is q2 combined with permutations of itself weighted by w1, x1, y1, z1:
+   // w1*(w2,x2,y2,z2) + x1*(-x2,w2,-z2,y2) + y1*(-y2,z2,w2,-x2) + z1*(-z2,-y2,x2,w2)
+   __m128 b = _mm_loadu_ps ( q2.e );
+   __m128 bx = _mm_mul_ps ( _mm_shuffle_ps(b,b,_MM_SHUFFLE(2,3,0,1)), _mm_setr_ps(-1.0f, 1.0f,-1.0f, 1.0f) );
+   __m128 by = _mm_mul_ps ( _mm_shuffle_ps(b,b,_MM_SHUFFLE(1,0,3,2)), _mm_setr_ps(-1.0f, 1.0f, 1.0f,-1.0f) );
+   __m128 bz = _mm_mul_ps ( _mm_shuffle_ps(b,b,_MM_SHUFFLE(0,1,2,3)), _mm_setr_ps(-1.0f,-1.0f, 1.0f, 1.0f) );
+   __m128 r = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps(_mm_set1_ps(q1.w),b),  _mm_mul_ps(_mm_set1_ps(q1.x),bx) ),
+						   _mm_add_ps ( _mm_mul_ps(_mm_set1_ps(q1.y),by), _mm_mul_ps(_mm_set1_ps(q1.z),bz) ) );
+   _mm_storeu_ps ( q.e, r );
+
+   return q;
+ }
+
+# else
+
 GsQuat operator * ( const GsQuat &q1, const GsQuat &q2 )
  {
    GsQuat q;
@@ -166,6 +190,8 @@ GsQuat operator * ( const GsQuat &q1, const GsQuat &q2 )
    return q;
  }
 
+# endif // GS_SSE
+
 bool operator == ( const GsQuat &q1, const GsQuat &q2 )
  { 
    return q1.w==q2.w && q1.x==q2.x && q1.y==q2.y && q1.z==q2.z ; 
@@ -365,46 +391,46 @@ bool quat2ts ( const GsQuat& q, float& tw, float& sx, float& sy )
    return true;
  }
 
-void mat2quat ( const GsMat& m, GsQuat& q ) // PerfNote: this implementation can be optimized
+void mat2quat ( const GsMat& m, GsQuat& q )
 {
-	# define E(i)   m(i)
-	# define M(i,j) m.cget(i,j)
-	# define Q(i)   q.e[i+1] // Q(0)=x, Q(1)=y, Q(2)=z 
-
+	// The largest of w, x, y and z is computed from the diagonal, and the others from
+	// the sums or differences of the symmetric elements. The signs of x, y and z
+	// are inverted with respect to the column-major formulation since GsMat is line-major.
 	float s;
-	float tr = E(0) + E(5) + E(10);
+	float tr = m.e11 + m.e22 + m.e33;
 
 	if ( tr>0 )
 	{	s = sqrtf ( 1.0f + tr );
-		q.w = s / 2.0f;
+		q.w = s * 0.5f;
 		s = 0.5f / s;
-		q.x = (E(6) - E(9)) * s;
-		q.y = (E(8) - E(2)) * s;
-		q.z = (E(1) - E(4)) * s;
+		q.x = (m.e32 - m.e23) * s;
+		q.y = (m.e13 - m.e31) * s;
+		q.z = (m.e21 - m.e12) * s;
+	}
+	else if ( m.e11>=m.e22 && m.e11>=m.e33 )
+	{	s = sqrtf ( (m.e11 - (m.e22+m.e33)) + 1.0f );
+		q.x = s * -0.5f;
+		if ( s!=0 ) s = 0.5f / s; // s should never be equal to 0 if matrix is orthogonal
+		q.w = (m.e23 - m.e32) * s;
+		q.y = (m.e12 + m.e21) * -s;
+		q.z = (m.e13 + m.e31) * -s;
+	}
+	else if ( m.e22>=m.e33 )
+	{	s = sqrtf ( (m.e22 - (m.e33+m.e11)) + 1.0f );
+		q.y = s * -0.5f;
+		if ( s!=0 ) s = 0.5f / s;
+		q.w = (m.e31 - m.e13) * s;
+		q.z = (m.e23 + m.e32) * -s;
+		q.x = (m.e21 + m.e12) * -s;
 	}
 	else
-	{	int i = M(1,1)>M(0,0)? 1:0;
-		if ( M(2,2)> M(i,i) ) i=2;
-		int j = (i+1)%3;
-		int k = (j+1)%3;
-
-		s = sqrtf ( (M(i,i) - (M(j,j)+M(k,k))) + 1.0f );
-		Q(i) = s * 0.5f;
-
-		if ( s!=0 ) // s should never be equal to 0 if matrix is orthogonal 
-		s = 0.5f / s;
-
-		q.w  = (M(j,k) - M(k,j)) * s;
-		Q(j) = (M(i,j) + M(j,i)) * s;
-		Q(k) = (M(i,k) + M(k,i)) * s;
+	{	s = sqrtf ( (m.e33 - (m.e11+m.e22)) + 1.0f );
+		q.z = s * -0.5f;
+		if ( s!=0 ) s = 0.5f / s;
+		q.w = (m.e12 - m.e21) * s;
+		q.x = (m.e31 + m.e13) * -s;
+		q.y = (m.e32 + m.e23) * -s;
 	}
-
-	// original code above was for column-major mat, fix result here:
-	q.x=-q.x; q.y=-q.y; q.z=-q.z; // invert (for unit quat)
-
-	# undef E
-	# undef M
-	# undef Q
 }
 
 void quat2mat ( const GsQuat& q, 
@@ -12,14 +12,22 @@
 
 GsShareable::~GsShareable() 
 { 
-	if (_ref) gsout.fatal("GsShareable object deleted with ref>0"); 
+	if (GS_REF_GET(_ref)) gsout.fatal("GsShareable object deleted with ref>0"); 
 }
 
 void GsShareable::unref() 
 {
-	if (_ref==0) gsout.fatal("GsShareable::unref() called for 0 references");
-	_ref--;
-	if (_ref==0) delete this; // will trigger chain of virtual destructors
+	if (GS_REF_GET(_ref)==0) gsout.fatal("GsShareable::unref() called for 0 references");
+	if (GS_REF_DEC(_ref)==0) delete this; // will trigger chain of virtual destructors
+}
+
+bool GsShareable::atomicref ()
+{
+# ifdef GS_ATOMIC_REF
+	return true;
+# else
+	return false;
+# endif
 }
 
 void unrefref ( GsShareable* obj1, GsShareable* obj2 )
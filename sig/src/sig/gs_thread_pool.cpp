@@ -0,0 +1,204 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_thread_pool.h>
+
+# include <atomic>
+# include <deque>
+# include <mutex>
+# include <thread>
+# include <vector>
+# include <condition_variable>
+
+//======================= internal structures =====================================
+
+static thread_local int WorkerSlot=-1; // slot of the current thread if it is a worker
+
+struct Loop // one call to run(), lives in the stack of the caller
+{	std::atomic<int> next;
+	std::atomic<int> done;
+	std::atomic<int> attached; // number of workers currently inside the loop
+	int n, chunk;
+	GsThreadPool::LoopFunc func;
+	void* udata;
+	std::mutex mutex;
+	std::condition_variable finished;
+};
+
+struct Job
+{	GsThreadPool::TaskFunc task; // if null, the job is a helper of loop
+	void* udata;
+	Loop* loop;
+};
+
+struct PoolData
+{	std::vector<std::thread> threads;
+	std::deque<Job> jobs;
+	std::mutex mutex;
+	std::condition_variable newjob;
+	std::condition_variable idle;
+	int pending;
+	bool stop;
+};
+
+struct GsThreadPool::Data : public PoolData
+{
+};
+
+static void exec_loop ( Loop* l, int slot )
+{
+	while ( true )
+	{	int i = l->next.fetch_add ( l->chunk );
+		if ( i>=l->n ) break;
+		int e = GS_MIN ( i+l->chunk, l->n );
+		for ( int k=i; k<e; k++ ) l->func ( k, slot, l->udata );
+		if ( l->done.fetch_add(e-i)+(e-i)==l->n )
+		{	std::lock_guard<std::mutex> lock ( l->mutex );
+			l->finished.notify_all();
+		}
+	}
+}
+
+static void worker_main ( PoolData* d, int slot )
+{
+	WorkerSlot = slot;
+	while ( true )
+	{	Job job;
+		{	std::unique_lock<std::mutex> lock ( d->mutex );
+			d->newjob.wait ( lock, [d]{ return d->stop || !d->jobs.empty(); } );
+			if ( d->jobs.empty() ) return; // stop requested and nothing left to do
+			job = d->jobs.front();
+			d->jobs.pop_front();
+			if ( !job.task ) job.loop->attached++; // attached while the pool is locked, see run()
+		}
+		if ( job.task )
+		{	job.task ( job.udata );
+			std::lock_guard<std::mutex> lock ( d->mutex );
+			if ( --d->pending==0 ) d->idle.notify_all();
+		}
+		else
+		{	exec_loop ( job.loop, slot );
+			std::lock_guard<std::mutex> lock ( job.loop->mutex );
+			job.loop->attached--;
+			job.loop->finished.notify_all();
+		}
+	}
+}
+
+//======================= GsThreadPool =====================================
+
+GsThreadPool::GsThreadPool ( int workers )
+{
+	if ( workers<0 ) workers = int(std::thread::hardware_concurrency())-1;
+	if ( workers<0 ) workers = 0;
+
+	_data = new Data;
+	_data->pending = 0;
+	_data->stop = false;
+	for ( int i=0; i<workers; i++ ) _data->threads.push_back ( std::thread(worker_main,_data,i) );
+}
+
+GsThreadPool::~GsThreadPool ()
+{
+	wait ();
+	{	std::lock_guard<std::mutex> lock ( _data->mutex );
+		_data->stop = true;
+	}
+	_data->newjob.notify_all();
+	for ( size_t i=0; i<_data->threads.size(); i++ ) _data->threads[i].join();
+	delete _data;
+}
+
+int GsThreadPool::workers () const
+{
+	return (int)_data->threads.size();
+}
+
+void GsThreadPool::run ( int n, LoopFunc f, void* udata, int chunk )
+{
+	if ( n<=0 ) return;
+	int w = workers();
+	int slot = WorkerSlot>=0? WorkerSlot : w;
+
+	if ( chunk<=0 ) chunk = GS_MAX ( 1, n/(4*(w+1)) );
+	int nchunks = (n+chunk-1)/chunk;
+
+	if ( w==0 || nchunks==1 ) // no need to involve workers
+	{	for ( int i=0; i<n; i++ ) f ( i, slot, udata );
+		return;
+	}
+
+	Loop loop;
+	Loop* l = &loop;
+	l->next = 0;
+	l->done = 0;
+	l->attached = 0;
+	l->n = n;
+	l->chunk = chunk;
+	l->func = f;
+	l->udata = udata;
+
+	int helpers = GS_MIN ( w, nchunks-1 );
+	{	std::lock_guard<std::mutex> lock ( _data->mutex );
+		for ( int i=0; i<helpers; i++ )
+		{	Job job;
+			job.task = 0;
+			job.udata = 0;
+			job.loop = l;
+			_data->jobs.push_back ( job );
+		}
+	}
+	_data->newjob.notify_all();
+
+	exec_loop ( l, slot );
+
+	// remove the helpers that did not start, no worker can attach to the loop after this:
+	{	std::lock_guard<std::mutex> lock ( _data->mutex );
+		for ( size_t i=0; i<_data->jobs.size(); )
+		{	if ( _data->jobs[i].loop==l ) _data->jobs.erase ( _data->jobs.begin()+i ); else i++;
+		}
+	}
+
+	// wait for the indices being processed by workers and for the workers to leave the loop:
+	std::unique_lock<std::mutex> lock ( l->mutex );
+	l->finished.wait ( lock, [l]{ return l->done.load()==l->n && l->attached.load()==0; } );
+}
+
+void GsThreadPool::push ( TaskFunc f, void* udata )
+{
+	if ( workers()==0 ) { f(udata); return; }
+
+	Job job;
+	job.task = f;
+	job.udata = udata;
+	job.loop = 0;
+	{	std::lock_guard<std::mutex> lock ( _data->mutex );
+		_data->jobs.push_back ( job );
+		_data->pending++;
+	}
+	_data->newjob.notify_one();
+}
+
+int GsThreadPool::pending () const
+{
+	std::lock_guard<std::mutex> lock ( _data->mutex );
+	return _data->pending;
+}
+
+void GsThreadPool::wait ()
+{
+	std::unique_lock<std::mutex> lock ( _data->mutex );
+	_data->idle.wait ( lock, [this]{ return _data->pending==0; } );
+}
+
+GsThreadPool* GsThreadPool::shared ()
+{
+	static GsThreadPool pool;
+	return &pool;
+}
+
+//============================== end of file ===============================
@@ -0,0 +1,260 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/sa_bvh.h>
+# include <sig/sn_model.h>
+# include <sig/sn_editor.h>
+
+//# define GS_USE_TRACE1 // build and update
+# include <sig/gs_trace.h>
+
+//================================== Mesh ====================================
+
+struct SaBvh::Mesh
+{	GsModel* model;		// referenced
+	int nv, nf;			// number of vertices and faces when the hierarchy was built
+	const void* vpt;	// vertex array pointer when the hierarchy was built
+	const void* fpt;	// face array pointer when the hierarchy was built
+	int used;			// number of instances using the mesh
+	GsBvh bvh;
+
+	Mesh ( GsModel* m ) { model=m; model->ref(); nv=nf=-1; vpt=fpt=0; used=0; }
+   ~Mesh () { model->unref(); }
+
+	bool outdated () const
+	{	return nv!=model->V.size() || nf!=model->F.size() || vpt!=model->V.pt() || fpt!=model->F.pt(); }
+
+	void build ()
+	{	const GsArray<GsVec>& V = model->V;
+		const GsArray<GsModel::Face>& F = model->F;
+		GsArray<GsBox> boxes ( F.size() );
+		for ( int i=0; i<F.size(); i++ )
+		{	GsBox& b = boxes[i];
+			b.set ( V[F[i].a], V[F[i].a] );
+			b.extend ( V[F[i].b] );
+			b.extend ( V[F[i].c] );
+		}
+		bvh.build ( boxes );
+		nv=V.size(); nf=F.size(); vpt=V.pt(); fpt=F.pt();
+	}
+};
+
+// data passed to the ray callbacks
+struct BvhRayData
+{	const SaBvh* bvh;		// the structure being queried
+	const GsModel* model;	// model being tested by _raytri
+	int face;				// face of the last accepted intersection
+};
+
+//================================== SaBvh ====================================
+
+SaBvh::SaBvh ( bool meshes )
+{
+	_cur = 0;
+	_updating = 0;
+	_rebuild = 0;
+	_moved = 0;
+	_usemeshes = meshes;
+}
+
+SaBvh::~SaBvh ()
+{
+	init ();
+}
+
+void SaBvh::init ()
+{
+	int i;
+	for ( i=0; i<_inst.size(); i++ ) _inst[i].shape->unref();
+	for ( i=0; i<_meshes.size(); i++ ) delete _meshes[i];
+	_inst.size ( 0 );
+	_boxes.size ( 0 );
+	_meshes.size ( 0 );
+	_top.init ();
+}
+
+SaBvh::Mesh* SaBvh::_getmesh ( const GsModel* m )
+{
+	Mesh* mesh=0;
+	for ( int i=0; i<_meshes.size(); i++ )
+	{	if ( _meshes[i]->model==m ) { mesh=_meshes[i]; break; }
+	}
+	if ( !mesh )
+	{	mesh = new Mesh ( (GsModel*)m );
+		_meshes.push() = mesh;
+	}
+	if ( mesh->outdated() ) mesh->build();
+	mesh->used++;
+	return mesh;
+}
+
+void SaBvh::build ( SnNode* root )
+{
+	int i;
+	for ( i=0; i<_inst.size(); i++ ) _inst[i].shape->unref();
+	_inst.size ( 0 );
+	for ( i=0; i<_meshes.size(); i++ ) _meshes[i]->used=0;
+
+	_updating = 0;
+	SaAction::init ();
+	SaAction::apply ( root );
+
+	// delete the triangle hierarchies of models not in the scene anymore:
+	for ( i=0; i<_meshes.size(); i++ )
+	{	if ( _meshes[i]->used ) continue;
+		delete _meshes[i];
+		_meshes[i] = _meshes.pop();
+		i--;
+	}
+
+	_boxes.size ( _inst.size() );
+	for ( i=0; i<_inst.size(); i++ ) _boxes[i] = _inst[i].mat*_inst[i].box;
+	_top.build ( _boxes, 2 );
+	GS_TRACE1 ( "built: "<<_inst.size()<<" instances, "<<_meshes.size()<<" meshes" );
+}
+
+int SaBvh::update ( SnNode* root )
+{
+	_cur = 0;
+	_rebuild = 0;
+	_moved = 0;
+	_updating = 1;
+	SaAction::init ();
+	SaAction::apply ( root );
+	_updating = 0;
+
+	if ( _rebuild || _cur!=_inst.size() ) { build(root); return 2; }
+	if ( !_moved ) return 0;
+
+	for ( int i=0; i<_inst.size(); i++ ) _boxes[i] = _inst[i].mat*_inst[i].box;
+	_top.refit ( _boxes );
+	GS_TRACE1 ( "refit" );
+	return 1;
+}
+
+void SaBvh::model_changed ( const GsModel* m )
+{
+	for ( int i=0; i<_meshes.size(); i++ )
+	{	if ( _meshes[i]->model==m ) _meshes[i]->nv=-1;
+	}
+}
+
+bool SaBvh::shape_apply ( SnShape* s )
+{
+	if ( !s->visible() ) return true;
+	const GsMat& mat = get_top_matrix();
+	SnModel* sm = dynamic_cast<SnModel*>(s);
+
+	if ( _updating ) // only check for changes
+	{	if ( _cur>=_inst.size() || _inst[_cur].shape!=s ) { _rebuild=1; return false; }
+		Instance& in = _inst[_cur++];
+		if ( in.mesh )
+		{	if ( in.mesh->model!=sm->cmodel() || in.mesh->outdated() ) { _rebuild=1; return false; }
+		}
+		else if ( !sm || s->changed() ) // boxes of models are only computed again if changed
+		{	GsBox b;
+			s->get_bounding_box ( b );
+			if ( b.a!=in.box.a || b.b!=in.box.b ) { in.box=b; _moved=1; }
+		}
+		if ( in.mat!=mat ) { in.mat=mat; mat.inverse(in.inv); _moved=1; }
+		return true;
+	}
+
+	Instance& in = _inst.push();
+	in.shape = s;
+	s->ref();
+	in.mat = mat;
+	mat.inverse ( in.inv );
+	if ( sm && _usemeshes )
+	{	in.mesh = _getmesh ( sm->cmodel() );
+		in.box = in.mesh->bvh.box();
+	}
+	else
+	{	in.mesh = 0;
+		s->get_bounding_box ( in.box );
+	}
+	return true;
+}
+
+bool SaBvh::editor_apply ( SnEditor* e )
+{
+	SnNode* c = e->child();
+	if ( !c ) return true;
+	push_matrix ();
+	mult_matrix ( e->mat() );
+	bool b = SaAction::apply ( c );
+	pop_matrix ();
+	return b;
+}
+
+//================================== queries ====================================
+
+// Parametric distances are the same in local and global coordinates since both
+// endpoints of the ray are transformed by the same affine matrix.
+float SaBvh::_rayinst ( int i, const GsLine& ray, float tmax, void* udata )
+{
+	BvhRayData& d = *(BvhRayData*)udata;
+	const Instance& in = d.bvh->_inst[i];
+	GsLine lray ( in.inv*ray.p1, in.inv*ray.p2 );
+	float t;
+	if ( in.mesh )
+	{	d.model = in.mesh->model;
+		int f = in.mesh->bvh.ray ( lray, _raytri, udata, t, tmax );
+		if ( f<0 ) return -1;
+		d.face = f;
+		return t;
+	}
+	float t2;
+	if ( lray.intersects_box(in.box,t,t2)==0 ) return -1;
+	if ( t<0 ) t=t2; // p1 is inside the box
+	if ( t<0 || t>=tmax ) return -1;
+	d.face = -1;
+	return t;
+}
+
+float SaBvh::_raytri ( int i, const GsLine& ray, float tmax, void* udata )
+{
+	const GsModel* m = ((BvhRayData*)udata)->model;
+	const GsModel::Face& f = m->F[i];
+	float t, u, v;
+	if ( !ray.intersects_triangle(m->V[f.a],m->V[f.b],m->V[f.c],t,u,v) ) return -1;
+	return t>=0 && t<tmax? t : -1;
+}
+
+bool SaBvh::pick ( const GsLine& ray, Hit& hit ) const
+{
+	BvhRayData d;
+	d.bvh = this;
+	d.model = 0;
+	d.face = -1;
+	float t;
+	int i = _top.ray ( ray, _rayinst, &d, t );
+
+	hit.instance = i;
+	if ( i<0 ) { hit.shape=0; hit.face=-1; hit.t=0; hit.p=ray.p1; return false; }
+	hit.shape = _inst[i].shape;
+	hit.face = d.face;
+	hit.t = t;
+	hit.p = ray.p1 + t*(ray.p2-ray.p1);
+	return true;
+}
+
+void SaBvh::overlap ( const GsBox& b, GsArray<SnShape*>& shapes ) const
+{
+	GsArray<int> ids;
+	_top.overlap ( b, ids );
+	for ( int i=0; i<ids.size(); i++ ) shapes.push()=_inst[ids[i]].shape;
+}
+
+void SaBvh::frustum ( const GsMat& m, GsArray<SnShape*>& shapes ) const
+{
+	GsArray<int> ids;
+	_top.frustum ( m, ids );
+	for ( int i=0; i<ids.size(); i++ ) shapes.push()=_inst[ids[i]].shape;
+}
+
+//======================================= EOF ====================================
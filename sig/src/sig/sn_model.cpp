@@ -43,6 +43,7 @@ SnModel::SnModel ( const char* classname ) : SnShape ( classname )
 	GS_TRACE1 ( "Protected Constructor" );
 	_model = new GsModel;
 	_model->ref();
+	_lod = 0;
 }
 
 SnModel::SnModel ( GsModel* m ) : SnShape ( class_name )
@@ -50,23 +51,37 @@ SnModel::SnModel ( GsModel* m ) : SnShape ( class_name )
 	GS_TRACE1 ( "Constructor" );
 	_model = m? m : new GsModel;
 	_model->ref();
+	_lod = 0;
 }
 
 SnModel::~SnModel ()
 {
 	GS_TRACE1 ( "Destructor" );
 	_model->unref();
+	if ( _lod ) _lod->unref();
 }
 
 void SnModel::model ( GsModel* m )
 {
 	if ( _model==m ) return;
+	if ( _lod ) { _lod->unref(); _lod=0; } // the levels are not of the new model
 	_model->unref();
 	_model = m? m : new GsModel;
 	_model->ref();
 	touch ();
 }
 
+void SnModel::lod ( GsModelLod* l )
+{
+	if ( _lod==l ) return;
+	if ( l ) l->ref();
+	if ( _lod ) _lod->unref();
+	_lod = 0;
+	if ( l && l->levels() ) model ( l->level(0) );
+	_lod = l;
+	touch ();
+}
+
 void SnModel::get_bounding_box ( GsBox& b ) const
 {
 	if ( _model->primitive )
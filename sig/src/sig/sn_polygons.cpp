@@ -129,7 +129,7 @@ static void draw_polygon (	const GsPolygon& pol, SnPlanarObjects& o, SnLines2& l
 	else
 	{	const GsArray<GsPnt2>* V;
 		T.size(0);
-		if ( solid && pol.size()<1000 )
+		if ( solid )
 		{	if ( pol.size()==3 ) // no need to triangulate
 			{	V = &pol;
 				T.size(3);
@@ -140,7 +140,7 @@ static void draw_polygon (	const GsPolygon& pol, SnPlanarObjects& o, SnLines2& l
 				V = &P;
 			}
 			else
-			{	pol.ear_triangulation ( T );
+			{	pol.triangulation ( T );
 				V = &pol;
 			}
 			o.set_zero_index();
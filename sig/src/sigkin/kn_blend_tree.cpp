@@ -0,0 +1,331 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <math.h>
+# include <string.h>
+# include <sig/gs_quat.h>
+# include <sigkin/kn_blend_tree.h>
+# include <sigkin/kn_posture.h>
+# include <sigkin/kn_joint.h>
+
+# ifdef GS_SSE
+# include <xmmintrin.h>
+# endif
+
+//============================== KnBlendMask ==================================
+
+static int values_size ( const KnChannels* ch )
+{
+	int i, n=0;
+	for ( i=0; i<ch->size(); i++ ) n += ch->cget(i).size();
+	return n;
+}
+
+KnBlendMask::KnBlendMask ( KnChannels* ch, float w )
+{
+	_channels = ch;
+	_channels->ref();
+	_w.size ( values_size(ch) );
+	setall ( w );
+}
+
+KnBlendMask::~KnBlendMask ()
+{
+	_channels->unref();
+}
+
+void KnBlendMask::setall ( float w )
+{
+	for ( int i=0; i<_w.size(); i++ ) _w[i]=w;
+}
+
+int KnBlendMask::set ( const char* jname, float w )
+{
+	int i, k, f=0, count=0;
+	for ( i=0; i<_channels->size(); i++ )
+	{	const KnChannel& ch = _channels->cget(i);
+		int s = ch.size();
+		if ( ch.jname()==jname )
+		{	for ( k=0; k<s; k++ ) _w[f+k]=w;
+			count++;
+		}
+		f += s;
+	}
+	return count;
+}
+
+int KnBlendMask::set ( KnJoint* j, float w, bool subtree )
+{
+	int count = set ( j->name(), w );
+	if ( subtree )
+	{	for ( int i=0; i<j->children(); i++ ) count += set ( j->child(i), w, true );
+	}
+	return count;
+}
+
+//============================== KnBlendNode ==================================
+
+KnBlendNode::KnBlendNode ( Type t, KnChannels* ch )
+{
+	_type = (gscenum)t;
+	_channels = ch;
+	_channels->ref();
+	_values = 0;
+
+	_floats = 0;
+	for ( int i=0; i<ch->size(); i++ )
+	{	KnChannel::Type type = ch->cget(i).type();
+		if ( type==KnChannel::Quat ) _quats.push()=_floats;
+		else if ( type==KnChannel::IKGoal ) _quats.push()=_floats+3;
+		_floats += KnChannel::size(type);
+	}
+}
+
+KnBlendNode::~KnBlendNode ()
+{
+	_channels->unref();
+}
+
+void KnBlendNode::evaluate_to ( KnPosture& p )
+{
+	evaluate ();
+	memcpy ( p.values.pt(), _values, sizeof(float)*_floats );
+	p.unsyncpoints ();
+}
+
+void KnBlendNode::wsum ( const float* const* v, const float* w, int n, int size, float* out )
+{
+	int i=0, k;
+	if ( n==0 ) { for ( k=0; k<size; k++ ) out[k]=0; return; }
+
+	// the first pass stores in out the contribution of up to four inputs:
+	for ( ; i<n; i+=4 )
+	{	int m = GS_MIN ( n-i, 4 );
+		const float* a = v[i];
+		const float* b = m>1? v[i+1]:a;
+		const float* c = m>2? v[i+2]:a;
+		const float* d = m>3? v[i+3]:a;
+		float wa = w[i];
+		float wb = m>1? w[i+1]:0;
+		float wc = m>2? w[i+2]:0;
+		float wd = m>3? w[i+3]:0;
+		bool first = i==0;
+		k = 0;
+		# ifdef GS_SSE
+		__m128 va=_mm_set1_ps(wa), vb=_mm_set1_ps(wb), vc=_mm_set1_ps(wc), vd=_mm_set1_ps(wd);
+		for ( ; k+4<=size; k+=4 )
+		{	__m128 s = _mm_add_ps ( _mm_mul_ps(va,_mm_loadu_ps(a+k)), _mm_mul_ps(vb,_mm_loadu_ps(b+k)) );
+			s = _mm_add_ps ( s, _mm_mul_ps(vc,_mm_loadu_ps(c+k)) );
+			s = _mm_add_ps ( s, _mm_mul_ps(vd,_mm_loadu_ps(d+k)) );
+			if ( !first ) s = _mm_add_ps ( s, _mm_loadu_ps(out+k) );
+			_mm_storeu_ps ( out+k, s );
+		}
+		# endif
+		for ( ; k<size; k++ )
+		{	float s = wa*a[k] + wb*b[k] + wc*c[k] + wd*d[k];
+			out[k] = first? s : out[k]+s;
+		}
+	}
+}
+
+void KnBlendNode::normalize_quats ( float* v, const int* qpos, int nq )
+{
+	for ( int i=0; i<nq; i++ )
+	{	float* q = v+qpos[i];
+		float n2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+		if ( n2==0 ) { q[0]=1; continue; } // null rotation
+		float f = 1.0f/sqrtf(n2);
+		q[0]*=f; q[1]*=f; q[2]*=f; q[3]*=f;
+	}
+}
+
+//============================== KnBlendPose ==================================
+
+KnBlendPose::KnBlendPose ( KnPosture* p ) : KnBlendNode ( Pose, p->channels() )
+{
+	_posture = p;
+	_posture->ref();
+}
+
+KnBlendPose::~KnBlendPose ()
+{
+	_posture->unref();
+}
+
+void KnBlendPose::posture ( KnPosture* p )
+{
+	p->ref();
+	_posture->unref();
+	_posture = p;
+}
+
+void KnBlendPose::evaluate ()
+{
+	_values = _posture->values.pt();
+}
+
+//============================== KnBlendSpace ==================================
+
+KnBlendSpace::KnBlendSpace ( KnChannels* ch ) : KnBlendNode ( Space, ch )
+{
+	_buffer.size ( _floats );
+}
+
+KnBlendSpace::~KnBlendSpace ()
+{
+	for ( int i=0; i<_inputs.size(); i++ ) _inputs[i]->unref();
+}
+
+int KnBlendSpace::add ( KnBlendNode* n, float w )
+{
+	n->ref();
+	_inputs.push() = n;
+	_weights.push() = w;
+	_ev.reserve ( _inputs.size() );
+	_evw.reserve ( _inputs.size() );
+	return _inputs.size()-1;
+}
+
+void KnBlendSpace::weights ( const float* w )
+{
+	for ( int i=0; i<_weights.size(); i++ ) _weights[i]=w[i];
+}
+
+void KnBlendSpace::normalize_weights ()
+{
+	int i;
+	float s=0;
+	for ( i=0; i<_weights.size(); i++ ) s+=_weights[i];
+	if ( s==0 ) return;
+	for ( i=0; i<_weights.size(); i++ ) _weights[i]/=s;
+}
+
+void KnBlendSpace::evaluate ()
+{
+	int i, k;
+
+	// evaluate inputs with non-zero weight:
+	_ev.size(0);
+	_evw.size(0);
+	for ( i=0; i<_inputs.size(); i++ )
+	{	if ( _weights[i]==0 ) continue;
+		_inputs[i]->evaluate();
+		_ev.push() = _inputs[i]->values();
+		_evw.push() = _weights[i];
+	}
+
+	// a single input needs no blending:
+	if ( _ev.size()==1 && _evw[0]==1.0f ) { _values=_ev[0]; return; }
+
+	float* out = _buffer.pt();
+	wsum ( _ev.pt(), _evw.pt(), _ev.size(), _floats, out );
+
+	// quaternions in the opposite hemisphere of the first input were summed
+	// with the wrong sign, and their contribution is corrected here:
+	if ( _ev.size()>1 )
+	{	for ( k=0; k<_quats.size(); k++ )
+		{	int p = _quats[k];
+			const float* q0 = _ev[0]+p;
+			for ( i=1; i<_ev.size(); i++ )
+			{	const float* q = _ev[i]+p;
+				if ( q0[0]*q[0]+q0[1]*q[1]+q0[2]*q[2]+q0[3]*q[3]>=0 ) continue;
+				float w2 = 2.0f*_evw[i];
+				out[p]-=w2*q[0]; out[p+1]-=w2*q[1]; out[p+2]-=w2*q[2]; out[p+3]-=w2*q[3];
+			}
+		}
+	}
+
+	normalize_quats ( out, _quats.pt(), _quats.size() );
+	_values = out;
+}
+
+//============================== KnBlendLayer ==================================
+
+KnBlendLayer::KnBlendLayer ( Mode m, KnBlendNode* base, KnBlendNode* layer, KnBlendMask* mask, KnBlendNode* reference )
+			 :KnBlendNode ( Layer, base->channels() )
+{
+	_buffer.size ( _floats );
+	_mode = (gscenum)m;
+	_base = base; _base->ref();
+	_layer = layer; _layer->ref();
+	_reference = reference; if ( _reference ) _reference->ref();
+	_mask = mask; if ( _mask ) _mask->ref();
+	_weight = 1.0f;
+}
+
+KnBlendLayer::~KnBlendLayer ()
+{
+	_base->unref();
+	_layer->unref();
+	if ( _reference ) _reference->unref();
+	if ( _mask ) _mask->unref();
+}
+
+void KnBlendLayer::mask ( KnBlendMask* m )
+{
+	if ( m ) m->ref();
+	if ( _mask ) _mask->unref();
+	_mask = m;
+}
+
+void KnBlendLayer::evaluate ()
+{
+	int i, k;
+	_base->evaluate();
+	if ( _weight==0 ) { _values=_base->values(); return; }
+
+	_layer->evaluate();
+	if ( _reference ) _reference->evaluate();
+
+	const float* b = _base->values();
+	const float* l = _layer->values();
+	const float* r = _reference? _reference->values() : 0;
+	const float* m = _mask? _mask->weights() : 0;
+	float t = _weight;
+	float* out = _buffer.pt();
+
+	// 1. linear pass on all floats, quaternions are recomputed afterwards:
+	if ( _mode==Override )
+	{	if ( m ) for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*m[k]*(l[k]-b[k]);
+		else	 for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*(l[k]-b[k]);
+	}
+	else if ( r )
+	{	if ( m ) for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*m[k]*(l[k]-r[k]);
+		else	 for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*(l[k]-r[k]);
+	}
+	else
+	{	if ( m ) for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*m[k]*l[k];
+		else	 for ( k=0; k<_floats; k++ ) out[k] = b[k] + t*l[k];
+	}
+
+	// 2. quaternions:
+	for ( i=0; i<_quats.size(); i++ )
+	{	int p = _quats[i];
+		float s = m? t*m[p] : t;
+		GsQuat qb ( b+p );
+		GsQuat ql ( l+p );
+		GsQuat q;
+		if ( _mode==Override )
+		{	if ( s==0 ) { qb.get(out+p); continue; }
+			if ( qb.w*ql.w+qb.x*ql.x+qb.y*ql.y+qb.z*ql.z<0 ) ql.set ( -ql.w, -ql.x, -ql.y, -ql.z );
+			q.set ( qb.w+s*(ql.w-qb.w), qb.x+s*(ql.x-qb.x), qb.y+s*(ql.y-qb.y), qb.z+s*(ql.z-qb.z) );
+		}
+		else
+		{	if ( s==0 ) { qb.get(out+p); continue; }
+			GsQuat d = r? GsQuat(r+p).conjugate()*ql : ql; // rotation from the reference to the layer
+			if ( d.w<0 ) d.set ( -d.w, -d.x, -d.y, -d.z );
+			d.set ( 1.0f+s*(d.w-1.0f), s*d.x, s*d.y, s*d.z ); // nlerp from the identity
+			q = qb*d;
+		}
+		q.get ( out+p );
+	}
+
+	normalize_quats ( out, _quats.pt(), _quats.size() );
+	_values = out;
+}
+
+//============================== EOF =====================================
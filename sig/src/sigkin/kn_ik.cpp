@@ -181,7 +181,7 @@ void KnIk::update_base_end ()
 	_end->update_gmat_local();
 }
 
-void KnIk::base_frame ( GsMat& bframe )
+void KnIk::base_frame ( GsMat& bframe ) const
 {
 	if ( !_base ) return;
    
@@ -206,22 +206,45 @@ void KnIk::set_local ( GsMat& goal )
 	goal = local;
 }
 
-float KnIk::linkage_len ()
+void KnIk::_lengths ( float& d1, float& d2 ) const
 {
-	if ( _d1<0 )
-	{	_d1 = _mid->offset().len(); // could be optimized if guaranteed along single axis
-		_d2 = _end->offset().len();
+	d1 = _mid->offset().len(); // could be optimized if guaranteed along single axis
+	d2 = _end->offset().len();
 
-		if ( _midtwist && _midtwist!=_mid )
-		{	_d2 += _midtwist->offset().len();
-		}
+	if ( _midtwist && _midtwist!=_mid )
+	{	d2 += _midtwist->offset().len();
 	}
-	
+}
+
+float KnIk::linkage_len ()
+{
+	if ( _d1<0 ) _lengths ( _d1, _d2 );
 	return _d1+_d2;
 }
 
-// usually we get here precision of 10E-5 */
+void KnIk::prepare_concurrent_solve ()
+{
+	if ( !_base ) return;
+	linkage_len ();
+	_base->st()->swing_inlimits ( 0, 0 ); // forces the swing-twist values to be in sync
+	_mid->euler();
+	_end->st()->swing_inlimits ( 0, 0 );
+	if ( _midtwist ) _midtwist->euler();
+}
+
 KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
+{
+	if ( _d1<0 ) linkage_len();
+	return _solve ( goal, oang, _result, true );
+}
+
+KnIk::Result KnIk::solve ( const GsMat& goal, float oang, float values[7] ) const
+{
+	return _solve ( goal, oang, values, false );
+}
+
+// usually we get here precision of 10E-5 */
+KnIk::Result KnIk::_solve ( const GsMat& goal, float oang, float* res, bool draw ) const
 {  
 	/* Notation:
 	  m = mid point in base frame
@@ -241,9 +264,9 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
 
 	// 1. get the lengths of the limbs and check goal distance:
 	//	(offsets must be along one single axis!)
-	if ( _d1<0 ) linkage_len();
 	float d1 = _d1;
 	float d2 = _d2;
+	if ( d1<0 ) _lengths ( d1, d2 );
 	float d2d2 = d2*d2;
 	float d1d1 = d1*d1;
 	float dist = e.len();
@@ -275,7 +298,7 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
 	{	oang=oang+gspidiv2;
 	}
 
-	_result[3] = midr; // Store mid flexion
+	res[3] = midr; // Store mid flexion
 
 	// 3. Specify the orbit angle frame (u,v) and mid position m:
 	GsVec n = e/dist; // n is the unit vector pointing from the base to the end joint
@@ -287,14 +310,14 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
 	GsPnt c = (cosa*d1)*n; // c is the center of the circle in local coords
 	float r;
 	GsPnt m = c;
-	if ( aim ) { r=0; c=e*_d1; }
+	if ( aim ) { r=0; c=e*d1; }
 	else
 	{	r = d1 * GS_ABS(sina); // r is the circle radius
 		m += r * ( u*cosf(oang) + v*sinf(oang) ); // mid pos in _base coords
 	}
 
 	// Draw things if required:
-	if ( _snlines )
+	if ( draw && _snlines )
 	{	GsMat bframe;
 		base_frame ( bframe );
 		GsPnt shoulderp ( bframe.e14, bframe.e24, bframe.e34 ); // _base joint in global coords
@@ -323,29 +346,29 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
 	n.set ( -m.y, m.x, 0.0f ); // exactly the same as: n = cross ( GsVec::k, m );
 	n.len ( acosf(m.z/d1) ); // exactly the same as: n.len ( angle ( GsVec::k, m ) );
    
-	_result[0] = n.x; // Store base swing
-	_result[1] = n.y;
+	res[0] = n.x; // Store base swing
+	res[1] = n.y;
 
 	// 5. Specify base twist to reach the end position:
 	GsQuat QS ( n ); // The base swing rotation (init from axis-angle n)
 	GsQuat QE ( GsVec::j, midr ); // The elbow flexion rotation
 
 	if ( (d1+d2-dist)<1.0E-5f ) 
-	{	_result[2] = 0; // use zero base twist when hierarchy has max extension
+	{	res[2] = 0; // use zero base twist when hierarchy has max extension
 	}
 	else
 	{	GsVec b ( 0.0f, 0.0f, d2 );
-		GsVec a = QE.apply(b); // a.z component is not used for _result[2]
+		GsVec a = QE.apply(b); // a.z component is not used for res[2]
 		b = QS.inverse().apply(e);
 		// solve Rz a = b => (Cz -Sz 0, Sz Cz 0, 0 0 1) (ax ay az) = (bx by bz)
 		// => tan (z) = ((by*ax-ay*bx)/(ax*ax-ay*ay)) / ((bx*ax+by*ay)/(ax*ax+ay*ay))
-		_result[2] = atan2f ( a.x*b.y - a.y*b.x, a.x*b.x + a.y*b.y ); // Store base twist
+		res[2] = atan2f ( a.x*b.y - a.y*b.x, a.x*b.x + a.y*b.y ); // Store base twist
 	}
 
 	// 6. Determine the end rotation matrix:
 	if ( _solve_rot_goal )
 	{
-		GsQuat QT ( GsVec::k, _result[2] ); // twist rotation of the shoulder
+		GsQuat QT ( GsVec::k, res[2] ); // twist rotation of the shoulder
 		GsQuat QW = QS * QT * QE;			// composed swing*twist*elbow rotations
 		GsQuat QG ( goal );					// goal rotation
 
@@ -361,11 +384,11 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
    
 		if ( _midtwist==0 ) // the twist comes after the swing, ie, in the twist DOF of the end joint
 		{
-			quat2st ( q, _result[4], _result[5], _result[6] );
+			quat2st ( q, res[4], res[5], res[6] );
 		}
 		else // the twist comes before, in the twist euler joint, before the end joint
 		{
-			quat2ts ( q, _result[4], _result[5], _result[6] );
+			quat2ts ( q, res[4], res[5], res[6] );
 		}
 	}
 	else // leave end rotation untouched
@@ -376,16 +399,16 @@ KnIk::Result KnIk::solve ( const GsMat& goal, float oang )
 	if (_solve_closest) return Ok;
 
 	// The computation is done, now check limits:
-	if ( !_base->st()->swing_inlimits(_result[0],_result[1]) ) return NoBaseSwing;
-	if ( !_base->st()->twist_inlimits(_result[2]) ) return NoBaseTwist;
-	if ( !_mid->euler()->inlimits(_midflexaxis,_result[3]) ) return NoMidFlexion;
+	if ( !_base->st()->swing_inlimits(res[0],res[1]) ) return NoBaseSwing;
+	if ( !_base->st()->twist_inlimits(res[2]) ) return NoBaseTwist;
+	if ( !_mid->euler()->inlimits(_midflexaxis,res[3]) ) return NoMidFlexion;
 	if ( _midtwist==0 )
-	{	if ( !_end->st()->swing_inlimits(_result[4],_result[5]) ) return NoEndSwing;
-		if ( !_end->st()->twist_inlimits(_result[6]) ) return NoMidTwist;
+	{	if ( !_end->st()->swing_inlimits(res[4],res[5]) ) return NoEndSwing;
+		if ( !_end->st()->twist_inlimits(res[6]) ) return NoMidTwist;
 	}
 	else
-	{	if ( !_midtwist->euler()->inlimits(_midtwistaxis,_result[4]) ) return NoMidTwist;
-		if ( !_end->st()->swing_inlimits(_result[5],_result[6]) ) return NoEndSwing;
+	{	if ( !_midtwist->euler()->inlimits(_midtwistaxis,res[4]) ) return NoMidTwist;
+		if ( !_end->st()->swing_inlimits(res[5],res[6]) ) return NoEndSwing;
 	}
 
 	return Ok;
@@ -0,0 +1,153 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <string.h>
+# include <sig/gs_thread_pool.h>
+# include <sigkin/kn_ik_batch.h>
+# include <sigkin/kn_ik_body.h>
+# include <sigkin/kn_skeleton.h>
+
+//# define GS_USE_TRACE1 // solve
+# include <sig/gs_trace.h>
+
+//============================== KnIkBatch ==================================
+
+KnIkBatch::KnIkBatch ()
+{
+	_pool = 0;
+}
+
+KnIkBatch::~KnIkBatch ()
+{
+	init ();
+}
+
+void KnIkBatch::init ()
+{
+	for ( int i=0; i<_items.size(); i++ ) _items[i].ik->unref();
+	_items.size(0);
+	_cands.size(0);
+	_first.size(0);
+}
+
+int KnIkBatch::add ( KnIk* ik, const GsMat& globgoal, float oang )
+{
+	KnIkOrbitSearch os ( ik->type() );
+	os.init = oang;
+	int k = add ( ik, globgoal, os );
+	_items[k].search = 0;
+	return k;
+}
+
+int KnIkBatch::add ( KnIk* ik, const GsMat& globgoal, const KnIkOrbitSearch& osearch )
+{
+	Item& it = _items.push();
+	it.ik = ik;
+	it.ik->ref();
+	it.globgoal = globgoal;
+	it.os = osearch;
+	it.os.oangle = osearch.init;
+	it.os.iterations = 0;
+	it.search = 1;
+	it.result = KnIk::Undef;
+	return _items.size()-1;
+}
+
+int KnIkBatch::add ( KnIkBody* body, int i, const GsMat& globgoal )
+{
+	KnIk* ik = body->ik(i);
+	if ( !ik ) return -1;
+	int k = add ( ik, globgoal, body->osearch(i) );
+	_items[k].search = body->osearch_activation(i)? 1:0;
+	return k;
+}
+
+void KnIkBatch::_solve_item ( int i, int slot, void* udata )
+{
+	Item& it = ((KnIkBatch*)udata)->_items[i];
+	it.goal = it.globgoal;
+	it.ik->set_local ( it.goal );
+	it.os.iterations = 1;
+	it.result = it.ik->solve ( it.goal, it.os.init, it.values );
+}
+
+void KnIkBatch::_solve_cand ( int i, int slot, void* udata )
+{
+	KnIkBatch* b = (KnIkBatch*)udata;
+	Candidate& c = b->_cands[i];
+	Item& it = b->_items[c.item];
+	memcpy ( c.values, it.values, 7*sizeof(float) ); // values not computed by solve() are kept
+	c.result = it.ik->solve ( it.goal, c.oang, c.values );
+}
+
+int KnIkBatch::solve ()
+{
+	GsThreadPool* pool = _pool? _pool : GsThreadPool::shared();
+	int i, k, n=_items.size();
+	if ( n==0 ) return 0;
+
+	// 1. Serial preparation, the only part touching the skeletons:
+	for ( k=0; k<n; k++ )
+	{	KnIk* ik = _items[k].ik;
+		KnSkeleton* sk = ik->base()->skeleton();
+		if ( !sk->global_matrices_uptodate() ) sk->update_global_matrices();
+		ik->prepare_concurrent_solve();
+		memcpy ( _items[k].values, ik->last_result(), 7*sizeof(float) );
+	}
+
+	// 2. Solve all items with their initial orbit angle:
+	pool->run ( n, _solve_item, this );
+
+	// 3. Generate the orbit search candidates of failed items, in the serial search order:
+	_cands.size(0);
+	_first.size(n+1);
+	for ( k=0; k<n; k++ )
+	{	Item& it = _items[k];
+		_first[k] = _cands.size();
+		if ( !it.search || it.result==KnIk::Ok || it.result==KnIk::NotReachable ) continue;
+		const KnIkOrbitSearch& os = it.os;
+		float inc  = os.inc;
+		float ang1 = os.init-inc;
+		float ang2 = os.init+inc;
+		bool run = true;
+		while ( run )
+		{	run = false;
+			inc += os.rate;
+			if ( os.min<=ang1 ) { Candidate& c=_cands.push(); c.item=k; c.oang=ang1; ang1-=inc; run=true; }
+			if ( ang2<=os.max ) { Candidate& c=_cands.push(); c.item=k; c.oang=ang2; ang2+=inc; run=true; }
+		}
+	}
+	_first[n] = _cands.size();
+	GS_TRACE1 ( "items: "<<n<<", candidates: "<<_cands.size() );
+
+	// 4. Evaluate all candidates in parallel and take the first success of each item:
+	if ( _cands.size() ) pool->run ( _cands.size(), _solve_cand, this );
+
+	int count=0;
+	for ( k=0; k<n; k++ )
+	{	Item& it = _items[k];
+		for ( i=_first[k]; i<_first[k+1]; i++ )
+		{	Candidate& c = _cands[i];
+			it.os.iterations++;
+			it.os.oangle = c.oang;
+			it.result = c.result;
+			if ( c.result==KnIk::Ok ) { memcpy ( it.values, c.values, 7*sizeof(float) ); break; }
+		}
+		if ( it.result==KnIk::Ok ) count++;
+	}
+
+	return count;
+}
+
+void KnIkBatch::commit ()
+{
+	for ( int k=0; k<_items.size(); k++ )
+	{	if ( _items[k].result==KnIk::Ok ) _items[k].ik->apply_values ( _items[k].values );
+	}
+}
+
+//============================== EOF =====================================
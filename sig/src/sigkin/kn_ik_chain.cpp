@@ -0,0 +1,367 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sigkin/kn_ik_chain.h>
+# include <sigkin/kn_joint.h>
+# include <sigkin/kn_skeleton.h>
+
+//================================ static functions =================================
+
+// Solves a*x=b for a symmetric positive definite matrix a with Cholesky factorization.
+// a is overwritten with its factorization and b with the solution. Unlike lusolve()
+// no static buffers are used. Returns false if a is not positive definite.
+static bool cholsolve ( GsMatn& a, GsMatn& b )
+{
+	int i, j, k, n=a.lin();
+	double sum;
+
+	for ( i=0; i<n; i++ )
+	{	for ( j=0; j<=i; j++ )
+		{	sum = a(i,j);
+			for ( k=0; k<j; k++ ) sum -= a(i,k)*a(j,k);
+			if ( i==j )
+			{	if ( sum<=0 ) return false;
+				a(i,i) = sqrt(sum);
+			}
+			else
+			{	a(i,j) = sum/a(j,j);
+			}
+		}
+	}
+
+	for ( i=0; i<n; i++ ) // forward substitution with L
+	{	sum = b[i];
+		for ( k=0; k<i; k++ ) sum -= a(i,k)*b[k];
+		b[i] = sum/a(i,i);
+	}
+
+	for ( i=n-1; i>=0; i-- ) // back substitution with L transposed
+	{	sum = b[i];
+		for ( k=i+1; k<n; k++ ) sum -= a(k,i)*b[k];
+		b[i] = sum/a(i,i);
+	}
+
+	return true;
+}
+
+// Returns the rotation error from q1 to q2 as an axis-angle vector in the shortest arc.
+// GsQuat::get() is not used here as it may return nan when w is rounded above 1.
+static GsVec roterror ( const GsQuat& q1, const GsQuat& q2 )
+{
+	GsQuat d = q2 * q1.inverse();
+	if ( d.w<0 ) d*=-1.0f;
+	GsVec v ( d.x, d.y, d.z );
+	float s = v.len();
+	if ( s<gstiny ) return v*2.0f;
+	return v * ( 2.0f*atan2f(s,d.w)/s );
+}
+
+// Returns the minimal rotation from v1 to v2 without calling trigonometric functions,
+// and with a safe result when v1 and v2 are parallel.
+static GsQuat rotfromto ( GsVec v1, GsVec v2 )
+{
+	v1.normalize();
+	v2.normalize();
+	float w = 1.0f + dot(v1,v2);
+	if ( w<gstiny ) // opposite vectors: rotate by pi around any orthogonal axis
+	{	GsVec a = cross ( GS_ABS(v1.x)<0.9f? GsVec::i:GsVec::j, v1 );
+		a.normalize();
+		return GsQuat ( 0, a.x, a.y, a.z );
+	}
+	GsVec c = cross ( v1, v2 );
+	GsQuat q ( w, c.x, c.y, c.z );
+	q.normalize();
+	return q;
+}
+
+//==================================== KnIkChain ===================================
+
+void KnIkChain::_init ()
+{
+	_method = DampedLS;
+	_warmstart = 1;
+	_synced = 0;
+	_maxit = 32;
+	_iterations = 0;
+	_postol = 0.001f;
+	_rottol = 0.005f;
+	_damping = 0.1f;
+	_maxstep = 0.2f;
+	_error = 0;
+}
+
+KnIkChain::KnIkChain ()
+{
+	_init ();
+}
+
+KnIkChain::KnIkChain ( KnJoint* base, KnJoint* end )
+{
+	_init ();
+	init ( base, end );
+}
+
+KnIkChain::~KnIkChain ()
+{
+}
+
+bool KnIkChain::init ( KnJoint* base, KnJoint* end )
+{
+	_joints.size ( 0 );
+	_synced = 0;
+	if ( !base || !end ) return false;
+
+	KnJoint* j = end;
+	while ( j && j!=base ) { _joints.push()=j; j=j->parent(); }
+	if ( !j ) { _joints.size(0); return false; } // base is not an ancestor of end
+	_joints.push() = base;
+	_joints.reverse();
+
+	int n = _joints.size();
+	_lq.size ( n );
+	_lt.size ( n );
+	_gq.size ( n );
+	_gp.size ( n );
+	_fp.size ( n+1 ); // one extra point for the tip
+	_fd.size ( n );
+
+	_jac.size ( 6, 3*n );
+	_jjt.size ( 6, 6 );
+	_err.size ( 6, 1 );
+
+	sync ();
+	return true;
+}
+
+void KnIkChain::sync ()
+{
+	for ( int i=0, s=_joints.size(); i<s; i++ )
+	{	KnJoint* j = _joints[i];
+		_lq[i] = j->rot()->fullvalue();
+		_lt[i] = j->offset() + j->pos()->value();
+	}
+	_synced = _joints.size()>0? 1:0;
+}
+
+void KnIkChain::_readparent ()
+{
+	KnJoint* p = _joints[0]->parent();
+	if ( p )
+	{	const GsMat& m = p->gmat();
+		_pp.set ( m.e14, m.e24, m.e34 );
+		_pq.set ( m );
+	}
+	else
+	{	_pp = GsPnt::null;
+		_pq = GsQuat::null;
+	}
+}
+
+void KnIkChain::_fk ()
+{
+	const GsQuat* pq = &_pq;
+	const GsPnt* pp = &_pp;
+	for ( int i=0, n=_joints.size(); i<n; i++ )
+	{	_gp[i] = *pp + pq->apply(_lt[i]);
+		_gq[i] = *pq * _lq[i];
+		pq = &_gq[i];
+		pp = &_gp[i];
+	}
+}
+
+bool KnIkChain::_converged ( const GsPnt& p, const GsQuat* q, GsVec& perr, GsVec& rerr )
+{
+	const GsQuat& eq = _gq.top();
+	GsPnt e = _gp.top();
+	if ( !_tip.isnull() ) e += eq.apply(_tip);
+	perr = p-e;
+	_error = perr.len();
+	if ( q ) rerr = roterror ( eq, *q );
+	return _error<=_postol && ( !q || rerr.len()<=_rottol );
+}
+
+KnIk::Result KnIkChain::solve ( const GsPnt& p )
+{
+	if ( _joints.empty() ) return KnIk::Undef;
+	if ( !_warmstart || !_synced ) sync();
+	_readparent ();
+	return _method==Fabrik? _solve_fabrik(p,0) : _solve_dls(p,0);
+}
+
+KnIk::Result KnIkChain::solve ( const GsPnt& p, const GsQuat& q )
+{
+	if ( _joints.empty() ) return KnIk::Undef;
+	if ( !_warmstart || !_synced ) sync();
+	_readparent ();
+	return _method==Fabrik? _solve_fabrik(p,&q) : _solve_dls(p,&q);
+}
+
+/* Each joint contributes with three columns, one for each global axis. For a rotation
+   axis a at joint position j the position rows are a x (e-j) and the orientation rows
+   are a itself. The update is dq = J^T (J J^T + d^2 I)^-1 err, so that only a small
+   3x3 or 6x6 system has to be solved per iteration, independently of the chain size. */
+KnIk::Result KnIkChain::_solve_dls ( const GsPnt& p, const GsQuat* q )
+{
+	int i, r, c, k;
+	int n = _joints.size();
+	int m = q? 6:3;
+	int nc = 3*n;
+	GsVec perr, rerr;
+	double sum, lambda2 = double(_damping)*double(_damping);
+
+	_jac.size ( m, nc );
+	_jjt.size ( m, m );
+	_err.size ( m, 1 );
+
+	_fk ();
+	for ( _iterations=0; _iterations<_maxit; _iterations++ )
+	{
+		if ( _converged(p,q,perr,rerr) ) return KnIk::Ok;
+
+		// build jacobian:
+		GsPnt e = p-perr; // current end effector position
+		for ( i=0; i<n; i++ )
+		{	c = 3*i;
+			if ( _joints[i]->rot()->frozen() )
+			{	for ( r=0; r<m; r++ ) { _jac(r,c)=0; _jac(r,c+1)=0; _jac(r,c+2)=0; }
+				continue;
+			}
+			GsVec d = e-_gp[i];
+			_jac(0,c)=0;     _jac(0,c+1)=d.z;  _jac(0,c+2)=-d.y; // x cross d, y cross d, z cross d
+			_jac(1,c)=-d.z;  _jac(1,c+1)=0;    _jac(1,c+2)=d.x;
+			_jac(2,c)=d.y;   _jac(2,c+1)=-d.x; _jac(2,c+2)=0;
+			if ( m==6 )
+			{	_jac(3,c)=1; _jac(3,c+1)=0; _jac(3,c+2)=0;
+				_jac(4,c)=0; _jac(4,c+1)=1; _jac(4,c+2)=0;
+				_jac(5,c)=0; _jac(5,c+1)=0; _jac(5,c+2)=1;
+			}
+		}
+
+		// build J*Jt + lambda^2 I, which is symmetric:
+		for ( r=0; r<m; r++ )
+		{	for ( c=0; c<=r; c++ )
+			{	sum = 0;
+				for ( k=0; k<nc; k++ ) sum += _jac(r,k)*_jac(c,k);
+				_jjt(r,c) = _jjt(c,r) = sum;
+			}
+			_jjt(r,r) += lambda2;
+		}
+
+		_err[0]=perr.x; _err[1]=perr.y; _err[2]=perr.z;
+		if ( m==6 ) { _err[3]=rerr.x; _err[4]=rerr.y; _err[5]=rerr.z; }
+		if ( !cholsolve(_jjt,_err) ) break;
+
+		// dq = Jt * y, clamped to the maximum step, and applied in the parent frame:
+		for ( i=0; i<n; i++ )
+		{	c = 3*i;
+			GsVec w;
+			for ( k=0; k<3; k++ )
+			{	sum = 0;
+				for ( r=0; r<m; r++ ) sum += _jac(r,c+k)*_err[r];
+				w.e[k] = float(sum);
+			}
+			float a = w.len();
+			if ( a<gstiny ) continue;
+			if ( a>_maxstep ) w.len(_maxstep);
+			const GsQuat& pq = i? _gq[i-1]:_pq; // old parent frame
+			_lq[i] = GsQuat(pq.inverse().apply(w)) * _lq[i];
+			_lq[i].normalize();
+		}
+		_fk ();
+	}
+
+	return _converged(p,q,perr,rerr)? KnIk::Ok : KnIk::NotReachable;
+}
+
+KnIk::Result KnIkChain::_solve_fabrik ( const GsPnt& p, const GsQuat* q )
+{
+	int i;
+	int n = _joints.size();
+	bool hastip = !_tip.isnull() && !q; // with a rotation goal the tip is handled below
+	int np = hastip? n+1:n; // number of points
+	GsVec perr, rerr;
+
+	// goal for the last point:
+	GsPnt goal = p;
+	if ( q && !_tip.isnull() ) goal -= q->apply(_tip);
+
+	_fk ();
+	for ( i=0; i<n; i++ ) _fp[i]=_gp[i];
+	if ( hastip ) _fp[n] = _gp[n-1] + _gq[n-1].apply(_tip);
+
+	float total = 0;
+	for ( i=0; i<np-1; i++ ) { _fd[i]=dist(_fp[i],_fp[i+1]); total+=_fd[i]; }
+
+	const GsPnt root = _fp[0];
+	float tol2 = _postol*_postol;
+
+	_iterations = 0;
+	if ( np>1 )
+	{	if ( dist2(root,goal)>=total*total ) // not reachable: stretch towards the goal
+		{	GsVec dir = goal-root;
+			dir.normalize();
+			for ( i=1; i<np; i++ ) _fp[i] = _fp[i-1] + dir*_fd[i-1];
+		}
+		else
+		{	for ( ; _iterations<_maxit; _iterations++ )
+			{	if ( dist2(_fp[np-1],goal)<=tol2 ) break;
+				_fp[np-1] = goal; // backward pass
+				for ( i=np-2; i>=0; i-- )
+				{	GsVec v = _fp[i]-_fp[i+1]; v.len(_fd[i]);
+					_fp[i] = _fp[i+1]+v;
+				}
+				_fp[0] = root; // forward pass
+				for ( i=1; i<np; i++ )
+				{	GsVec v = _fp[i]-_fp[i-1]; v.len(_fd[i-1]);
+					_fp[i] = _fp[i-1]+v;
+				}
+			}
+		}
+	}
+
+	// convert the new point positions into joint rotations, from the base to the end:
+	const GsQuat* pq = &_pq;
+	for ( i=0; i<n; i++ )
+	{	_gq[i] = *pq * _lq[i];
+		if ( i+1<np && !_joints[i]->rot()->frozen() )
+		{	GsVec v = _gq[i].apply ( i+1<n? _lt[i+1]:_tip ); // current link direction
+			GsVec w = _fp[i+1]-_fp[i];					   // desired link direction
+			if ( v.norm2()>gstiny && w.norm2()>gstiny )
+			{	GsQuat d = rotfromto ( v, w );
+				_lq[i] = pq->inverse() * d * _gq[i];
+				_lq[i].normalize();
+				_gq[i] = *pq * _lq[i];
+			}
+		}
+		pq = &_gq[i];
+	}
+
+	if ( q && !_joints.top()->rot()->frozen() ) // impose end orientation
+	{	_lq[n-1] = (n>1? _gq[n-2]:_pq).inverse() * *q;
+		_lq[n-1].normalize();
+	}
+
+	_fk ();
+	return _converged(p,q,perr,rerr)? KnIk::Ok : KnIk::NotReachable;
+}
+
+void KnIkChain::apply ()
+{
+	for ( int i=0, n=_joints.size(); i<n; i++ )
+	{	KnJoint* j = _joints[i];
+		KnJointRot* r = j->rot();
+		KnJointRot::ValueMode mode = r->getmode();
+		r->setmode ( KnJointRot::FullMode );
+		r->value ( _lq[i] );
+		r->setmode ( mode );
+		if ( j->rot_type()==KnJoint::TypeST ) j->st()->set ( r->localvalue() ); // enforce limits
+		else if ( j->rot_type()==KnJoint::TypeEuler ) j->euler()->set ( r->localvalue() );
+		_lq[i] = r->fullvalue(); // keep accepted values for the next warm start
+	}
+}
+
+//======================================= EOF =====================================
@@ -15,7 +15,7 @@
 //============================= KnJoint ============================
 
 KnJoint::KnJoint ( KnSkeleton* kn, KnJoint* parent, RotType rtype, int i )
-		: _pos(0), _rot(0)
+		: _children(&kn->_arena), _pos(0), _rot(0)
 {
 	_visgeo = 0;
 	_colgeo = 0;
@@ -25,6 +25,7 @@ KnJoint::KnJoint ( KnSkeleton* kn, KnJoint* parent, RotType rtype, int i )
 	_parent = parent;
 
 	_lmattodate = 0;
+	_changes = 0;
 	_name = 0;
 	_index = i;
 	_skeleton = kn;
@@ -183,6 +184,7 @@ void KnJoint::update_gmat_up ( KnJoint* stopjoint )
 void KnJoint::set_lmat_changed ()
 {
 	_lmattodate = 0;
+	_changes = ++_skeleton->_changes;
 	_skeleton->invalidate_global_matrices();
 }
 
@@ -9,7 +9,7 @@
 
 //============================= KnJointName ============================
 
-GsTable<long> KnJointName::_htable;
+GsHashTable<long> KnJointName::_htable;
 gsword KnJointName::_undefid = gsword(65535);
 
 void KnJointName::operator= ( const char* st )
@@ -68,11 +68,13 @@ void KnJointRot::value ( const float* f )
 	if ( _frozen ) return;
 
 	if ( !_prepost || _mode==FullMode )
-	{	_quat.set(f);
+	{	if ( (_sync&FQ) && _quat.e[0]==f[0] && _quat.e[1]==f[1] && _quat.e[2]==f[2] && _quat.e[3]==f[3] ) return; // no change
+		_quat.set(f);
 		setowner(FQ);
 	} 
 	else // local mode only with prerot/postrot set
-	{	_lquat.set(f);
+	{	if ( (_sync&LQ) && _lquat.e[0]==f[0] && _lquat.e[1]==f[1] && _lquat.e[2]==f[2] && _lquat.e[3]==f[3] ) return;
+		_lquat.set(f);
 		setowner(LQ);
 	}
 }
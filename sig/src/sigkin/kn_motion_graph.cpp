@@ -0,0 +1,372 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <math.h>
+# include <float.h>
+# include <sig/gs_heap.h>
+# include <sig/gs_thread_pool.h>
+# include <sigkin/kn_motion_graph.h>
+# include <sigkin/kn_motion.h>
+# include <sigkin/kn_skeleton.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+# define TILE 64
+
+//============================== KnMotionGraph ==================================
+
+KnMotionGraph::KnMotionGraph ( KnSkeleton* sk )
+{
+	_sk = sk;
+	_sk->ref();
+	_pool = 0;
+	_window = 5;
+	_mingap = 15;
+	_tile = TILE;
+	_dim = 0;
+	_threshold = 0.1f;
+	_tweight = 1.0f;
+}
+
+KnMotionGraph::~KnMotionGraph ()
+{
+	init ();
+	_sk->unref();
+}
+
+void KnMotionGraph::init ()
+{
+	_graph.init ();
+	_nodes.size(0);
+	_nfirst.size(0);
+	_trans.size(0);
+	for ( int i=0; i<_motions.size(); i++ ) _motions[i]->unref();
+	_motions.size(0);
+	_first.size(0);
+	_feat.size(0);
+	_clip.size(0);
+	_dim = 0;
+}
+
+int KnMotionGraph::add_motion ( KnMotion* m )
+{
+	m->ref();
+	_motions.push() = m;
+	return _motions.size()-1;
+}
+
+// Features of all frames, in the character frame of the root and scaled by the character size
+void KnMotionGraph::_extract ()
+{
+	int i, j, f, g, nm=_motions.size();
+	const GsArray<KnJoint*>& fjoints = _fjoints.size()? _fjoints : _sk->joints();
+	int nj = fjoints.size();
+	_dim = nj*3;
+
+	_first.size ( nm+1 );
+	_first[0] = 0;
+	for ( i=0; i<nm; i++ ) _first[i+1] = _first[i]+_motions[i]->frames();
+	int n = _first[nm];
+	_feat.size ( n*_dim );
+	_clip.size ( n );
+
+	double size2=0;
+	for ( i=0, g=0; i<nm; i++ )
+	{	KnMotion* m = _motions[i];
+		m->connect ( _sk );
+		for ( f=0; f<(int)m->frames(); f++, g++ )
+		{	m->apply_frame ( f );
+			_sk->update_global_matrices ();
+			const GsMat& r = _sk->root()->gmat();
+			float a = atan2f ( r.e13, r.e33 ), s=sinf(a), c=cosf(a);
+			float* feat = &_feat[g*_dim];
+			for ( j=0; j<nj; j++ )
+			{	GsVec p = fjoints[j]->gcenter();
+				float x=p.x-r.e14, z=p.z-r.e34;
+				feat[0] = x*c - z*s;
+				feat[1] = p.y;
+				feat[2] = x*s + z*c;
+				size2 += dist2 ( p, GsVec(r.e14,r.e24,r.e34) );
+				feat += 3;
+			}
+			_clip[g] = i;
+		}
+	}
+
+	// scale so that distances are relative to the average joint distance to the root:
+	float size = n*nj>0? (float)sqrt(size2/(n*nj)) : 0;
+	if ( size>0 )
+	{	float s = 1.0f/size;
+		for ( i=0; i<_feat.size(); i++ ) _feat[i]*=s;
+	}
+}
+
+// Squared distance between the features of global frames a and b
+static inline float fdist2 ( const float* fa, const float* fb, int dim )
+{
+	float d2=0;
+	for ( int d=0; d<dim; d++ ) { float v=fa[d]-fb[d]; d2+=v*v; }
+	return d2;
+}
+
+float KnMotionGraph::_wdist ( int a, int b ) const
+{
+	int w=_window, nj=_dim/3;
+	if ( a+w>_first[_clip[a]+1] || b+w>_first[_clip[b]+1] ) return -1;
+	float sum=0;
+	for ( int k=0; k<w; k++ ) sum += fdist2 ( &_feat[(a+k)*_dim], &_feat[(b+k)*_dim], _dim );
+	return sqrtf ( sum/(w*nj) );
+}
+
+float KnMotionGraph::distance ( int m1, int f1, int m2, int f2 ) const
+{
+	if ( _first.size()!=_motions.size()+1 ) return -1; // not built
+	return _wdist ( _first[m1]+f1, _first[m2]+f2 );
+}
+
+//============================== tiles ==================================
+
+// Shared data of the parallel computation of the distance matrix
+struct KnMgTileJob
+{	KnMotionGraph* mg;
+	GsArray<int> tiles;					// pairs of tile row and column, with row<=column
+	GsArray<KnMotionGraph::Transition>* results; // per slot
+	float** scratch;					// per slot
+	int n;								// number of frames
+	static void run ( int t, int slot, void* udata );
+};
+
+void KnMgTileJob::run ( int t, int slot, void* udata )
+{
+	KnMgTileJob& job = *(KnMgTileJob*)udata;
+	const KnMotionGraph& mg = *job.mg;
+	const int T=mg._tile, w=mg._window, dim=mg._dim, n=job.n;
+	const float* feat = mg._feat.pt();
+	const int* clip = mg._clip.pt();
+	const int* first = mg._first.pt();
+	float inv = 1.0f/(w*(dim/3));
+
+	int r0=job.tiles[t*2]*T, c0=job.tiles[t*2+1]*T;
+	int r1=GS_MIN(r0+T,n), c1=GS_MIN(c0+T,n);
+
+	// window distances are needed with a border of 1 for the local minima test,
+	// and frame distances with an additional border of w-1 for the windows:
+	int wr0=r0-1, wc0=c0-1, wrn=r1-r0+2, wcn=c1-c0+2;
+	int drn=wrn+w-1, dcn=wcn+w-1;
+	float* D = job.scratch[slot];
+	float* W = D + (T+1+w)*(T+1+w);
+
+	int i, j, k;
+	for ( i=0; i<drn; i++ )
+	{	int a=wr0+i;
+		float* drow = D+i*dcn;
+		if ( a<0 || a>=n ) continue; // never used by valid windows
+		const float* fa = feat+a*dim;
+		for ( j=0; j<dcn; j++ )
+		{	int b=wc0+j;
+			drow[j] = b<0||b>=n? 0 : fdist2 ( fa, feat+b*dim, dim );
+		}
+	}
+
+	for ( i=0; i<wrn; i++ )
+	{	int a=wr0+i;
+		bool va = a>=0 && a<n && a+w<=first[clip[a]+1];
+		for ( j=0; j<wcn; j++ )
+		{	int b=wc0+j;
+			float& wd = W[i*wcn+j];
+			if ( !va || b<0 || b>=n || b+w>first[clip[b]+1] ) { wd=FLT_MAX; continue; }
+			float sum=0;
+			for ( k=0; k<w; k++ ) sum += D[(i+k)*dcn+j+k];
+			wd = sqrtf ( sum*inv );
+		}
+	}
+
+	// local minima below the threshold, each pair tested once with a<b:
+	GsArray<KnMotionGraph::Transition>& res = job.results[slot];
+	for ( i=1; i<wrn-1; i++ )
+	{	int a=wr0+i;
+		for ( j=1; j<wcn-1; j++ )
+		{	int b=wc0+j;
+			if ( b<=a ) continue;
+			if ( clip[a]==clip[b] && b-a<mg._mingap ) continue;
+			float wd = W[i*wcn+j];
+			if ( wd>mg._threshold ) continue;
+			// strictly lower than the neighbors before it, so that plateaus give one minimum:
+			const float* w0 = W+(i-1)*wcn+j-1;
+			const float* w1 = w0+wcn;
+			const float* w2 = w1+wcn;
+			if ( !(wd<w0[0] && wd<w0[1] && wd<w0[2] && wd<w1[0] &&
+				   wd<=w1[2] && wd<=w2[0] && wd<=w2[1] && wd<=w2[2]) ) continue;
+			KnMotionGraph::Transition& tr = res.push();
+			tr.m1=clip[a]; tr.f1=a-first[tr.m1];
+			tr.m2=clip[b]; tr.f2=b-first[tr.m2];
+			tr.dist=wd;
+		}
+	}
+}
+
+static int trcompare ( const KnMotionGraph::Transition* t1, const KnMotionGraph::Transition* t2 )
+{
+	if ( t1->m1!=t2->m1 ) return t1->m1-t2->m1;
+	if ( t1->f1!=t2->f1 ) return t1->f1-t2->f1;
+	if ( t1->m2!=t2->m2 ) return t1->m2-t2->m2;
+	return t1->f2-t2->f2;
+}
+
+int KnMotionGraph::build ()
+{
+	_graph.init ();
+	_nodes.size(0);
+	_nfirst.size(0);
+	_trans.size(0);
+
+	_extract ();
+	int i, j, n=_first.top();
+	GS_TRACE1 ( "Features extracted for "<<n<<" frames" );
+
+	GsThreadPool* pool = _pool? _pool : GsThreadPool::shared();
+	KnMgTileJob job;
+	job.mg = this;
+	job.n = n;
+	int nt = (n+_tile-1)/_tile;
+	job.tiles.capacity ( nt*(nt+1) );
+	for ( i=0; i<nt; i++ )
+	{	for ( j=i; j<nt; j++ ) { job.tiles.push()=i; job.tiles.push()=j; }
+	}
+
+	int slots = pool->slots();
+	int tsize = _tile+1+_window;
+	job.results = new GsArray<Transition>[slots];
+	job.scratch = new float*[slots];
+	for ( i=0; i<slots; i++ ) job.scratch[i] = new float[tsize*tsize+(_tile+2)*(_tile+2)];
+
+	pool->run ( job.tiles.size()/2, KnMgTileJob::run, &job, 1 );
+
+	// merge the results in both directions, since distances are symmetric:
+	for ( i=0; i<slots; i++ )
+	{	const GsArray<Transition>& res = job.results[i];
+		for ( j=0; j<res.size(); j++ )
+		{	const Transition& t = res[j];
+			_trans.push() = t;
+			Transition& r = _trans.push();
+			r.m1=t.m2; r.f1=t.f2; r.m2=t.m1; r.f2=t.f1; r.dist=t.dist;
+		}
+		delete[] job.scratch[i];
+	}
+	delete[] job.scratch;
+	delete[] job.results;
+	_trans.sort ( trcompare ); // the order of the slots depends on the scheduling
+	GS_TRACE1 ( "Transitions found: "<<_trans.size() );
+
+	_make_graph ();
+	return _trans.size();
+}
+
+void KnMotionGraph::_make_graph ()
+{
+	int i, f, n=_first.top(), nm=_motions.size();
+
+	// frames with nodes:
+	GsArray<int> nodeat ( n );
+	nodeat.setall ( -1 );
+	for ( i=0; i<nm; i++ )
+	{	if ( _first[i+1]==_first[i] ) continue;
+		nodeat[_first[i]] = nodeat[_first[i+1]-1] = 0;
+	}
+	for ( i=0; i<_trans.size(); i++ )
+	{	const Transition& t = _trans[i];
+		nodeat[_first[t.m1]+t.f1] = nodeat[_first[t.m2]+t.f2] = 0;
+	}
+
+	// nodes in clip and frame order, linked along the clips:
+	_nfirst.size ( nm+1 );
+	for ( i=0; i<nm; i++ )
+	{	_nfirst[i] = _nodes.size();
+		KnMotion* m = _motions[i];
+		KnMgNode* prev=0;
+		for ( f=0; f<(int)m->frames(); f++ )
+		{	int g = _first[i]+f;
+			if ( nodeat[g]<0 ) continue;
+			KnMgNode* node = new KnMgNode;
+			node->motion = i;
+			node->frame = f;
+			node->id = nodeat[g] = _nodes.size();
+			_nodes.push() = node;
+			_graph.insert ( node );
+			if ( prev ) prev->linkto ( node, m->keytime(f)-m->keytime(prev->frame) );
+			prev = node;
+		}
+	}
+	_nfirst[nm] = _nodes.size();
+
+	for ( i=0; i<_trans.size(); i++ )
+	{	const Transition& t = _trans[i];
+		KnMgNode* n1 = _nodes[nodeat[_first[t.m1]+t.f1]];
+		KnMgNode* n2 = _nodes[nodeat[_first[t.m2]+t.f2]];
+		n1->linkto(n2,_tweight*t.dist)->dist = t.dist;
+	}
+}
+
+KnMgNode* KnMotionGraph::node ( int m, int f ) const
+{
+	if ( m<0 || m+1>=_nfirst.size() ) return 0;
+	int a=_nfirst[m], b=_nfirst[m+1]-1;
+	while ( a<=b ) // binary search since nodes are in frame order
+	{	int c = (a+b)/2;
+		if ( _nodes[c]->frame<f ) a=c+1;
+		else if ( _nodes[c]->frame>f ) b=c-1;
+		else return _nodes[c];
+	}
+	return 0;
+}
+
+bool KnMotionGraph::search ( KnMgNode* start, bool (*goal)(const KnMgNode*,void*), void* udata,
+							 GsArray<KnMgNode*>& path, float* cost, float maxcost )
+{
+	path.size(0);
+	int n = _nodes.size();
+	GsArray<float> dist ( n );
+	GsArray<int> parent ( n );
+	dist.setall ( FLT_MAX );
+	parent.setall ( -1 );
+
+	GsIndexedHeap<float> queue;
+	queue.ids ( n );
+	dist[start->id] = 0;
+	queue.insert ( start->id, 0 );
+	int found = -1;
+	while ( !queue.empty() )
+	{	int id = queue.top();
+		float c = queue.lowest_cost();
+		queue.remove ();
+		KnMgNode* node = _nodes[id];
+		if ( goal(node,udata) ) { found=id; break; }
+		const GsArray<KnMgLink*>& links = node->links();
+		for ( int i=0; i<links.size(); i++ )
+		{	KnMgLink* l = links[i];
+			KnMgNode* ln = l->node();
+			if ( l->blocked() || ln->blocked() ) continue;
+			float nc = c + l->cost();
+			if ( maxcost>0 && nc>maxcost ) continue;
+			if ( nc<dist[ln->id] )
+			{	dist[ln->id] = nc;
+				parent[ln->id] = id;
+				if ( queue.contains(ln->id) ) queue.decrease_key ( ln->id, nc );
+				else queue.insert ( ln->id, nc );
+			}
+		}
+	}
+	if ( found<0 ) return false;
+
+	if ( cost ) *cost = dist[found];
+	for ( int id=found; id>=0; id=parent[id] ) path.push()=_nodes[id];
+	path.reverse ();
+	return true;
+}
+
+//============================== end of file ===============================
@@ -0,0 +1,286 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <math.h>
+# include <float.h>
+# include <sigkin/kn_motion_index.h>
+# include <sigkin/kn_motion.h>
+# include <sigkin/kn_skeleton.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+# define LEAF_SIZE 8
+
+//============================== KnMotionIndex ==================================
+
+KnMotionIndex::KnMotionIndex ( KnSkeleton* sk )
+{
+	_sk = sk;
+	_sk->ref();
+	_ttimes.push()=0.2f; _ttimes.push()=0.4f; _ttimes.push()=0.6f;
+	_wpos = _wvel = _wtraj = 1.0f;
+	_dim = 0;
+}
+
+KnMotionIndex::~KnMotionIndex ()
+{
+	init ();
+	_sk->unref();
+}
+
+void KnMotionIndex::init ()
+{
+	for ( int i=0; i<_motions.size(); i++ ) _motions[i]->unref();
+	_motions.size(0);
+	_first.size(0);
+	_fjoints.size(0);
+	_entries.size(0);
+	_raw.size(0);
+	_features.size(0);
+	_order.size(0);
+	_row.size(0);
+	_scale.size(0);
+	_nodes.size(0);
+	_dim = 0;
+}
+
+// character frame of the root: floor position and heading angle about Y
+struct CharFrame { float x, z, s, c; };
+
+static void char_frame ( const GsMat& m, CharFrame& cf )
+{
+	cf.x = m.e14;
+	cf.z = m.e34;
+	float a = atan2f ( m.e13, m.e33 ); // root Z axis projected on the floor
+	cf.s = sinf(a);
+	cf.c = cosf(a);
+}
+
+// rotates the vector (x,z) to the character frame
+static inline void to_char ( const CharFrame& cf, float x, float z, float* r )
+{
+	r[0] = x*cf.c - z*cf.s;
+	r[1] = x*cf.s + z*cf.c;
+}
+
+int KnMotionIndex::add_motion ( KnMotion* m )
+{
+	int i, j, f, nf=m->frames();
+	m->ref();
+	m->connect ( _sk );
+
+	if ( _fjoints.empty() )
+	{	const GsArray<KnJoint*>& joints = _sk->joints();
+		for ( i=0; i<joints.size(); i++ ) if ( joints[i]->children()==0 ) _fjoints.push()=joints[i];
+	}
+	int nj=_fjoints.size(), nt=_ttimes.size();
+	_dim = nj*6 + nt*4;
+
+	// forward kinematics is done only once per frame here:
+	GsArray<GsVec> gpos ( nf*nj );
+	GsArray<CharFrame> cfs ( nf );
+	for ( f=0; f<nf; f++ )
+	{	m->apply_frame ( f );
+		_sk->update_global_matrices ();
+		char_frame ( _sk->root()->gmat(), cfs[f] );
+		for ( j=0; j<nj; j++ ) gpos[f*nj+j] = _fjoints[j]->gcenter();
+	}
+
+	int e0 = _entries.size();
+	_motions.push() = m;
+	_first.push() = e0;
+	_entries.size ( e0+nf );
+	_raw.size ( (e0+nf)*_dim );
+
+	int fut=0;
+	for ( f=0; f<nf; f++ )
+	{	Entry& e = _entries[e0+f];
+		e.motion = _motions.size()-1;
+		e.frame = f;
+		const CharFrame& cf = cfs[f];
+		float* feat = &_raw[(e0+f)*_dim];
+
+		// joint positions and velocities, with backward differences at the last frame:
+		int f1 = f+1<nf? f:f-1, f2=f1+1;
+		float dt = f2<nf && f1>=0? m->keytime(f2)-m->keytime(f1) : 0;
+		for ( j=0; j<nj; j++ )
+		{	const GsVec& p = gpos[f*nj+j];
+			to_char ( cf, p.x-cf.x, p.z-cf.z, feat );
+			feat[2] = feat[1]; feat[1] = p.y; // x,z to x,y,z
+			if ( dt>0 )
+			{	GsVec v = (gpos[f2*nj+j]-gpos[f1*nj+j])/dt;
+				to_char ( cf, v.x, v.z, feat+3 );
+				feat[5] = feat[4]; feat[4] = v.y;
+			}
+			else { feat[3]=feat[4]=feat[5]=0; }
+			feat += 6;
+		}
+
+		// future trajectory, clamped to the last frame:
+		for ( i=0; i<nt; i++ )
+		{	float t = m->keytime(f)+_ttimes[i];
+			if ( i==0 ) fut=f;
+			while ( fut+1<nf && m->keytime(fut+1)<=t ) fut++;
+			const CharFrame& cft = cfs[fut];
+			to_char ( cf, cft.x-cf.x, cft.z-cf.z, feat );
+			to_char ( cf, cft.s, cft.c, feat+2 );
+			feat += 4;
+		}
+	}
+	GS_TRACE1 ( "Motion added with "<<nf<<" frames, dimension "<<_dim );
+	return _motions.size()-1;
+}
+
+void KnMotionIndex::build ()
+{
+	int i, d, n=_entries.size();
+	int nj=_fjoints.size(), nt=_ttimes.size();
+	_scale.size ( _dim );
+
+	// dimensions are normalized by groups to keep the relative scale of the axes in a group:
+	// the position and the velocity of each joint, and the trajectory positions and directions
+	GsArray<int> group ( _dim );
+	GsArray<float> weight;
+	for ( i=0; i<nj; i++ )
+	{	for ( d=0; d<6; d++ ) group[i*6+d] = i*2+d/3;
+		weight.push()=_wpos; weight.push()=_wvel;
+	}
+	for ( i=0; i<nt; i++ )
+	{	for ( d=0; d<4; d++ ) group[nj*6+i*4+d] = nj*2+d/2;
+	}
+	weight.push()=_wtraj; weight.push()=_wtraj;
+
+	// standard deviation of each group as the root of the mean variance of its dimensions:
+	GsArray<double> var ( weight.size() );
+	GsArray<int> count ( weight.size() );
+	var.setall ( 0 );
+	count.setall ( 0 );
+	for ( d=0; d<_dim; d++ )
+	{	double sum=0, sum2=0;
+		for ( i=0; i<n; i++ ) { double v=_raw[i*_dim+d]; sum+=v; sum2+=v*v; }
+		if ( n>0 ) var[group[d]] += sum2/n - (sum/n)*(sum/n);
+		count[group[d]]++;
+	}
+	for ( d=0; d<_dim; d++ )
+	{	int g = group[d];
+		float sd = (float) sqrt ( var[g]/count[g] );
+		_scale[d] = sd>1.0e-6f? weight[g]/sd : weight[g];
+	}
+
+	// kd-tree over the normalized features:
+	_order.size ( n );
+	for ( i=0; i<n; i++ ) _order[i]=i;
+	_features.size ( n*_dim );
+	for ( i=0; i<n*_dim; i++ ) _features[i] = _raw[i]*_scale[i%_dim];
+	_nodes.size ( 0 );
+	if ( n>0 ) _build ( 0, n );
+
+	// place rows in tree order so that leaves are contiguous in memory:
+	GsArray<float> sorted ( n*_dim );
+	_row.size ( n );
+	for ( i=0; i<n; i++ )
+	{	for ( d=0; d<_dim; d++ ) sorted[i*_dim+d] = _features[_order[i]*_dim+d];
+		_row[_order[i]] = i;
+	}
+	_features.adopt ( sorted );
+	GS_TRACE1 ( "Index built with "<<n<<" entries and "<<_nodes.size()<<" nodes" );
+}
+
+int KnMotionIndex::_build ( int i1, int i2 )
+{
+	int ni = _nodes.size();
+	_nodes.push();
+	if ( i2-i1<=LEAF_SIZE )
+	{	Node& nd = _nodes[ni];
+		nd.dim=-1; nd.a=i1; nd.b=i2; nd.split=0;
+		return ni;
+	}
+
+	// split at the median of the dimension with the largest extent:
+	int i, d, bestd=0;
+	float beste=-1;
+	for ( d=0; d<_dim; d++ )
+	{	float a=_features[_order[i1]*_dim+d], b=a;
+		for ( i=i1+1; i<i2; i++ )
+		{	float v=_features[_order[i]*_dim+d];
+			if ( v<a ) a=v; else if ( v>b ) b=v;
+		}
+		if ( b-a>beste ) { beste=b-a; bestd=d; }
+	}
+
+	// quickselect of the median:
+	int k=(i1+i2)/2, lo=i1, hi=i2-1, tmp;
+	# define VAL(i) _features[_order[i]*_dim+bestd]
+	while ( lo<hi )
+	{	float pivot = VAL((lo+hi)/2);
+		int l=lo, h=hi;
+		while ( l<=h )
+		{	while ( VAL(l)<pivot ) l++;
+			while ( VAL(h)>pivot ) h--;
+			if ( l<=h ) { GS_SWAPT(_order[l],_order[h],tmp); l++; h--; }
+		}
+		if ( k<=h ) hi=h; else if ( k>=l ) lo=l; else break;
+	}
+	float split = VAL(k);
+	# undef VAL
+
+	int a = _build ( i1, k );
+	int b = _build ( k, i2 );
+	Node& nd = _nodes[ni]; // reference taken after the recursion since _nodes may grow
+	nd.dim=bestd; nd.split=split; nd.a=a; nd.b=b;
+	return ni;
+}
+
+void KnMotionIndex::normalize ( float* feat ) const
+{
+	for ( int d=0; d<_dim; d++ ) feat[d]*=_scale[d];
+}
+
+void KnMotionIndex::_search ( int n, const float* q, int& best, float& bestd2 ) const
+{
+	const Node& nd = _nodes[n];
+	if ( nd.dim<0 )
+	{	for ( int r=nd.a; r<nd.b; r++ )
+		{	const float* f = &_features[r*_dim];
+			float d2=0;
+			for ( int d=0; d<_dim && d2<bestd2; d++ ) { float v=f[d]-q[d]; d2+=v*v; }
+			if ( d2<bestd2 ) { bestd2=d2; best=r; }
+		}
+		return;
+	}
+	float diff = q[nd.dim]-nd.split;
+	_search ( diff<0? nd.a:nd.b, q, best, bestd2 );
+	if ( diff*diff<bestd2 ) _search ( diff<0? nd.b:nd.a, q, best, bestd2 );
+}
+
+int KnMotionIndex::search ( const float* query, float* d ) const
+{
+	if ( _nodes.empty() ) return -1;
+	int best=-1;
+	float bestd2=FLT_MAX;
+	_search ( 0, query, best, bestd2 );
+	if ( d ) *d = sqrtf(bestd2);
+	return _order[best];
+}
+
+int KnMotionIndex::search_linear ( const float* query, float* d ) const
+{
+	int best=-1, n=_order.size();
+	float bestd2=FLT_MAX;
+	for ( int r=0; r<n; r++ )
+	{	const float* f = &_features[r*_dim];
+		float d2=0;
+		for ( int i=0; i<_dim; i++ ) { float v=f[i]-query[i]; d2+=v*v; }
+		if ( d2<bestd2 ) { bestd2=d2; best=r; }
+	}
+	if ( best<0 ) return -1;
+	if ( d ) *d = sqrtf(bestd2);
+	return _order[best];
+}
+
+//============================== end of file ===============================
@@ -0,0 +1,132 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_string.h>
+# include <sig/sn_model.h>
+# include <sig/sa_action.h>
+# include <sigkin/kn_rig_builder.h>
+# include <sigkin/kn_skeleton.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+//============================== SaRigCollect ==================================
+
+namespace { // local to this file
+
+// Merges all visible models of a scene graph, in the coordinates of the applied node
+class SaRigCollect : public SaAction
+{  public :
+	GsModel* model;
+	SaRigCollect ( GsModel* m ) { model=m; }
+   private :
+	virtual bool shape_apply ( SnShape* s ) override
+	{	if ( gs_compare(s->instance_name(),SnModel::class_name)!=0 ) return true;
+		if ( !s->visible() ) return true;
+		GsModel m;
+		m = *((SnModel*)s)->model();
+		m.transform ( get_top_matrix() );
+		model->add_model ( m );
+		return true;
+	}
+};
+
+} // end namespace
+
+//============================== KnRigBuilder ==================================
+
+KnRigBuilder::KnRigBuilder ()
+{
+}
+
+KnRigBuilder::~KnRigBuilder ()
+{
+	init ();
+}
+
+void KnRigBuilder::init ()
+{
+	for ( int i=0; i<_parts.size(); i++ )
+	{	gs_string_delete ( _parts[i].name );
+		_parts[i].model->unref();
+	}
+	_parts.size ( 0 );
+}
+
+static bool valid_parent ( const GsArray<KnRigBuilder::Part>& parts, int parent )
+{
+	if ( parent>=0 ) return parent<parts.size();
+	return parts.empty(); // only the first part can be the root
+}
+
+int KnRigBuilder::add ( const GsModel* m, const GsMat& mat, int parent, const GsPnt& pivot, const char* name )
+{
+	if ( !valid_parent(_parts,parent) ) return -1;
+	GsModel* model = new GsModel;
+	model->ref();
+	*model = *m;
+	model->transform ( mat );
+	Part& p = _parts.push();
+	p.name = gs_string_new ( name );
+	p.model = model;
+	p.pivot = pivot;
+	p.parent = parent;
+	return _parts.size()-1;
+}
+
+int KnRigBuilder::add ( SnNode* n, int parent, const GsPnt& pivot, const char* name )
+{
+	if ( !valid_parent(_parts,parent) ) return -1;
+	GsModel m;
+	SaRigCollect collect ( &m );
+	collect.apply ( n );
+	return add ( &m, GsMat::id, parent, pivot, name );
+}
+
+KnSkeleton* KnRigBuilder::build ( KnJoint::RotType rtype, bool rootpos ) const
+{
+	if ( _parts.empty() ) return 0;
+
+	KnSkeleton* sk = new KnSkeleton;
+	GsString name;
+
+	for ( int i=0; i<_parts.size(); i++ )
+	{	const Part& p = _parts[i];
+		if ( p.name ) name=p.name; else name.setf("part%d",i);
+
+		KnJoint* parent = p.parent<0? 0 : sk->joints()[p.parent];
+		KnJoint* j = sk->add_joint ( rtype, parent, name );
+		GS_TRACE1 ( "Joint "<<name<<" parent "<<p.parent );
+
+		// joint centers are the pivots, so the offsets are the differences between pivots:
+		j->offset ( parent? p.pivot-_parts[p.parent].pivot : p.pivot );
+
+		if ( rtype==KnJoint::TypeEuler )
+		{	j->euler()->type ( KnJointEuler::TypeXYZ );
+			for ( int d=0; d<3; d++ ) j->euler()->limits ( d, false );
+		}
+		else
+		{	j->rot()->thaw ();
+		}
+		if ( !parent && rootpos )
+		{	for ( int d=0; d<3; d++ ) j->pos()->limits ( d, false );
+		}
+
+		// the geometry is placed in the local frame of the joint, which at rest is a translation:
+		GsModel* m = new GsModel;
+		*m = *p.model;
+		m->translate ( -p.pivot );
+		j->visgeo ( m );
+	}
+
+	sk->make_channels ();
+	sk->compress ();
+	return sk;
+}
+
+//============================== end of file ===============================
@@ -0,0 +1,210 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <string.h>
+# include <math.h>
+# include <sigkin/kn_runner.h>
+# include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_controller.h>
+# include <sigkin/kn_scene.h>
+# include <sigkin/kn_coldet.h>
+# include <sigkin/kn_skin.h>
+
+//# define GS_USE_TRACE1 // steps
+# include <sig/gs_trace.h>
+
+# define TRACE_VERSION 1
+
+//============================== KnRunner ==================================
+
+KnRunner::KnRunner ( KnSkeleton* sk, double dt )
+{
+	_sk = sk;
+	_sk->ref();
+	_ctrl = 0;
+	_scene = 0;
+	_coldet = 0;
+	_trace = 0;
+	_dt = dt;
+	_skin = 1;
+	_cb = 0;
+	_udata = 0;
+	reset ();
+}
+
+KnRunner::~KnRunner ()
+{
+	close_trace ();
+	controller ( 0 );
+	scene ( 0 );
+	coldet ( 0 );
+	_sk->unref();
+}
+
+void KnRunner::controller ( KnController* c )
+{
+	if ( c ) { c->ref(); c->disconnect(); c->temporarily_connect(_sk); }
+	if ( _ctrl ) _ctrl->unref();
+	_ctrl = c;
+}
+
+void KnRunner::scene ( KnScene* s )
+{
+	if ( s ) s->ref();
+	if ( _scene ) _scene->unref();
+	_scene = s;
+}
+
+void KnRunner::coldet ( KnColdet* cd )
+{
+	if ( cd ) cd->ref();
+	if ( _coldet ) _coldet->unref();
+	_coldet = cd;
+	_pairs.size ( 0 );
+}
+
+void KnRunner::reset ()
+{
+	_frame = 0;
+	_stats.frames = _stats.colframes = 0;
+	_stats.time = 0;
+}
+
+bool KnRunner::open_trace ( const char* filename )
+{
+	close_trace ();
+	_trace = fopen ( filename, "wb" );
+	if ( !_trace ) return false;
+
+	const GsArray<KnJoint*>& joints = _sk->joints();
+	int i, n=joints.size(), version=TRACE_VERSION;
+	fwrite ( "SIGTRACE", 8, 1, _trace );
+	fwrite ( &version, sizeof(int), 1, _trace );
+	fwrite ( &n, sizeof(int), 1, _trace );
+	fwrite ( &_dt, sizeof(double), 1, _trace );
+	for ( i=0; i<n; i++ )
+	{	const char* name = joints[i]->name();
+		int len = (int)strlen(name);
+		fwrite ( &len, sizeof(int), 1, _trace );
+		fwrite ( name, 1, len, _trace );
+	}
+	return true;
+}
+
+void KnRunner::close_trace ()
+{
+	if ( _trace ) fclose ( _trace );
+	_trace = 0;
+}
+
+void KnRunner::_write_frame ( double t )
+{
+	const GsArray<KnJoint*>& joints = _sk->joints();
+	int npairs = _pairs.size()/2;
+	fwrite ( &_frame, sizeof(int), 1, _trace );
+	fwrite ( &t, sizeof(double), 1, _trace );
+	fwrite ( &npairs, sizeof(int), 1, _trace );
+	for ( int i=0; i<joints.size(); i++ ) fwrite ( joints[i]->gmat().e, sizeof(float), 16, _trace );
+}
+
+bool KnRunner::step ()
+{
+	double t0 = gs_time();
+	double t = _frame*_dt; // computed from the frame number so that there is no drift
+	GS_TRACE1 ( "Step "<<_frame<<" t="<<t );
+
+	bool active = true;
+	if ( _ctrl )
+	{	_ctrl->evaluate ( t );
+		_ctrl->buffer().apply ();
+		active = _ctrl->active();
+	}
+	_sk->update_global_matrices ();
+	if ( _skin && _sk->skin() ) _sk->skin()->update ();
+	if ( _scene ) _scene->update ();
+	if ( _coldet )
+	{	_pairs.size ( 0 );
+		_coldet->update ( _sk );
+		if ( _coldet->collide(_pairs) ) _stats.colframes++;
+	}
+	if ( _trace ) _write_frame ( t );
+
+	_frame++;
+	_stats.frames++;
+	_stats.time += gs_time()-t0;
+	if ( _cb ) _cb ( this, _udata );
+	return active;
+}
+
+int KnRunner::run ( int frames, bool stop )
+{
+	int i;
+	for ( i=0; i<frames; i++ )
+	{	if ( !step() && stop ) { i++; break; }
+	}
+	if ( _trace ) fflush ( _trace );
+	return i;
+}
+
+//============================== compare_traces ==================================
+
+static bool read_header ( FILE* f, int& n, double& dt, GsArray<char>& names )
+{
+	char magic[8];
+	int version, len;
+	if ( fread(magic,8,1,f)!=1 || strncmp(magic,"SIGTRACE",8)!=0 ) return false;
+	if ( fread(&version,sizeof(int),1,f)!=1 || version!=TRACE_VERSION ) return false;
+	if ( fread(&n,sizeof(int),1,f)!=1 || fread(&dt,sizeof(double),1,f)!=1 ) return false;
+	names.size ( 0 );
+	for ( int i=0; i<n; i++ )
+	{	if ( fread(&len,sizeof(int),1,f)!=1 || len<0 ) return false;
+		int s = names.size();
+		names.size ( s+len+1 );
+		if ( fread(&names[s],1,len,f)!=(size_t)len ) return false;
+		names[s+len] = 0;
+	}
+	return true;
+}
+
+int KnRunner::compare_traces ( const char* file1, const char* file2, float toler )
+{
+	FILE* f1 = fopen ( file1, "rb" );
+	FILE* f2 = fopen ( file2, "rb" );
+	int n1, n2, result=-2;
+	double dt1, dt2;
+	GsArray<char> names1, names2;
+	GsArray<float> m1, m2;
+
+	if ( f1 && f2 && read_header(f1,n1,dt1,names1) && read_header(f2,n2,dt2,names2) &&
+		 n1==n2 && dt1==dt2 && names1.size()==names2.size() &&
+		 memcmp(names1.pt(),names2.pt(),names1.size())==0 )
+	{	// frame header (frame, time, pairs) followed by the matrices:
+		const int fsize = 2*sizeof(int)+sizeof(double);
+		char h1[fsize], h2[fsize];
+		m1.size ( n1*16 );
+		m2.size ( n1*16 );
+		int frame = 0;
+		while ( true )
+		{	size_t r1 = fread ( h1, 1, fsize, f1 );
+			size_t r2 = fread ( h2, 1, fsize, f2 );
+			if ( r1==0 && r2==0 ) { result=-1; break; } // both ended together
+			if ( r1!=fsize || r2!=fsize || memcmp(h1,h2,fsize)!=0 ) { result=frame; break; }
+			if ( fread(m1.pt(),sizeof(float),m1.size(),f1)!=(size_t)m1.size() ||
+				 fread(m2.pt(),sizeof(float),m2.size(),f2)!=(size_t)m2.size() ) { result=frame; break; }
+			int i;
+			for ( i=0; i<m1.size(); i++ ) if ( !(fabsf(m1[i]-m2[i])<=toler) ) break;
+			if ( i<m1.size() ) { result=frame; break; }
+			frame++;
+		}
+	}
+
+	if ( f1 ) fclose ( f1 );
+	if ( f2 ) fclose ( f2 );
+	return result;
+}
+
+//============================== end of file ===============================
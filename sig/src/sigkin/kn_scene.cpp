@@ -37,6 +37,7 @@ KnScene::KnScene ()
 	_axislen = DEF_AXIS_LEN;
 	_avgoffsetlen = 1.0f;
 	_skeleton = 0;
+	_changes = 0;
 }
 
 KnScene::~KnScene ()
@@ -93,7 +94,7 @@ void KnScene::connect ( KnSkeleton* s )
 
 	float lavg=0, lmin=-1.0, lmax=-1.0f, lf;
 	if (joints[0])
-	{	for ( int i=0, s=joints.size(); i<s; i++ )
+	{	for ( int i=0, size=joints.size(); i<size; i++ )
 		{	GS_TRACE1 ( "pre processing joint "<<i<<"..." );
 			float l = joints[i]->offset().len();
 			lavg += l;
@@ -118,7 +119,7 @@ void KnScene::connect ( KnSkeleton* s )
 	axis = new SnLines; // shared axis
 	axis->push_axis ( GsVec::null, _axislen * lf * DEF_AXIS_OFFSETRATIO, 3, "xyz"/*let*/, false/*rule*/ );
 
-	for ( int i=0, s=joints.size(); i<s; i++ )
+	for ( int i=0, size=joints.size(); i<size; i++ )
 	{	GS_TRACE1 ( "processing joint "<<i<<"..." );
 		quat2mat ( joints[i]->quat()->prerot(), arot );
 		arot.setrans ( joints[i]->offset() );
@@ -161,16 +162,22 @@ void KnScene::connect ( KnSkeleton* s )
 			g->add ( c ); // starting at FirstCylPos
 		}
 	}
-   
-	update ();
+
+	for ( int i=0, size=joints.size(); i<size; i++ ) update ( i );
+	_changes = s->changes();
 	GS_TRACE1 ( "done." );
 }
 
 void KnScene::update ()
 {
 	if ( !_skeleton ) return;
+	gsuint64 changes = _skeleton->changes();
+	if ( changes==_changes ) return;
 	const GsArray<KnJoint*>& joints = _skeleton->joints ();
-	for ( int i=0; i<joints.size(); i++ ) update ( i );
+	for ( int i=0, s=joints.size(); i<s; i++ )
+	{	if ( joints[i]->changes()>_changes ) update ( i );
+	}
+	_changes = changes;
 }
 
 void KnScene::update ( int j )
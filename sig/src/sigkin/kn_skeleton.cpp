@@ -15,7 +15,7 @@
 
 bool KnSkeleton::ConvertBvhToQuat = true;
 
-KnSkeleton::KnSkeleton ()
+KnSkeleton::KnSkeleton () : _arena ( 16384 )
  {
    _name = "noname";
    _filename = 0;
@@ -23,6 +23,7 @@ KnSkeleton::KnSkeleton ()
    _coldetid = -1;	   // index used in collision detection
    _gmat_uptodate = false;
    _enforce_rot_limits = false;
+   _changes = 0;
 
    _channels = new KnChannels;
    _channels->ref();
@@ -51,7 +52,8 @@ void KnSkeleton::init ()
    _colfreepairs.size(0);
    _channels->init();
    while ( _postures.size()>0 ) _postures.pop()->unref();
-   while ( _joints.size()>0 ) delete _joints.pop();
+   while ( _joints.size()>0 ) _joints.pop()->~KnJoint();
+   _arena.clear();
    _jhash.init(0);
    _root = 0;
    _gmat_uptodate = false;
@@ -67,7 +69,7 @@ KnJoint* KnSkeleton::add_joint ( KnJoint::RotType rtype, KnJoint* parent, const
  {
    if ( !parent ) init(); else _jhash.init(0);
 
-   KnJoint* j = new KnJoint ( this, parent, rtype, _joints.size() );
+   KnJoint* j = new ( _arena.alloc(sizeof(KnJoint)) ) KnJoint ( this, parent, rtype, _joints.size() );
    _joints.push() = j;
 
    if ( parent ) 
@@ -95,7 +97,7 @@ KnJoint* KnSkeleton::joint ( const char* n ) const
    // Build the table in case not already built: 
    if ( _jhash.elements()==0 )
 	{ int i, jsize = _joints.size();
-	  _jhash.init ( jsize*2, GsTableBase::ReferencedKeys );
+	  _jhash.init ( jsize, GsHashTableBase::ReferencedKeys );
 	  for ( i=0; i<jsize; i++ )
 	   { _jhash.insert ( _joints[i]->name(), _joints[i] );
 		 // note: only the first entry of duplicated names is inserted
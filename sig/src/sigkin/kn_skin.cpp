@@ -28,7 +28,8 @@ KnSkin::~KnSkin ()
 
 void KnSkin::init ()
  {
-   while ( SV.size()>0 ) delete[] SV.pop().w;
+   SV.size(0);
+   _weights.clear();
    model()->init();
    skeleton=0;
    _intn=false;
@@ -86,7 +87,7 @@ bool KnSkin::init ( KnSkeleton* skel, const char* filename, const char* basedir
 		 int vid = atoi ( in.ltoken() );
 		 if ( vid!=SV.size() ) gsout<<"skin: skin vertex id mismatch\n";
 		 int n = in.geti();
-		 Weight* w = new Weight[n];
+		 Weight* w = _weights.make_array<Weight> ( n );
 		 SV.push();
 		 SV.top().n = n;
 		 SV.top().w = w;
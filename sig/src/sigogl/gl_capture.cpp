@@ -0,0 +1,237 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution.
+  =======================================================================*/
+
+# include <string.h>
+# include <atomic>
+# include <mutex>
+# include <condition_variable>
+
+# include <sig/gs_array.h>
+# include <sig/gs_image.h>
+# include <sig/gs_thread_pool.h>
+# include <sigogl/gl_capture.h>
+# include <sigogl/gl_core.h>
+
+//# define GS_USE_TRACE1 // transfers
+# include <sig/gs_trace.h>
+
+//======================= internal structures =====================================
+
+struct Slot
+{	GLuint pbo;
+	GLsync fence;
+	int w, h, number;
+};
+
+// Frames handed over to the encoding tasks of a capture
+struct Encoding
+{	std::atomic<int> errors;
+	int pending;		// frames pushed to the pool and not yet encoded
+	std::mutex mutex;
+	std::condition_variable encoded;
+
+	// waits until at most n frames of this capture are waiting for encoding,
+	// without waiting for other tasks of the pool:
+	void wait ( int n )
+	{	std::unique_lock<std::mutex> lock ( mutex );
+		encoded.wait ( lock, [this,n]{ return pending<=n; } );
+	}
+};
+
+struct GlCapture::Data
+{	GsArray<Slot> slots;
+	Encoding enc;
+	GsThreadPool* writer; // single worker for streams, created when needed
+};
+
+struct FrameJob
+{	GsImage img;		// pixels as read, from the bottom row to the top row
+	GsString filename;
+	FILE* stream;
+	Encoding* enc;
+};
+
+static void done ( FrameJob* job )
+{
+	Encoding* e = job->enc;
+	delete job;
+	std::lock_guard<std::mutex> lock ( e->mutex );
+	e->pending--;
+	e->encoded.notify_all();
+}
+
+static void save_frame ( void* udata )
+{
+	FrameJob* job = (FrameJob*)udata;
+	job->img.vertical_mirror ();
+	if ( !job->img.save(job->filename) ) job->enc->errors++;
+	done ( job );
+}
+
+static void write_frame ( void* udata )
+{
+	FrameJob* job = (FrameJob*)udata;
+	int w=job->img.w(), h=job->img.h();
+	for ( int r=h-1; r>=0; r-- )
+	{	if ( fwrite(job->img.data()+r*w,sizeof(GsColor),w,job->stream)!=(size_t)w ) { job->enc->errors++; break; }
+	}
+	done ( job );
+}
+
+static bool signaled ( GLsync fence )
+{
+	GLenum r = glClientWaitSync ( fence, 0, 0 );
+	return r==GL_ALREADY_SIGNALED || r==GL_CONDITION_SATISFIED;
+}
+
+//================================= GlCapture ===============================
+
+GlCapture::GlCapture ( int buffers )
+{
+	_data = new Data;
+	_data->slots.size ( buffers<2? 2:buffers );
+	for ( int i=0; i<_data->slots.size(); i++ )
+	{	Slot& s = _data->slots[i];
+		s.pbo=0; s.fence=0; s.w=s.h=s.number=0;
+	}
+	_data->enc.errors = 0;
+	_data->enc.pending = 0;
+	_data->writer = 0;
+	_next = _inflight = 0;
+	_mode = Off;
+	_number = _frames = 0;
+	_stream = 0;
+	_pool = 0;
+	_maxpending = 8;
+}
+
+GlCapture::~GlCapture ()
+{
+	finish ();
+	delete _data->writer;
+	delete _data;
+}
+
+void GlCapture::start ( const char* name, const char* ext, int first )
+{
+	finish ();
+	_name = name;
+	_ext = ext;
+	_number = first;
+	_frames = 0;
+	_data->enc.errors = 0;
+	_mode = Files;
+}
+
+void GlCapture::start ( FILE* s )
+{
+	finish ();
+	if ( !_data->writer ) _data->writer = new GsThreadPool ( 1 );
+	_stream = s;
+	_frames = 0;
+	_data->enc.errors = 0;
+	_mode = Stream;
+}
+
+void GlCapture::capture ()
+{
+	if ( _mode==Off ) return;
+
+	int vp[4];
+	glGetIntegerv ( GL_VIEWPORT, vp );
+	int w=vp[2], h=vp[3];
+	if ( w<=0 || h<=0 ) return; // ogl not initialized
+
+	// hand over the frames already transferred, oldest first, and make room in the ring:
+	int n = _data->slots.size();
+	while ( _inflight>0 && signaled(_data->slots[(_next-_inflight+n)%n].fence) ) _retrieve ();
+	if ( _inflight==n ) _retrieve (); // waits for the oldest transfer
+
+	Slot& s = _data->slots[_next];
+	if ( !s.pbo ) glGenBuffers ( 1, &s.pbo );
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, s.pbo );
+	if ( s.w!=w || s.h!=h ) glBufferData ( GL_PIXEL_PACK_BUFFER, GLsizeiptr(w)*h*4, 0, GL_STREAM_READ );
+	s.w = w;
+	s.h = h;
+	s.number = _number++;
+	glPixelStorei ( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels ( vp[0], vp[1], w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0 ); // into the buffer, does not wait
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, 0 );
+	s.fence = glFenceSync ( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	_next = (_next+1)%n;
+	_inflight++;
+	_frames++;
+	GS_TRACE1 ( "Frame "<<s.number<<" started, in flight: "<<_inflight );
+}
+
+void GlCapture::_retrieve ()
+{
+	int n = _data->slots.size();
+	Slot& s = _data->slots[(_next-_inflight+n)%n];
+	_inflight--;
+
+	GLenum r;
+	do { r = glClientWaitSync ( s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000 ); } // 0.1s
+	while ( r==GL_TIMEOUT_EXPIRED );
+	glDeleteSync ( s.fence );
+	s.fence = 0;
+
+	FrameJob* job = new FrameJob;
+	job->img.init ( s.w, s.h );
+	job->stream = _stream;
+	job->enc = &_data->enc;
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, s.pbo );
+	const void* pixels = r==GL_WAIT_FAILED? 0 : glMapBufferRange ( GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(s.w)*s.h*4, GL_MAP_READ_BIT );
+	if ( pixels )
+	{	memcpy ( (void*)job->img.data(), pixels, size_t(s.w)*s.h*4 );
+		glUnmapBuffer ( GL_PIXEL_PACK_BUFFER );
+	}
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, 0 );
+	if ( !pixels ) { _data->enc.errors++; delete job; return; }
+	GS_TRACE1 ( "Frame "<<s.number<<" retrieved" );
+
+	// encoding is done by the pool, which is not allowed to fall too much behind;
+	// only the frames of this capture are counted, as the pool may be shared:
+	GsThreadPool* pool;
+	if ( _mode==Stream )
+	{	pool = _data->writer;
+	}
+	else
+	{	pool = _pool? _pool : GsThreadPool::shared();
+		job->filename.setf ( "%s%04d.%s", _name.pt(), s.number, _ext.pt() );
+	}
+	_data->enc.wait ( _maxpending-1 );
+	{	std::lock_guard<std::mutex> lock ( _data->enc.mutex );
+		_data->enc.pending++;
+	}
+	pool->push ( _mode==Stream? write_frame:save_frame, job );
+}
+
+void GlCapture::finish ()
+{
+	while ( _inflight>0 ) _retrieve ();
+
+	_data->enc.wait ( 0 );
+	if ( _mode==Stream ) fflush ( _stream );
+
+	for ( int i=0; i<_data->slots.size(); i++ )
+	{	Slot& s = _data->slots[i];
+		if ( s.pbo ) glDeleteBuffers ( 1, &s.pbo );
+		s.pbo=0; s.w=s.h=0;
+	}
+	_next = 0;
+	_stream = 0;
+	_mode = Off;
+}
+
+int GlCapture::errors () const
+{
+	return _data->enc.errors;
+}
+
+//================================ End of File =================================
@@ -34,9 +34,20 @@ GlContext::GlContext ()
 	_transparency = 0;	// default OpenGL value 
 	_linesmoothing = 0;	// default OpenGL value
 	_curprogram = 0;	// zero refers to an invalid program (v4.5 man pages)
+	_curtexture = 0;	// default OpenGL value
+	_texstamp = 0;
+	_texvalid = 1;
 	_cullface = 0;		// default OpenGL value 
 	_depthtest = true;	// by default depth test will be on
 	_polygonmode = GL_FILL; // default OpenGL value 
+	_pass = 0;
+	_programchanges = 0;
+	_texturebinds = 0;
+
+	// Shadows:
+	_shadowmap = 0;
+	_shadowmat = 0;
+	_depthpass = 0;
 }
 
 void GlContext::init ()
@@ -158,6 +169,25 @@ void GlContext::use_program ( GLuint pid )
 	CHECK(_curprogram,pid);
 	GS_TRACE1 ( "Program id changed to: "<<pid );
 	glUseProgram ( pid );
+	_programchanges++;
+}
+
+// incremented each time texture objects are created or deleted outside of a context
+static gsuint TextureStamp = 0;
+
+void GlContext::bind_texture ( GLuint id ) 
+{ 
+	if ( _texvalid && _texstamp==TextureStamp && _curtexture==id ) return;
+	_curtexture = id;
+	_texstamp = TextureStamp;
+	_texvalid = 1;
+	glBindTexture ( GL_TEXTURE_2D, id );
+	_texturebinds++;
+}
+
+void GlContext::invalidate_textures ()
+{
+	TextureStamp++;
 }
 
 //================================ End of File ========================================
@@ -6,6 +6,9 @@
   =======================================================================*/
 
 # include <sig/sn_node.h>
+# include <sig/sn_model.h>
+# include <sig/sn_editor.h>
+# include <sig/sa_bvh.h>
 # include <sig/sn_material.h>
 # include <sig/sa_render_mode.h>
 
@@ -13,13 +16,32 @@
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_renderer.h>
 # include <sigogl/glr_base.h>
+# include <sigogl/glr_model.h>
 
 //# define GS_USE_TRACE1 // constructor and destructor
 //# define GS_USE_TRACE2 // matrix
 //# define GS_USE_TRACE3 // rendering
+//# define GS_USE_TRACE4 // instancing
+//# define GS_USE_TRACE5 // culling
+//# define GS_USE_TRACE6 // shadows
 
 # include <sig/gs_trace.h>
 
+//================================= Batch ======================================
+
+// Shapes rendering a same model with the same render mode and material
+struct GlRenderer::Batch
+{	GlrModel* renderer;		// renderer of the first shape, used to render the batch
+	const GsModel* model;
+	GsMaterial material;
+	gsRenderMode rmode;
+	bool mtloverriden;
+	gsbyte changed;			// union of the changed flags of the shapes
+	int next;				// next batch in the same hash bucket, or -1
+	GsArray<SnShape*> shapes;
+	GsArray<GsMat> mats;	// modelview matrix of each shape
+};
+
 //=============================== GlRenderer ====================================
 
 GlRenderer::GlRenderer ( GlContext* c )
@@ -28,14 +50,51 @@ GlRenderer::GlRenderer ( GlContext* c )
 	_context = c;
 	_context->ref();
 	_mode = DirectTraversal;
+	_nbatches = 0;
+	_draws = 0;
+	_qsize = 0;
+	_qsort = 1;
+	_lastmtl = 0;
+	_stats.shapes = _stats.programs = _stats.textures = _stats.materials = _stats.culled = _stats.casters = 0;
+	_bvh = 0;
+	_curinst = 0;
+	_occlusion = 0;
+	_inhelpers = 0;
+	_ncasters = 0;
+	_ssize = _stexsize = 0;
+	_sfbo = _smap = 0;
+	_incasters = 0;
 }
 
 GlRenderer::~GlRenderer ()
 {
 	GS_TRACE1 ( "Destructor" );
+	for ( int i=0; i<_batches.size(); i++ ) delete _batches[i];
+	if ( _bvh ) _bvh->unref();
+	if ( _sfbo ) glDeleteFramebuffers ( 1, &_sfbo );
+	if ( _smap ) { glDeleteTextures(1,&_smap); GlContext::invalidate_textures(); }
 	_context->unref();
 }
 
+void GlRenderer::frustum_culling ( bool b, bool occlusion )
+{
+	_occlusion = occlusion;
+	if ( b && !_bvh )
+	{	_bvh = new SaBvh ( false ); // only boxes are needed
+		_bvh->ref();
+	}
+	else if ( !b && _bvh )
+	{	_bvh->unref();
+		_bvh = 0;
+	}
+}
+
+void GlRenderer::shadows ( bool b, int size )
+{
+	// GL objects are only created or deleted in apply(), when the context is current
+	_ssize = b? GS_MAX(size,16) : 0;
+}
+
 void GlRenderer::restore_render_mode ( SnNode* n )
 {
 	SaRenderMode a;
@@ -48,25 +107,434 @@ void GlRenderer::override_render_mode ( SnNode* n, gsRenderMode m )
 	a.apply ( n );
 }
 
-/*	PerfNote: GlRenderer is an initial structure that could be extended to explore different 
-	scene rendering optimization strategies. One possible typical approach is to sort by shader
-	program into a flat list and only update the list when needed, or to restrict the sorting
-	to only the static objets in the scene. However it is also true that many traditional
-	optimizations are no longer useful in modern GPU systems given their high performance
-	capabilities. Specific rendererers should be designed according to the application. */
+/*	PerfNote: many traditional optimizations are no longer as useful in modern GPU systems
+	given their high performance capabilities, and the best mode depends on the scene.
+	Use stats() to compare the number of state changes obtained by each mode. */
 void GlRenderer::apply ( SnNode* n )
 { 
 	GS_TRACE3 ( "Rendering Scene..." );
+	_context->next_pass();
+	_draws = 0;
+	_lastmtl = 0;
+	gsuint programs = _context->program_changes();
+	gsuint textures = _context->texture_binds();
+	_stats.shapes = _stats.materials = _stats.culled = _stats.casters = 0;
+	_shadow_pass ( n );
+	if ( _bvh ) _cull ( n );
 
-	//if ( _mode==SceneTraversal ) // Render by just traversing scene
+	if ( _mode==Instanced ) // Collect models during the traversal and then render them
+	{	_nbatches = 0;
+		_bhash.size ( _bhash.size()<64? 64:_bhash.size() );
+		_bhash.setall ( -1 );
+		SaAction::apply(n);
+		_flush ();
+	}
+	else if ( _mode==RenderQueue ) // Collect all shapes and render them sorted by state
+	{	_qsize = 0;
+		SaAction::apply(n);
+		if ( _qsize!=_queue.size() ) { _queue.size(_qsize); _qsort=1; }
+		_render_queue ();
+	}
+	else // Render by just traversing scene
 	{	SaAction::apply(n);
 	}
-	//else
-	//{ may implement other strategies here
-	//}
+
+	_stats.programs = int ( _context->program_changes()-programs );
+	_stats.textures = int ( _context->texture_binds()-textures );
 	GS_TRACE3 ( "Rendering done." );
 }
 
+//==================================== helpers ====================================
+
+static gsuint material_key ( const GsMaterial& m )
+{
+	gsuint h = 2166136261u; // FNV-1a
+	const gsbyte* b = (const gsbyte*)&m;
+	for ( int i=0; i<(int)sizeof(GsMaterial); i++ ) { h^=b[i]; h*=16777619u; }
+	return h;
+}
+
+static bool transparent ( SnShape* s )
+{
+	if ( s->material().diffuse.a<255 ) return true;
+	if ( s->material_is_overriden() ) return false;
+	SnModel* sm = dynamic_cast<SnModel*>(s);
+	if ( !sm ) return false;
+	const GsModel* m = sm->cmodel();
+	if ( m->mtlmode()==GsModel::NoMtl ) return false;
+	for ( int i=0, ms=m->M.size(); i<ms; i++ ) if ( m->M[i].diffuse.a<255 ) return true;
+	return false;
+}
+
+void GlRenderer::_render ( SnShape* s )
+{
+	((GlrBase*)s->renderer())->render(s,_context);
+	s->post_render ();
+	gsuint mtl = material_key ( s->material() );
+	if ( mtl!=_lastmtl ) { _stats.materials++; _lastmtl=mtl; }
+	_stats.shapes++;
+}
+
+//==================================== instancing ====================================
+
+static inline int bucket ( const GsModel* m, gsRenderMode rm, int size )
+{
+	return int ( ( gsuint(size_t(m)>>4) ^ gsuint(rm)*0x9E3779B1u ) & gsuint(size-1) );
+}
+
+GlRenderer::Batch* GlRenderer::_getbatch ( SnShape* s )
+{
+	// Only models with GlrModel renderers and opaque materials are batched:
+	GlrModel* r = dynamic_cast<GlrModel*>(s->renderer());
+	if ( !r ) return 0;
+	const GsModel* m = ((SnModel*)s)->cmodel();
+	if ( m->empty() || transparent(s) ) return 0;
+	bool mo = s->material_is_overriden();
+
+	// Search for the batch in the hash table:
+	gsRenderMode rm = s->render_mode();
+	bool nomtl = mo || m->mtlmode()==GsModel::NoMtl;
+	int id = _bhash[bucket(m,rm,_bhash.size())];
+	while ( id>=0 )
+	{	Batch* b = _batches[id];
+		if ( b->model==m && b->rmode==rm && b->mtloverriden==mo && ( !nomtl || b->material==s->material() ) ) return b;
+		id = b->next;
+	}
+
+	// Rehash if the table is getting full:
+	int i;
+	if ( _nbatches>=_bhash.size()/2 )
+	{	_bhash.size ( _bhash.size()*2 );
+		_bhash.setall ( -1 );
+		for ( i=0; i<_nbatches; i++ )
+		{	int& h = _bhash[bucket(_batches[i]->model,_batches[i]->rmode,_bhash.size())];
+			_batches[i]->next = h;
+			h = i;
+		}
+	}
+
+	// Create a new batch:
+	if ( _nbatches==_batches.size() ) _batches.push() = new Batch;
+	i = _nbatches++;
+	Batch* b = _batches[i];
+	b->renderer = r;
+	b->model = m;
+	b->material = s->material();
+	b->rmode = rm;
+	b->mtloverriden = mo;
+	b->changed = 0;
+	int& h = _bhash[bucket(m,rm,_bhash.size())];
+	b->next = h;
+	h = i;
+	GS_TRACE4 ( "New batch for ["<<m->name<<"]" );
+	return b;
+}
+
+void GlRenderer::_flush ()
+{
+	int i, j;
+	for ( i=0; i<_nbatches; i++ )
+	{	Batch& b = *_batches[i];
+		SnShape* s = b.shapes[0];
+		if ( b.shapes.size()==1 )
+		{	_context->modelview ( &b.mats[0] );
+			_render ( s );
+		}
+		else
+		{	GS_TRACE4 ( "Rendering "<<b.shapes.size()<<" instances of ["<<b.model->name<<"]" );
+			s->changed ( (SnShape::ChangeType)b.changed ); // so that changes in any shape are uploaded
+			b.renderer->render_instances ( s, _context, b.mats.pt(), b.mats.size() );
+			for ( j=0; j<b.shapes.size(); j++ ) b.shapes[j]->post_render();
+			gsuint mtl = material_key ( s->material() );
+			if ( mtl!=_lastmtl ) { _stats.materials++; _lastmtl=mtl; }
+			_stats.shapes += b.shapes.size();
+			_draws++;
+		}
+		b.shapes.size ( 0 );
+		b.mats.size ( 0 );
+	}
+	_nbatches = 0;
+
+	// Transparent shapes are rendered over all opaque ones:
+	for ( i=0; i<_tshapes.size(); i++ )
+	{	_context->modelview ( &_tmats[i] );
+		_render ( _tshapes[i] );
+	}
+	_tshapes.size ( 0 );
+	_tmats.size ( 0 );
+	_context->modelview ( &_matstack.top() );
+}
+
+//==================================== culling ====================================
+
+void GlRenderer::_cull ( SnNode* n )
+{
+	_bvh->update ( n );
+	_curinst = 0;
+	_inhelpers = 0;
+	_visinst.size ( _bvh->instances() );
+	_visinst.setall ( 0 );
+
+	// The camera is the bottom matrix of the stack:
+	GsMat m = *_context->projection() * _matstack[0];
+	GsArray<int> ids;
+	_bvh->frustum ( m, ids );
+	GS_TRACE5 ( "In frustum: "<<ids.size()<<'/'<<_bvh->instances() );
+
+	GsPnt eye;
+	if ( _occlusion && _occluders.size() )
+	{	GsMat inv;
+		_matstack[0].inverse ( inv );
+		eye = inv * GsPnt::null;
+	}
+	for ( int i=0; i<ids.size(); i++ )
+	{	if ( _occlusion && _occluders.size() && _occluded(_bvh->box(ids[i]),eye) ) continue;
+		_visinst[ids[i]] = 1;
+	}
+}
+
+static inline bool disjoint ( const GsBox& a, const GsBox& b )
+{
+	return a.b.x<b.a.x || b.b.x<a.a.x || a.b.y<b.a.y || b.b.y<a.a.y || a.b.z<b.a.z || b.b.z<a.a.z;
+}
+
+/* The directions from the eye to a convex occluder form a convex cone, so if the
+   segments from the eye to the 8 corners of b all cross an occluder, every point of
+   b is behind it. The occluder must be between the eye and the corners, and since
+   b and the occluder are disjoint the order along all directions is the same. */
+bool GlRenderer::_occluded ( const GsBox& b, const GsPnt& eye ) const
+{
+	if ( b.empty() ) return false;
+	GsPnt c[8];
+	b.get_side ( c[0], c[1], c[2], c[3], 0 );
+	b.get_side ( c[4], c[5], c[6], c[7], 1 );
+	float t1, t2;
+	for ( int o=0; o<_occluders.size(); o++ )
+	{	const GsBox& ob = _occluders[o];
+		if ( ob.contains(eye) || !disjoint(b,ob) ) continue;
+		int i;
+		for ( i=0; i<8; i++ )
+		{	if ( GsLine(eye,c[i]).intersects_box(ob,t1,t2)==0 || t1<0 || t2>1 ) break;
+		}
+		if ( i==8 ) return true;
+	}
+	return false;
+}
+
+//==================================== shadows ====================================
+
+/*	PerfNote: the shadow map needs only one extra traversal without rendering and one
+	depth-only draw per model, with the buffers already in the GPU, which is much cheaper
+	than rendering projected copies of the shapes with full materials. */
+void GlRenderer::_shadow_pass ( SnNode* n )
+{
+	GlContext* c = _context;
+	c->shadow_map ( 0, 0 );
+
+	// Release the shadow map if shadows were turned off or if its size changed:
+	if ( _sfbo && _stexsize!=_ssize )
+	{	glDeleteFramebuffers ( 1, &_sfbo );
+		glDeleteTextures ( 1, &_smap );
+		GlContext::invalidate_textures ();
+		_sfbo = _smap = 0;
+		_stexsize = 0;
+	}
+	if ( !_ssize ) return;
+
+	// Create the depth texture and its framebuffer:
+	if ( !_sfbo )
+	{	GS_TRACE6 ( "Creating shadow map "<<_ssize<<'x'<<_ssize );
+		const float border[] = { 1.0f, 1.0f, 1.0f, 1.0f }; // no shadows outside of the map
+		glGenTextures ( 1, &_smap );
+		glActiveTexture ( GL_TEXTURE1 );
+		glBindTexture ( GL_TEXTURE_2D, _smap );
+		glTexImage2D ( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, _ssize, _ssize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0 );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER );
+		glTexParameterfv ( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+		glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+		glActiveTexture ( GL_TEXTURE0 );
+		c->reset_texture ();
+		glGenFramebuffers ( 1, &_sfbo );
+		GLint fbo;
+		glGetIntegerv ( GL_DRAW_FRAMEBUFFER_BINDING, &fbo );
+		glBindFramebuffer ( GL_FRAMEBUFFER, _sfbo );
+		glFramebufferTexture2D ( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _smap, 0 );
+		glDrawBuffer ( GL_NONE );
+		glReadBuffer ( GL_NONE );
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer ( GL_FRAMEBUFFER, fbo );
+		_stexsize = _ssize;
+		if ( !complete ) { gsout.warning("Shadow map framebuffer not supported"); _ssize=0; return; }
+	}
+
+	// 1. Collect the models casting shadows with their modelview matrices:
+	_ncasters = 0;
+	_incasters = 1;
+	SaAction::apply ( n );
+	_incasters = 0;
+	_curmaterial = 0;
+	GS_TRACE6 ( "Shadow casters: "<<_ncasters );
+	if ( !_ncasters ) return;
+
+	// 2. Directional light frame in eye coordinates:
+	GsVec l = c->light.position;
+	if ( l.norm2()==0 ) l=GsVec::k;
+	l.normalize();
+	_sview.lookat ( l, GsVec::null, GS_ABS(l.y)<0.99f? GsVec::j:GsVec::i );
+
+	// 3. Orthographic projection covering the casters in depth and the region, if any:
+	int i;
+	GsBox box, cbox;
+	for ( i=0; i<_ncasters; i++ )
+	{	const SEntry& e = _casters[i];
+		if ( !e.box.empty() ) cbox.extend ( (_sview*e.mat) * e.box );
+	}
+	if ( cbox.empty() ) return;
+	if ( _sregion.empty() )
+	{	box = cbox;
+	}
+	else
+	{	box = (_sview*_matstack[0]) * _sregion;
+		box.a.z = GS_MIN ( box.a.z, cbox.a.z );
+		box.b.z = GS_MAX ( box.b.z, cbox.b.z );
+	}
+	GsVec d = box.b-box.a;
+	box.grow ( d.x*0.01f+gstiny, d.y*0.01f+gstiny, d.z*0.01f+gstiny );
+	float dz = GS_MAX(d.x,d.y) - d.z; // thin depth ranges lose precision in eye coordinates
+	if ( dz>0 ) box.a.z -= dz;
+	_sproj.ortho ( box.a.x, box.b.x, box.a.y, box.b.y, -box.b.z, -box.a.z ); // the light looks towards -z
+
+	// 4. Render the depth map, with an offset to avoid self-shadowing artifacts:
+	GLint fbo;
+	glGetIntegerv ( GL_DRAW_FRAMEBUFFER_BINDING, &fbo );
+	glBindFramebuffer ( GL_FRAMEBUFFER, _sfbo );
+	glViewport ( 0, 0, _ssize, _ssize );
+	glClear ( GL_DEPTH_BUFFER_BIT );
+	glEnable ( GL_POLYGON_OFFSET_FILL );
+	glPolygonOffset ( 2.0f, 4.0f );
+	const GsMat* proj = c->projection();
+	GsMat mv;
+	c->projection ( &_sproj );
+	c->modelview ( &mv );
+	c->depth_pass ( true );
+	for ( i=0; i<_ncasters; i++ )
+	{	const SEntry& e = _casters[i];
+		mv.mult ( _sview, e.mat );
+		((GlrBase*)e.shape->renderer())->render ( e.shape, c );
+	}
+	c->depth_pass ( false );
+	c->projection ( proj );
+	c->modelview ( &_matstack.top() );
+	glDisable ( GL_POLYGON_OFFSET_FILL );
+	glBindFramebuffer ( GL_FRAMEBUFFER, fbo );
+	glViewport ( 0, 0, c->w(), c->h() );
+	_stats.casters = _ncasters;
+
+	// 5. Transformation from eye coordinates to shadow map coordinates in [0,1]:
+	GsMat bias;
+	bias.scaling ( 0.5f );
+	bias.setrans ( 0.5f, 0.5f, 0.5f );
+	_smat = bias * _sproj * _sview;
+	glActiveTexture ( GL_TEXTURE1 );
+	glBindTexture ( GL_TEXTURE_2D, _smap );
+	glActiveTexture ( GL_TEXTURE0 );
+	c->reset_texture (); // the map is bound outside of the context
+	c->shadow_map ( _smap, &_smat );
+}
+
+void GlRenderer::_addcaster ( SnShape* s )
+{
+	if ( _ncasters==_casters.size() ) { _casters.push().shape=0; }
+	SEntry& e = _casters[_ncasters++];
+	if ( e.shape!=s || s->changed() ) // boxes are only computed again when needed
+	{	e.shape = s;
+		s->get_bounding_box ( e.box );
+	}
+	e.mat = _matstack.top();
+}
+
+//==================================== render queue ====================================
+
+// ties keep the traversal order
+int GlRenderer::_cmpkey ( const QKey* k1, const QKey* k2 )
+{
+	if ( k1->key!=k2->key ) return k1->key<k2->key? -1:1;
+	return k1->i-k2->i;
+}
+
+// farthest first, the camera looks towards -z in eye coordinates
+int GlRenderer::_cmpdepth ( const QKey* k1, const QKey* k2 )
+{
+	if ( k1->depth!=k2->depth ) return k1->depth<k2->depth? -1:1;
+	return k1->i-k2->i;
+}
+
+void GlRenderer::_enqueue ( SnShape* s )
+{
+	if ( _qsize==_queue.size() ) { _queue.push().shape=0; }
+	QEntry& e = _queue[_qsize++];
+	if ( e.shape!=s ) // structure changed
+	{	e.shape = s;
+		e.program = e.texture = 0;
+		s->get_bounding_box ( e.box );
+		_qsort = 1;
+	}
+	else if ( s->changed() )
+	{	s->get_bounding_box ( e.box );
+	}
+	e.mat = _matstack.top();
+	gsuint mtl = material_key ( s->material() );
+	gscbool t = transparent(s)? 1:0;
+	if ( mtl!=e.mtlkey || t!=e.transparent ) { e.mtlkey=mtl; e.transparent=t; _qsort=1; }
+}
+
+void GlRenderer::_render_queue ()
+{
+	int i;
+
+	// Sort opaque entries by program, texture and material:
+	if ( _qsort )
+	{	GS_TRACE3 ( "Sorting render queue..." );
+		_qsort = 0;
+		_opaque.size ( 0 );
+		_transp.size ( 0 );
+		for ( i=0; i<_queue.size(); i++ )
+		{	const QEntry& e = _queue[i];
+			QKey& k = e.transparent? _transp.push() : _opaque.push();
+			k.key = ( gsuint64(e.program&0xFFFF)<<48 ) | ( gsuint64(e.texture&0xFFFF)<<32 ) | gsuint64(e.mtlkey);
+			k.i = i;
+		}
+		_opaque.sort ( _cmpkey );
+	}
+
+	// Sort transparent entries back-to-front by the eye depth of their box centers:
+	for ( i=0; i<_transp.size(); i++ )
+	{	const QEntry& e = _queue[_transp[i].i];
+		_transp[i].depth = e.box.empty()? 0 : (e.mat*e.box.center()).z;
+	}
+	if ( _transp.size()>1 ) _transp.sort ( _cmpdepth );
+
+	// Render opaque entries and then the transparent ones:
+	for ( int t=0; t<2; t++ )
+	{	GsArray<QKey>& keys = t==0? _opaque:_transp;
+		for ( i=0; i<keys.size(); i++ )
+		{	QEntry& e = _queue[keys[i].i];
+			_context->modelview ( &e.mat );
+			_render ( e.shape );
+			if ( e.program!=_context->cur_program() || e.texture!=_context->cur_texture() )
+			{	e.program = _context->cur_program();
+				e.texture = _context->cur_texture();
+				if ( !e.transparent ) _qsort = 1;
+			}
+		}
+	}
+	_context->modelview ( &_matstack.top() );
+}
+
 //==================================== virtuals ====================================
 
 bool GlRenderer::shape_apply ( SnShape* s )
@@ -75,19 +543,80 @@ bool GlRenderer::shape_apply ( SnShape* s )
 
 	// Render the node:
 	s->update_node();
+	if ( _incasters ) // only collecting the models casting shadows
+	{	if ( s->prep_render() && dynamic_cast<GlrModel*>(s->renderer()) ) _addcaster ( s );
+		return true;
+	}
 	if ( s->prep_render() )
 	{	if ( _curmaterial ) // apply this material
 		{	s->material ( _curmaterial->material() );
 			_curmaterial = 0;
 		}
-		((GlrBase*)s->renderer())->render(s,_context);
-		s->post_render ();
+		if ( _bvh && !_inhelpers )
+		{	int i = _curinst++;
+			if ( i<_visinst.size() && !_visinst[i] && !s->changed() )
+			{	_stats.culled++;
+				return true;
+			}
+		}
+		if ( _mode==RenderQueue ) // render later in sorted order
+		{	_enqueue ( s );
+			return true;
+		}
+		if ( _mode==Instanced && transparent(s) ) // render later over the opaque shapes
+		{	_tshapes.push() = s;
+			_tmats.push() = _matstack.top();
+			return true;
+		}
+		if ( _mode==Instanced && dynamic_cast<SnModel*>(s) )
+		{	Batch* b = _getbatch ( s );
+			if ( b ) // render later with the batch
+			{	b->shapes.push() = s;
+				b->mats.push() = _matstack.top();
+				b->changed |= s->changed();
+				return true;
+			}
+		}
+		_render ( s );
 	}
 
 	// Continue to render:
 	return true;
 }
 
+bool GlRenderer::editor_apply ( SnEditor* e )
+{
+	if ( !_bvh ) return SaAction::editor_apply ( e );
+
+	// Same as SaAction::editor_apply() but marking helpers, which are not in _bvh:
+	SnGroup* h = e->helpers();
+	SnNode* c = e->child();
+	if ( !c ) return true;
+
+	push_matrix ();
+	mult_matrix ( e->mat() );
+
+	bool vis = e->visible();
+	if ( vis ) e->update_node();
+
+	bool b = SaAction::apply ( c );
+
+	if ( vis ) e->post_child_render();
+
+	if ( vis && b && h )
+	{	gscbool inhelpers = _inhelpers;
+		_inhelpers = 1;
+		for ( int i=0, s=h->size(); i<s; i++ )
+		{	b = SaAction::apply ( h->get(i) );
+			if ( !b ) break;
+		}
+		_inhelpers = inhelpers;
+	}
+
+	pop_matrix();
+	return b;
+}
+
 void GlRenderer::push_matrix ()
 {
 	_matstack.push_top();
@@ -5,10 +5,15 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
-# include <sig/gs_table.h>
+# include <sig/gs_hash_table.h>
 # include <sig/gs_string.h>
 # include <sig/gs_vars.h>
 # include <sig/gs_dirs.h>
+# include <sig/gs_model.h>
+# include <sig/gs_strings.h>
+# include <sig/gs_thread_pool.h>
+# include <sig/sn_model.h>
+# include <sig/sa_action.h>
 
 # include <sigogl/ui_style.h>
 # include <sigogl/ws_run.h>
@@ -21,6 +26,8 @@
 # include <sigogl/gl_font.h>
 # include <sigogl/gl_loader.h>
 
+# include <stdio.h>
+# include <string.h>
 # include <stdarg.h>
 
 //# define GS_USE_TRACE1 // basic trace
@@ -45,12 +52,14 @@ static gscbool LoadPredefShaders=0;		// When 0 it will only load predefined shad
 static gsbyte NumPredefShadersLoaded=0;	// How many shaders came from gl_predef_shaders.inc
 static gsbyte NumSigShadersDeclared=0;	// How many sig shaders were defined by declare_default_shaders()
 
-static GsTablePt<GlShader> ShaderTable;
-static GsTablePt<GlProgram> ProgramTable;
-static GsTablePt<GlTexture> TextureTable;
-static GsTablePt<GlFont> FontTable;
+static GsHashTablePt<GlShader> ShaderTable;
+static GsHashTablePt<GlProgram> ProgramTable;
+static GsHashTablePt<GlTexture> TextureTable;
+static GsHashTablePt<GlFont> FontTable;
 static GsVars Vars;
 static GsDirs Dirs;
+static GsString TextureCache;			// Folder of the decoded textures cache, not used if empty
+static gscbool MipmapTextures=0;		// Mipmaps textures of models declared afterwards
 
 /*	ImprNote: possible extensions to be implemented:
 	- void load_and_compile_all_resources (); // force load to be sure all resources can be found and have no errors
@@ -81,9 +90,10 @@ class GlProgramDecl
 
 class GlTextureDecl
 { public:
-	GsCharPt name; GsCharPt filename; GsImage* image;
+	GsCharPt name; GsCharPt filename; GsImage* image; gscbool mipmapped;
 	GlTextureDecl ( const char* n, const char* fn )
-	{ name=n; filename=fn; image=0; }
+	{ name=n; filename=fn; image=0; mipmapped=0; }
+   ~GlTextureDecl () { delete image; }
 };
 
 class GlFontDecl
@@ -218,7 +228,7 @@ void GlResources::compile_program ( const GlProgram* prog )
 void GlResources::compile_programs ()
 {
 	GS_TRACE1 ( "compile_programs" );
-	GsTablePt<GlProgram>&tp = ProgramTable;
+	GsHashTablePt<GlProgram>&tp = ProgramTable;
 	for ( int i=0; i<tp.size(); i++ )
 	{	if ( tp.key(i) ) compile_program(tp.data(i));
 	}
@@ -264,6 +274,62 @@ int GlResources::get_texture_id ( const char* txname )
 	return TextureTable.lookup_index(txname);
 }
 
+// Name of the cache file of a texture file: its name followed by a hash of its full path
+static void cache_name ( const char* fname, GsString& cname )
+{
+	gsuint h = 2166136261u; // FNV-1a
+	for ( const char* c=fname; *c; c++ ) { h^=(gsbyte)*c; h*=16777619u; }
+	GsString name;
+	get_filename ( fname, name );
+	cname.setf ( "%s%s.%08x.sgt", TextureCache.pt(), name.pt(), h );
+}
+
+// Reads a cached texture if the cache file is newer than the texture file
+static GsImage* read_cache ( const char* cname, const char* fname )
+{
+	gsuint ct = gs_mtime ( cname );
+	if ( ct==0 || ct<gs_mtime(fname) ) return 0;
+	FILE* f = fopen ( cname, "rb" );
+	if ( !f ) return 0;
+	char magic[4]; int wh[2];
+	GsImage* img = 0;
+	if ( fread(magic,1,4,f)==4 && memcmp(magic,"SGTX",4)==0 && fread(wh,sizeof(int),2,f)==2 && wh[0]>0 && wh[1]>0 )
+	{	img = new GsImage;
+		img->init ( wh[0], wh[1] );
+		size_t n = size_t(wh[0])*wh[1];
+		if ( fread((void*)img->data(),sizeof(GsColor),n,f)!=n ) { delete img; img=0; }
+	}
+	fclose ( f );
+	return img;
+}
+
+static void write_cache ( const char* cname, GsImage* img )
+{
+	FILE* f = fopen ( cname, "wb" );
+	if ( !f ) return;
+	int wh[2] = { img->w(), img->h() };
+	size_t n = size_t(wh[0])*wh[1];
+	bool ok = fwrite("SGTX",1,4,f)==4 && fwrite(wh,sizeof(int),2,f)==2 && fwrite(img->cdata(),sizeof(GsColor),n,f)==n;
+	fclose ( f );
+	if ( !ok ) remove ( cname );
+}
+
+// Decodes a texture file in OpenGL row order, or returns null on error. Can be called by any thread.
+static GsImage* decode_texture ( const char* fname )
+{
+	GsString cname;
+	if ( TextureCache.len() )
+	{	cache_name ( fname, cname );
+		GsImage* img = read_cache ( cname, fname );
+		if ( img ) return img;
+	}
+	GsImage* img = new GsImage;
+	if ( !img->load(fname) ) { delete img; return 0; }
+	img->vertical_mirror(); // needed because OpenGL loads pixel data upside-down
+	if ( cname.len() ) write_cache ( cname, img );
+	return img;
+}
+
 const GlTexture* GlResources::get_texture ( int txid )
 {
 	GS_TRACE1 ( "get_texture ["<<txid<<"]" );
@@ -272,15 +338,16 @@ const GlTexture* GlResources::get_texture ( int txid )
 	if ( !t->valid() )
 	{	GlTextureDecl* td = t->_decl;
 		if ( !td ) Error("texture declarion null",TextureTable.key(txid));
-		GsString fname(td->filename);
-		if ( !Dirs.checkfull(fname) ) Error("texture file not found",td->filename);
-		GsImage* img = new GsImage;
-		if ( !img->load(fname) ) Error("error loading texture file",fname);
-		img->vertical_mirror(); // needed because OpenGL loads pixel data upside-down
-		GS_TRACE1 ( "texture ["<<fname<<"] size:"<<img->w()<<'x'<<img->h() );
-		if ( !gl_loaded() ) Error("get_texture called before OpenGL loaded",fname);
-		t->data ( img, GlTexture::Filtered );
-		delete img;
+		if ( !td->image ) // not decoded by load_textures()
+		{	GsString fname(td->filename);
+			if ( !Dirs.checkfull(fname) ) Error("texture file not found",td->filename);
+			td->image = decode_texture ( fname );
+			if ( !td->image ) Error("error loading texture file",fname);
+		}
+		GS_TRACE1 ( "texture ["<<td->filename<<"] size:"<<td->image->w()<<'x'<<td->image->h() );
+		if ( !gl_loaded() ) Error("get_texture called before OpenGL loaded",td->filename);
+		t->data ( td->image, td->mipmapped? GlTexture::MipMapped : GlTexture::Filtered );
+		delete td->image; td->image=0;
 		if ( FreeDeclInfo ) { delete td; t->_decl=0; }
 	}
 	return t;
@@ -294,6 +361,80 @@ const GlTexture* GlResources::get_texture ( const char* txname )
 	return get_texture ( id );
 }
 
+void GlResources::declare_textures ( const GsModel* m )
+{
+	bool declared=false;
+	for ( int g=0; g<m->G.size(); g++ )
+	{	GsModel::Texture* tx = m->G[g]->dmap;
+		if ( !tx || tx->id>=0 ) continue;
+		tx->id = declare_texture ( tx->fname, tx->fname );
+		GlTexture* t = TextureTable.data(tx->id);
+		if ( t->_decl && MipmapTextures ) t->_decl->mipmapped=1;
+		declared=true;
+	}
+	GsString path = m->filename;
+	if ( declared && path.len() ) // texture files are searched in the folder of the model
+	{	remove_filename ( path );
+		Dirs.push ( path );
+	}
+}
+
+class SaDeclareTextures : public SaAction
+{  private :
+	virtual bool shape_apply ( SnShape* s ) override
+	{	if ( gs_compare(s->instance_name(),SnModel::class_name)==0 ) GlResources::declare_textures ( ((SnModel*)s)->model() );
+		return true;
+	}
+};
+
+void GlResources::declare_textures ( SnNode* n )
+{
+	SaDeclareTextures a;
+	a.apply ( n );
+}
+
+struct TextureLoad
+{	GsArray<GlTextureDecl*> decls;
+	GsStrings files;
+};
+
+static void decode_func ( int i, int /*slot*/, void* udata )
+{
+	TextureLoad& tl = *(TextureLoad*)udata;
+	tl.decls[i]->image = decode_texture ( tl.files[i] );
+}
+
+int GlResources::load_textures ( GsThreadPool* p )
+{
+	TextureLoad tl;
+	GsString fname;
+	for ( int i=0; i<TextureTable.size(); i++ )
+	{	GlTexture* t = TextureTable.data(i);
+		if ( !t || t->valid() || !t->_decl || t->_decl->image ) continue;
+		fname = t->_decl->filename;
+		if ( !Dirs.checkfull(fname) ) continue; // reported at first access
+		tl.decls.push() = t->_decl;
+		tl.files.push ( fname );
+	}
+	if ( tl.decls.empty() ) return 0;
+	GS_TRACE1 ( "Decoding "<<tl.decls.size()<<" textures..." );
+	( p? p : GsThreadPool::shared() )->run ( tl.decls.size(), decode_func, &tl, 1 );
+	int n=0;
+	for ( int i=0; i<tl.decls.size(); i++ ) if ( tl.decls[i]->image ) n++;
+	return n;
+}
+
+void GlResources::texture_cache ( const char* dir )
+{
+	TextureCache = dir;
+	if ( TextureCache.len() ) validate_path ( TextureCache );
+}
+
+void GlResources::mipmapped_textures ( bool b )
+{
+	MipmapTextures = b;
+}
+
 // === Fonts ===
 
 const GlFont* GlResources::declare_font ( const char* fontname, const char* fntfile, const char* imgfile )
@@ -540,13 +681,24 @@ void GlResources::declare_default_shaders ()
 	const GlShader* vs3dphong   = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphong", "3dphong.vert", pds_3dphong_vert );
 	const GlShader* vs3dphongmc = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphongmc", "3dphongmc.vert", pds_3dphongmc_vert );
 	const GlShader* vs3dtextured= r.declare_shader ( GL_VERTEX_SHADER, "vsv3dtextured", "3dtextured.vert", pds_3dtextured_vert );
+	const GlShader* vs3dsmoothi = r.declare_shader ( GL_VERTEX_SHADER, "vs3dsmoothinst", "3dsmoothinst.vert", pds_3dsmoothinst_vert );
+	const GlShader* vs3dflati	= r.declare_shader ( GL_VERTEX_SHADER, "vs3dflatinst", "3dflatinst.vert", pds_3dflatinst_vert );
+	const GlShader* vs3dgouraudi= r.declare_shader ( GL_VERTEX_SHADER, "vs3dgouraudinst", "3dgouraudinst.vert", pds_3dgouraudinst_vert );
+	const GlShader* vs3dphongi  = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphonginst", "3dphonginst.vert", pds_3dphonginst_vert );
+	const GlShader* vs3dphongmci= r.declare_shader ( GL_VERTEX_SHADER, "vs3dphongmcinst", "3dphongmcinst.vert", pds_3dphongmcinst_vert );
+	const GlShader* vs3dtexturedi=r.declare_shader ( GL_VERTEX_SHADER, "vs3dtexturedinst", "3dtexturedinst.vert", pds_3dtexturedinst_vert );
+	const GlShader* vs3ddepth	= r.declare_shader ( GL_VERTEX_SHADER, "vs3ddepth", "3ddepth.vert", pds_3ddepth_vert );
+	const GlShader* vs3ddepthi	= r.declare_shader ( GL_VERTEX_SHADER, "vs3ddepthinst", "3ddepthinst.vert", pds_3ddepthinst_vert );
 	const GlShader* fs3dtextured= r.declare_shader ( GL_FRAGMENT_SHADER, "fs3dtextured", "3dtextured.frag", pds_3dtextured_frag );
 	const GlShader* fsflat		= r.declare_shader ( GL_FRAGMENT_SHADER, "fsflat", "flat.frag", pds_flat_frag );
 	const GlShader* fsgouraud	= r.declare_shader ( GL_FRAGMENT_SHADER, "fsgouraud", "gouraud.frag", pds_gouraud_frag );
+	const GlShader* fsgouraudsh	= r.declare_shader ( GL_FRAGMENT_SHADER, "fsgouraudsh", "gouraudsh.frag", pds_gouraudsh_frag );
+	const GlShader* fsdepth		= r.declare_shader ( GL_FRAGMENT_SHADER, "fsdepth", "depth.frag", pds_depth_frag );
 	const GlShader* fsphong		= r.declare_shader ( GL_FRAGMENT_SHADER, "fsphong", "phong.frag", pds_phong_frag );
 	const GlShader* fsphongmc	= r.declare_shader ( GL_FRAGMENT_SHADER, "fsphongmc", "phongmc.frag", pds_phongmc_frag );
 	const GlShader* vshadefunc	= r.declare_shader ( GL_VERTEX_SHADER, "vshadefunc", "shadefunc.glsl", pds_shadefunc_glsl );
 	const GlShader* fshadefunc	= r.declare_shader ( GL_FRAGMENT_SHADER, "fshadefunc", "shadefunc.glsl", pds_shadefunc_glsl );
+	const GlShader* fshadowfunc	= r.declare_shader ( GL_FRAGMENT_SHADER, "fshadowfunc", "shadowfunc.glsl", pds_shadowfunc_glsl );
 
 	const GlProgram* p;
 	p = r.declare_program ( "2dcolored", 2, vs2dcolored, fsflat );
@@ -582,15 +734,18 @@ void GlResources::declare_default_shaders ()
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
 
-	p = r.declare_program ( "3dgouraud", 3, vs3dgouraud, vshadefunc, fsgouraud );
+	p = r.declare_program ( "3dgouraud", 4, vs3dgouraud, vshadefunc, fsgouraudsh, fshadowfunc );
 	r.declare_uniform ( p, 0, "vProj" );
 	r.declare_uniform ( p, 1, "vView" );
 	r.declare_uniform ( p, 2, "lPos" );
 	r.declare_uniform ( p, 3, "lInt" );
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
 
-	p = r.declare_program ( "3dtextured", 3, vs3dtextured, fs3dtextured, fshadefunc );
+	p = r.declare_program ( "3dtextured", 4, vs3dtextured, fs3dtextured, fshadefunc, fshadowfunc );
 	r.declare_uniform ( p, 0, "vProj" );
 	r.declare_uniform ( p, 1, "vView" );
 	r.declare_uniform ( p, 2, "lPos" );
@@ -599,23 +754,100 @@ void GlResources::declare_default_shaders ()
 	r.declare_uniform ( p, 5, "mParams" );
 	r.declare_uniform ( p, 6, "Mode" );
 	r.declare_uniform ( p, 7, "TexId" );
+	r.declare_uniform ( p, 8, "sMat" );
+	r.declare_uniform ( p, 9, "sMap" );
+	r.declare_uniform ( p, 10, "sOn" );
 
 
-	p = r.declare_program ( "3dphong", 3, vs3dphong, fsphong, fshadefunc );
+	p = r.declare_program ( "3dphong", 4, vs3dphong, fsphong, fshadefunc, fshadowfunc );
 	r.declare_uniform ( p, 0, "vProj" );
 	r.declare_uniform ( p, 1, "vView" );
 	r.declare_uniform ( p, 2, "lPos" );
 	r.declare_uniform ( p, 3, "lInt" );
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
 
-	p = r.declare_program ( "3dphongmc", 3, vs3dphongmc, fsphongmc, fshadefunc );
+	p = r.declare_program ( "3dphongmc", 4, vs3dphongmc, fsphongmc, fshadefunc, fshadowfunc );
 	r.declare_uniform ( p, 0, "vProj" );
 	r.declare_uniform ( p, 1, "vView" );
 	r.declare_uniform ( p, 2, "lPos" );
 	r.declare_uniform ( p, 3, "lInt" );
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
+
+	// Instanced versions of the 3d programs, with per-instance modelview matrices:
+	p = r.declare_program ( "3dsmoothinst", 2, vs3dsmoothi, fsgouraud );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+
+	p = r.declare_program ( "3dflatinst", 3, vs3dflati, vshadefunc, fsflat );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+
+	p = r.declare_program ( "3dgouraudinst", 4, vs3dgouraudi, vshadefunc, fsgouraudsh, fshadowfunc );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
+
+	p = r.declare_program ( "3dtexturedinst", 4, vs3dtexturedi, fs3dtextured, fshadefunc, fshadowfunc );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "Mode" );
+	r.declare_uniform ( p, 7, "TexId" );
+	r.declare_uniform ( p, 8, "sMat" );
+	r.declare_uniform ( p, 9, "sMap" );
+	r.declare_uniform ( p, 10, "sOn" );
+
+	p = r.declare_program ( "3dphonginst", 4, vs3dphongi, fsphong, fshadefunc, fshadowfunc );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
+
+	p = r.declare_program ( "3dphongmcinst", 4, vs3dphongmci, fsphongmc, fshadefunc, fshadowfunc );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "sMat" );
+	r.declare_uniform ( p, 7, "sMap" );
+	r.declare_uniform ( p, 8, "sOn" );
+
+	// Depth-only programs used to render shadow maps:
+	p = r.declare_program ( "3ddepth", 2, vs3ddepth, fsdepth );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+
+	p = r.declare_program ( "3ddepthinst", 2, vs3ddepthi, fsdepth );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
 
 	p = r.declare_program ( "dftext", 2,
 		r.declare_shader ( GL_VERTEX_SHADER,   "vsdftext", "dftext.vert", pds_dftext_vert ),
@@ -656,7 +888,7 @@ void GlResources::print_report ()
 	gsout<<"\nDefault config files: "<<CFGCUSTOM<<gspc<<DEFCFGFILE<<gsnl;
 	gsout<<"Pre-defined shaders loaded from executable: "<<NumPredefShadersLoaded<<gsnl;
 
-	GsTablePt<GlShader>& ts = ShaderTable;
+	GsHashTablePt<GlShader>& ts = ShaderTable;
 	gsout<<"\nShader Table - collisions:"<<ts.collisions()<< ", longest:"<<ts.longest_entry()<<gsnl;
 	for ( i=0,n=0; i<ts.size(); i++ )
 	{	if ( !ts.key(i) ) continue;
@@ -669,7 +901,7 @@ void GlResources::print_report ()
 	}
 	outentries(n);
 
-	GsTablePt<GlProgram>& tp = ProgramTable;
+	GsHashTablePt<GlProgram>& tp = ProgramTable;
 	gsout<<"\nProgram Table - collisions:"<<tp.collisions()<< ", longest:"<<tp.longest_entry()<<gsnl;
 	for ( i=0,n=0; i<tp.size(); i++ )
 	{	if ( !tp.key(i) ) continue;
@@ -691,7 +923,7 @@ void GlResources::print_report ()
 	}
 	outentries(n);
 
-	GsTablePt<GlTexture>& tt = TextureTable;
+	GsHashTablePt<GlTexture>& tt = TextureTable;
 	gsout<<"\nTexture Table - collisions:"<<tt.collisions()<< ", longest:"<<tt.longest_entry()<<gsnl;
 	for ( i=0,n=0; i<tt.size(); i++ )
 	{	if ( !tt.key(i) ) continue;
@@ -703,7 +935,7 @@ void GlResources::print_report ()
 	}
 	outentries(n);
 
-	GsTablePt<GlFont>& tf = FontTable;
+	GsHashTablePt<GlFont>& tf = FontTable;
 	gsout<<"\nFont Table - collisions:"<<tf.collisions()<< ", longest:"<<tf.longest_entry()<<gsnl;
 	for ( i=0,n=0; i<tf.size(); i++ )
 	{	if ( !tf.key(i) ) continue;
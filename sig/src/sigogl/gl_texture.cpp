@@ -6,7 +6,10 @@
   =======================================================================*/
 
 # include <sigogl/gl_core.h>
+# include <sigogl/gl_context.h>
 # include <sigogl/gl_texture.h>
+# include <sigogl/gl_tools.h>
+# include <sigogl/ws_osinterface.h>
 
 # include <sig/gs_image.h>
 
@@ -17,31 +20,67 @@ GlTexture::GlTexture ()
 	id = 0;
 	width = height = 0;
 	_decl = 0;
+	_storage = 0;
+	_levels = 0;
 }
 
 GlTexture::~GlTexture ()
 {
 	// id 0 means texture not generated
-	if ( id>0 ) glDeleteTextures ( 1, &id );
+	if ( id>0 ) { glDeleteTextures(1,&id); GlContext::invalidate_textures(); }
 }
 
 void GlTexture::init ()
 {
-	if ( id>0 ) glDeleteTextures ( 1, &id );
+	if ( id>0 ) { glDeleteTextures(1,&id); GlContext::invalidate_textures(); }
 	id = 0;
 	width = height = 0;
+	_storage = 0;
+	_levels = 0;
 }
 
-void GlTexture::data ( const GsImage* img, Settings s )
+static int levels ( int w, int h, GlTexture::Settings s )
 {
-	if ( id==0 ) glGenTextures ( 1, &id );
-	glBindTexture ( GL_TEXTURE_2D, id ); 
+	if ( s!=GlTexture::MipMapped ) return 1;
+	int n=1;
+	for ( int d=GS_MAX(w,h); d>1; d/=2 ) n++;
+	return n;
+}
 
-	width = img->w();
-	height = img->h();
+void GlTexture::_upload ( GLenum ifmt, GLenum fmt, int w, int h, const void* pixels, Settings s )
+{
+	GLint curtex; // binding to be restored, which may be tracked by a GlContext
+	glGetIntegerv ( GL_TEXTURE_BINDING_2D, &curtex );
+
+	// glTexStorage2D() is after the functions loaded by default, so it is loaded here when available:
+	static gscbool storage = gl_version()>=420 && ( glTexStorage2D || ( glTexStorage2D=(PFNGLTEXSTORAGE2DPROC)wsi_get_ogl_procedure("glTexStorage2D") ) );
+
+	if ( storage ) // immutable storage
+	{	int nl = levels ( w, h, s );
+		if ( _storage && ( _storage!=ifmt || _levels!=nl || width!=w || height!=h ) ) // cannot be reused
+		{	if ( curtex==(GLint)id ) curtex=0;
+			glDeleteTextures ( 1, &id );
+			GlContext::invalidate_textures(); // a new texture may get the same id
+			id = 0;
+		}
+		if ( id==0 ) { glGenTextures(1,&id); _storage=0; }
+		glBindTexture ( GL_TEXTURE_2D, id );
+		if ( !_storage )
+		{	glTexStorage2D ( GL_TEXTURE_2D, nl, ifmt, w, h );
+			_storage = ifmt;
+			_levels = (gsbyte)nl;
+		}
+		glTexSubImage2D ( GL_TEXTURE_2D, 0, 0, 0, w, h, fmt, GL_UNSIGNED_BYTE, pixels );
+	}
+	else
+	{	if ( id==0 ) glGenTextures ( 1, &id );
+		glBindTexture ( GL_TEXTURE_2D, id );
+		// Parameters: ( target, level, internalFormat, width, height, border, format, type, data )
+		glTexImage2D ( GL_TEXTURE_2D, 0, ifmt, w, h, 0, fmt, GL_UNSIGNED_BYTE, pixels );
+	}
 
-	// Parameters: ( target, level, internalFormat, width, height, border, format, type, data )
-	glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGBA, img->w(), img->h(), 0, GL_RGBA, GL_UNSIGNED_BYTE, img->cdata() );
+	width = w;
+	height = h;
 
 	// ImprNote: starting at 4.5 glTextureParameter() should replace glTexParameter(),
 	//			 here could test which function version was loaded and call the correct one.
@@ -54,38 +93,20 @@ void GlTexture::data ( const GsImage* img, Settings s )
 		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	}
 	else if ( s==MipMapped )
-	{	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_NEAREST); 
+	{	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // magnification does not use mipmaps
 		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST); 
 		glGenerateMipmap (GL_TEXTURE_2D);
 	}
 
-	glBindTexture ( GL_TEXTURE_2D, 0 );
+	glBindTexture ( GL_TEXTURE_2D, curtex );
 }
 
-void GlTexture::data ( const GsBytemap* bmp, Settings s )
+void GlTexture::data ( const GsImage* img, Settings s )
 {
-	if ( id==0 ) glGenTextures ( 1, &id );
-
-	glBindTexture ( GL_TEXTURE_2D, id ); 
-
-	width = bmp->w();
-	height = bmp->h();
-
-	// Parameters: ( target, level, internalFormat, width, height, border, format, type, data )
-	glTexImage2D ( GL_TEXTURE_2D, 0, GL_RED, bmp->w(), bmp->h(), 0, GL_RED, GL_UNSIGNED_BYTE, bmp->cdata() );
-
-	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // If the u,v coordinates overflow the range 0,1 the image is repeated
-	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	if ( s==Filtered )
-	{	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // linear takes average of nearby texels
-		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	}
-	else if ( s==MipMapped )
-	{	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_NEAREST); 
-		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST); 
-		glGenerateMipmap (GL_TEXTURE_2D);
-	}
+	_upload ( GL_RGBA8, GL_RGBA, img->w(), img->h(), img->cdata(), s );
+}
 
-	glBindTexture ( GL_TEXTURE_2D, 0 );
+void GlTexture::data ( const GsBytemap* bmp, Settings s )
+{
+	_upload ( GL_R8, GL_RED, bmp->w(), bmp->h(), bmp->cdata(), s );
 }
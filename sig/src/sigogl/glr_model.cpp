@@ -22,17 +22,81 @@
 //# define GS_USE_TRACE4 // Render type
 # include <sig/gs_trace.h>
 
+//=================================== GlrModelBuffers ================================
+
+// Vertex arrays and buffers of a model, shared by all GlrModels rendering it
+struct GlrModelBuffers
+{	GsModel* model;				// referenced so that its address is not reused
+	const GlContext* context;	// vertex arrays are not shared among contexts
+	gsuint16 layout;			// encodes the data layout in the buffers
+	gscbool uploaded;			// false until the first upload
+	gscbool normalspervertex;
+	gscbool instancing;			// true once the instance matrix attributes are declared
+	gsuint pass;				// render pass of the last upload
+	const GlrModel* uploader;	// renderer which made the last upload
+	int users;
+	GlObjects glo;
+};
+
+static GsArray<GlrModelBuffers*> SharedBuffers;
+
+static GlrModelBuffers* acquire_buffers ( const GsModel& m, const GlContext* c, gsuint16 layout )
+{
+	GlrModelBuffers* b;
+	for ( int i=0; i<SharedBuffers.size(); i++ )
+	{	b = SharedBuffers[i];
+		if ( b->model==&m && b->context==c && b->layout==layout ) { b->users++; return b; }
+	}
+	GS_TRACE1 ( "New buffer set for ["<<m.name<<"]" );
+	b = new GlrModelBuffers;
+	b->model = (GsModel*)&m;
+	b->model->ref();
+	b->context = c;
+	b->layout = layout;
+	b->uploaded = 0;
+	b->normalspervertex = 0;
+	b->instancing = 0;
+	b->pass = 0;
+	b->uploader = 0;
+	b->users = 1;
+	b->glo.gen_vertex_arrays ( 1 );
+	b->glo.gen_buffers ( 4 ); // it will need 2 or 3 buffers, plus one for instance matrices
+	SharedBuffers.push() = b;
+	return b;
+}
+
+static void release_buffers ( GlrModelBuffers* b )
+{
+	if ( --b->users>0 ) return;
+	for ( int i=0; i<SharedBuffers.size(); i++ )
+	{	if ( SharedBuffers[i]==b ) { SharedBuffers[i]=SharedBuffers.pop(); break; }
+	}
+	b->model->unref();
+	delete b;
+}
+
 //======================================= GlrModel ====================================
 
 GlrModel::GlrModel ()
 {
 	GS_TRACE1 ( "Constructor" );
-	_normalspervertex = false;
 }
 
 GlrModel::~GlrModel ()
 {
 	GS_TRACE1 ( "Destructor" );
+	_release ();
+}
+
+void GlrModel::_release ()
+{
+	for ( int i=0; i<_bufs.size(); i++ ) if ( _bufs[i] ) release_buffers(_bufs[i]);
+	_bufs.size ( 0 );
+}
+
+int GlrModel::buffer_sets ()
+{
+	return SharedBuffers.size();
 }
 
 static const GlProgram* pFlat=0;
@@ -41,6 +105,34 @@ static const GlProgram* pPhong=0;
 static const GlProgram* pText=0;
 static const GlProgram* pPhongMC=0;
 static const GlProgram* pColored=0;
+static const GlProgram* pDepth=0;
+
+// Instanced programs are only loaded when instanced rendering is first used
+static const GlProgram* instanced_program ( const GlProgram* p )
+{
+	static const GlProgram *pi[6] = { 0, 0, 0, 0, 0, 0 };
+	if ( !pi[0] )
+	{	pi[0] = GlResources::get_program("3dflatinst");
+		pi[1] = GlResources::get_program("3dgouraudinst");
+		pi[2] = GlResources::get_program("3dtexturedinst");
+		pi[3] = GlResources::get_program("3dphonginst");
+		pi[4] = GlResources::get_program("3dphongmcinst");
+		pi[5] = GlResources::get_program("3dsmoothinst");
+	}
+	return p==pFlat? pi[0] : p==pGour? pi[1] : p==pText? pi[2] : p==pPhong? pi[3] : p==pPhongMC? pi[4] : pi[5];
+}
+
+static inline void draw_elements ( int n, const GsModel::Face* f, int ninst )
+{
+	if ( ninst ) glDrawElementsInstanced ( GL_TRIANGLES, n, GL_UNSIGNED_INT, f, ninst );
+	else glDrawElements ( GL_TRIANGLES, n, GL_UNSIGNED_INT, f );
+}
+
+static inline void draw_arrays ( int first, int n, int ninst )
+{
+	if ( ninst ) glDrawArraysInstanced ( GL_TRIANGLES, first, n, ninst );
+	else glDrawArrays ( GL_TRIANGLES, first, n );
+}
 
 void GlrModel::init ( SnShape* s )
 {
@@ -50,27 +142,39 @@ void GlrModel::init ( SnShape* s )
 		pGour = GlResources::get_program("3dgouraud");
 		pText = GlResources::get_program("3dtextured");
 		pPhong = GlResources::get_program("3dphong");
+		pDepth = GlResources::get_program("3ddepth");
 		// pPhongMC and pColored are not as used and are later loaded only when/if needed 
 	}
-	_glo.gen_vertex_arrays ( 1 );
-	_glo.gen_buffers ( 3 ); // it will need 2 or 3 buffers
 }
 
-static inline void _add_texture ( GsModel::Group& G, const GsModel& m )
-{	
-	G.dmap->id = GlResources::declare_texture(G.dmap->fname,G.dmap->fname);
-	GsString path = m.filename;
-	if ( path.len() )
-	{	remove_filename ( path );
-		GlResources::dirs().push(path);
-	}
+void GlrModel::render ( SnShape* s, GlContext* c )
+{
+	_render ( s, c, 0, 0 );
 }
 
-void GlrModel::render (  SnShape* s, GlContext* c )
+void GlrModel::render_instances ( SnShape* s, GlContext* c, const GsMat* mats, int n )
 {
-	const GsModel& m = *((const SnModel*)s)->cmodel();
+	if ( n<=0 ) return;
+	_render ( s, c, mats, n );
+}
 
-	GS_TRACE2 ( "Start rendering "<<s->instance_name()<<" ["<<m.name<<"]" );
+void GlrModel::_render ( SnShape* s, GlContext* c, const GsMat* mats, int ninst )
+{
+	const SnModel* sm = (const SnModel*)s;
+	const GsModelLod* lod = sm->lod();
+	int level = 0;
+	if ( lod && lod->levels()>1 ) // select the level of detail from the projected size
+	{	if ( ninst ) // the finest level needed by the instances is used
+		{	level = lod->levels()-1;
+			for ( int i=0; i<ninst && level>0; i++ ) level = GS_MIN ( level, lod->select(*c->projection(),mats[i]) );
+		}
+		else
+		{	level = lod->select ( *c->projection(), *c->modelview() );
+		}
+	}
+	const GsModel& m = level? *lod->level(level) : *sm->cmodel();
+
+	GS_TRACE2 ( "Start rendering "<<s->instance_name()<<" ["<<m.name<<"] level "<<level );
 
 	GS_TRACE3 ( "Faces     : "<<m.F.size() );
 	GS_TRACE3 ( "Normals   : "<<m.N.size() );
@@ -120,49 +224,67 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 	{	GS_TRACE4 ( "MtlMode: NoMtl or PerGroupMtl..." );
 	}
 
-	// 2. Set buffer data if node has been changed (flags are: Unchanged, RenderModeChanged, MaterialChanged, Changed)
-	if ( s->changed()&SnShape::Changed )
-	{	glBindVertexArray ( _glo.va[0] );
+	// 2. Get the buffers shared by all renderers of the model with the same data layout,
+	// buffers of each level of detail are kept to switch levels without new uploads:
+	int geo = p==pColored? 0 : m.geomode()==GsModel::Smooth && p!=pFlat? 1 : p==pFlat? 2:3;
+	gsuint16 layout = gsuint16 ( geo | (textured? 4:0) | (mtlmode<<3) );
+	while ( _bufs.size()<=level ) _bufs.push()=0;
+	GlrModelBuffers*& bset = _bufs[level];
+	if ( !bset || bset->model!=&m || bset->context!=c || bset->layout!=layout )
+	{	if ( bset ) release_buffers ( bset );
+		bset = acquire_buffers ( m, c, layout );
+	}
+	GlrModelBuffers& B = *bset;
+
+	// 3. Set buffer data if node has been changed (flags are: Unchanged, RenderModeChanged, MaterialChanged, Changed).
+	// Shapes sharing the model are all changed when first rendered, but only one upload per pass is needed.
+	// An upload made while rendering a shadow map is not repeated in the same pass.
+	bool upload = !B.uploaded || ( (s->changed()&SnShape::Changed) && ( B.pass!=c->pass() || B.uploader==this ) );
+	if ( upload )
+	{	B.uploaded = 1;
+		B.pass = c->pass();
+		B.uploader = c->depth_pass()? 0:this;
+		glBindVertexArray ( B.glo.va[0] );
 
 		if ( p==pColored ) // colors per vertex, no illumination, only declare vertices
 		{	GS_TRACE4 ( "Defining V buffer..." );
-			_normalspervertex = false;
+			B.normalspervertex = 0;
 			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[0] );
 			glBufferData ( GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
 		}
 		else if ( m.geomode()==GsModel::Smooth && p!=pFlat ) // normals per vertex, or no normals smooth mode
 		{	GS_TRACE4 ( "Defining V,N buffers per vertex..." );
-			_normalspervertex = true;
+			B.normalspervertex = 1;
 			// Vertices:
 			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[0] );
 			glBufferData ( GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
 			// Normals:
 			glEnableVertexAttribArray ( 1 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[1] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[1] );
 			glBufferData ( GL_ARRAY_BUFFER, m.N.sizeofarray(), m.N.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( 1, 3, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
 			// Tx coordinates:
 			if ( textured )
 			{	GS_TRACE4 ( "Including texture coordinates..." );
 				glEnableVertexAttribArray ( 2 );
-				glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[2] );
+				glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[2] );
 				glBufferData ( GL_ARRAY_BUFFER, m.T.sizeofarray(), m.T.pt(), GL_STATIC_DRAW );
 				glVertexAttribPointer ( 2, 2, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
 			}
 		}
 		else
 		{	GS_TRACE4 ( "Defining V,N buffers per face..." );
-			_normalspervertex = false;
+			B.normalspervertex = 0;
 			GsArray<GsVec> va;
 			unsigned bufsize = m.F.size()*9*sizeof(float);
 			// Vertices:
 			m.get_vertices_per_face ( va );
 			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[0] );
 			glBufferData ( GL_ARRAY_BUFFER, bufsize, va.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
 			// Normals:
@@ -175,7 +297,7 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 				m.get_normals_per_face(va);
 			}
 			glEnableVertexAttribArray ( 1 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[1] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[1] );
 			glBufferData ( GL_ARRAY_BUFFER, bufsize, va.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( 1, 3, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
 			// Tx coordinates:
@@ -184,7 +306,7 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 				GsArray<GsVec2> tca;
 				m.get_texcoords_per_face ( tca );
 				glEnableVertexAttribArray ( 2 );
-				glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[2] );
+				glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[2] );
 				glBufferData ( GL_ARRAY_BUFFER, tca.sizeofarray(), tca.pt(), GL_STATIC_DRAW );
 				glVertexAttribPointer ( 2, 2, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
 			}
@@ -205,68 +327,106 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 			gsuint bufid = m.mtlmode()==GsModel::PerVertexColor? 1:2;
 			GS_TRACE4 ( "Defining bufferid "<<bufid );
 			glEnableVertexAttribArray ( bufid );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[bufid] );
+			glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[bufid] );
 			glBufferData ( GL_ARRAY_BUFFER, C.sizeofarray(), C.pt(), GL_STATIC_DRAW );
 			glVertexAttribPointer ( bufid, 4, GL_UNSIGNED_BYTE, GL_FALSE, 0, 0 );
 		}
 	}
 
-	// 3. Enable/bind needed elements and draw:
+	// 4. Set the instance matrices, which are not shared among renderers:
+	if ( ninst )
+	{	GS_TRACE4 ( "Instances: "<<ninst );
+		glBindVertexArray ( B.glo.va[0] );
+		glBindBuffer ( GL_ARRAY_BUFFER, B.glo.buf[3] );
+		glBufferData ( GL_ARRAY_BUFFER, ninst*sizeof(GsMat), mats, GL_STREAM_DRAW );
+		if ( !B.instancing ) // each matrix line is one column of the mat4 attribute, see shaders/notes.txt
+		{	B.instancing = 1;
+			for ( int i=0; i<4; i++ )
+			{	glEnableVertexAttribArray ( 4+i );
+				glVertexAttribPointer ( 4+i, 4, GL_FLOAT, GL_FALSE, sizeof(GsMat), (void*)(i*4*sizeof(float)) );
+				glVertexAttribDivisor ( 4+i, 1 );
+			}
+		}
+	}
+
+	// 5. In a shadow map pass only the depth of all faces is needed:
+	if ( c->depth_pass() )
+	{	static const GlProgram* pDepthInst=0;
+		if ( ninst && !pDepthInst ) pDepthInst = GlResources::get_program("3ddepthinst");
+		p = ninst? pDepthInst : pDepth;
+		c->use_program ( p->id );
+		glBindVertexArray ( B.glo.va[0] );
+		glUniformMatrix4fv ( p->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+		glUniformMatrix4fv ( p->uniloc[1], 1, GLTRANSPMAT, ninst? GsMat::id.e : c->modelview()->e );
+		if ( B.normalspervertex ) draw_elements ( m.F.size()*3, m.F.pt(), ninst );
+		else draw_arrays ( 0, m.F.size()*3, ninst );
+		return;
+	}
+
+	// 6. Enable/bind needed elements and draw:
+	bool shadows = p==pGour || p==pPhong || p==pText || p==pPhongMC;
+	if ( ninst ) p = instanced_program ( p );
 	c->use_program ( p->id );
-	glBindVertexArray ( _glo.va[0] );
+	glBindVertexArray ( B.glo.va[0] );
 
 	float buf[12];
 	glUniformMatrix4fv ( p->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
-	glUniformMatrix4fv ( p->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
+	glUniformMatrix4fv ( p->uniloc[1], 1, GLTRANSPMAT, ninst? GsMat::id.e : c->modelview()->e );
+
+	if ( shadows ) // the shadow uniforms are the last 3 ones
+	{	int u = p->nu-3;
+		glUniform1i ( p->uniloc[u+1], 1 ); // the shadow map is always on texture unit 1
+		glUniform1i ( p->uniloc[u+2], c->shadow_map()? 1:0 );
+		if ( c->shadow_map() ) glUniformMatrix4fv ( p->uniloc[u], 1, GLTRANSPMAT, c->shadow_matrix()->e );
+	}
 
 	# define DEFINE_LIGHT(L)		glUniform3fv ( p->uniloc[2], 1, L.position.e ); \
 									glUniform3fv ( p->uniloc[3], 3, L.encode_intensities(buf) )
 	# define DEFINE_MATERIAL(M)		glUniform3fv ( p->uniloc[4], 4, M.encode_colors(buf) ); \
 									glUniform1fv ( p->uniloc[5], 2, M.encode_params(buf) )
-	# define DRAW_GROUP_ELEMENTS(G) glDrawElements ( GL_TRIANGLES, G.fn*3, GL_UNSIGNED_INT, &m.F[G.fi].a )
-	# define DRAW_GROUP_ARRAYS(G)	glDrawArrays ( GL_TRIANGLES, G.fi*3, G.fn*3 )
+	# define DRAW_GROUP_ELEMENTS(G) draw_elements ( G.fn*3, &m.F[G.fi], ninst )
+	# define DRAW_GROUP_ARRAYS(G)	draw_arrays ( G.fi*3, G.fn*3, ninst )
 	# define DRAW_GROUP(G,npv) 		if (npv) DRAW_GROUP_ELEMENTS(G); else DRAW_GROUP_ARRAYS(G)
 
 	if ( mtlmode==GsModel::NoMtl )
 	{	DEFINE_LIGHT ( c->light );
 		DEFINE_MATERIAL ( s->material() );
-		if ( _normalspervertex )
+		if ( B.normalspervertex )
 		{	GS_TRACE4 ( "Drawing per-vertex smooth, default material" );
-			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+			draw_elements ( m.F.size()*3, m.F.pt(), ninst );
 		}
 		else 
 		{	GS_TRACE4 ( "Drawing per-face shading, default material" );
-			glDrawArrays ( GL_TRIANGLES, 0, m.F.size()*3 );
+			draw_arrays ( 0, m.F.size()*3, ninst );
 		}
 	}
 	else if ( mtlmode==GsModel::PerGroupMtl )
 	{	DEFINE_LIGHT ( c->light );
 		const int gsize = m.G.size();
 		if ( textured ) // per-group with textures
-		{	GS_TRACE4 ( "Drawing "<<(_normalspervertex?"pre-vertex":"per-face")<<" shading, grouped materials with textures" );
+		{	GS_TRACE4 ( "Drawing "<<(B.normalspervertex?"pre-vertex":"per-face")<<" shading, grouped materials with textures" );
 			glUniform1i ( p->uniloc[6], 0 ); // Mode 0 is with texture
 			glUniform1i ( p->uniloc[7], 0 ); // Tell to use sampler for texture unit 0
 			for ( int g=0; g<gsize; g++ )
 			{	GsModel::Group& G=*m.G[g];
 				GsMaterial& M=m.M[g];
 				if ( G.dmap ) // has diffuse texture
-				{	if ( G.dmap->id<0 ) _add_texture(G,m); // need to declare texture
+				{	if ( G.dmap->id<0 ) GlResources::declare_textures(&m); // need to declare textures
 					const GlTexture* t = GlResources::get_texture ( G.dmap->id );
 					glActiveTexture ( GL_TEXTURE0 + 0 );	// Only using texture unit 0
-					glBindTexture ( GL_TEXTURE_2D, t->id ); // Bind image
+					c->bind_texture ( t->id );				// Bind image if not already bound
 					DEFINE_MATERIAL(M);
-					DRAW_GROUP(G,_normalspervertex);
+					DRAW_GROUP(G,B.normalspervertex);
 				}
 				else
 				{	glUniform1i ( p->uniloc[6], 1 ); // set mode to no texture
 					DEFINE_MATERIAL(M);
-					DRAW_GROUP(G,_normalspervertex);
+					DRAW_GROUP(G,B.normalspervertex);
 					glUniform1i ( p->uniloc[6], 0 ); // set mode back to textured
 				}
 			}
-			glBindTexture ( GL_TEXTURE_2D, 0 );
 		}
-		else if ( _normalspervertex ) // per-group no textures
+		else if ( B.normalspervertex ) // per-group no textures
 		{	GS_TRACE4 ( "Drawing per-vertex smooth, grouped materials" );
 			for ( int g=0; g<gsize; g++ )
 			{	GsModel::Group& G=*m.G[g];
@@ -288,18 +448,18 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 	else if ( m.mtlmode()==GsModel::PerVertexMtl || m.mtlmode()==GsModel::PerFaceMtl )
 	{	DEFINE_LIGHT ( c->light );
 		DEFINE_MATERIAL ( m.M[0] );
-		if ( _normalspervertex )
+		if ( B.normalspervertex )
 		{	GS_TRACE4 ( "Drawing per-vertex materials, per-vertex normals" );
-			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+			draw_elements ( m.F.size()*3, m.F.pt(), ninst );
 		}
 		else 
 		{	GS_TRACE4 ( "Drawing per-vertex materials, per-face normals" );
-			glDrawArrays ( GL_TRIANGLES, 0, m.F.size()*3 );
+			draw_arrays ( 0, m.F.size()*3, ninst );
 		}
 	}
 	else // GsModel::PerVertexColor
 	{	GS_TRACE4 ( "Drawing without shading, only per-vertex colors" );
-		glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+		draw_elements ( m.F.size()*3, m.F.pt(), ninst );
 	}
 
 	glBindVertexArray ( 0 );
@@ -88,7 +88,7 @@ void GlrPlanarObjects::render ( SnShape* s, GlContext* c )
 		for ( int i=0; i<gsize; i++ )
 		{	glUniform1i ( Prog->uniloc[3], o.G[i].type ); // Mode
 			if ( o.G[i].type!=SnPlanarObjects::Colored )
-			{	glBindTexture ( GL_TEXTURE_2D, o.G[i].texid ); // Bind image
+			{	c->bind_texture ( o.G[i].texid ); // Bind image
 			}
 			const int numi = G[i+1].ind-G[i].ind;
 			glDrawElements ( GL_TRIANGLES, numi, GL_UNSIGNED_INT, indices );
@@ -6,6 +6,7 @@
   =======================================================================*/
 
 # include <stdlib.h>
+# include <math.h>
 
 # include <sig/gs_string.h>
 
@@ -23,14 +24,79 @@ struct SwTimerData
 	union { void* udata; int evid; };
 };
 
+struct SwClockData
+{	double step;		// fixed simulation step
+	double frame;		// interval between frames
+	double acc;			// elapsed time not yet simulated
+	double lasttime;	// time of the last frame
+	double nextframe;	// time the next frame is due
+	int maxsteps;		// maximum number of updates per frame
+	int steps;			// number of updates done
+	void (*update) (void*);
+	void (*draw) (float,void*);
+	void* udata;
+};
+
 static GsArray<SwTimerData> Timers;
 static int NumTimers=0;
+static GsArray<SwClockData> Clocks;
+static GsArray<SwClockData> NewClocks; // clocks added by the callbacks
+static int NumClocks=0;
+static bool InClocks=false;
 static double Time0=0;
 static double TimeCur=0;
 
+static void check_clocks ()
+{
+	int i;
+	InClocks = true;
+	for ( i=0; i<Clocks.size(); i++ )
+	{	SwClockData& c = Clocks[i];
+		if ( !c.update || TimeCur<c.nextframe ) continue;
+		c.acc += TimeCur-c.lasttime;
+		c.lasttime = TimeCur;
+		int n = 0;
+		while ( c.acc>=c.step && c.update )
+		{	if ( n++==c.maxsteps ) { c.acc=fmod(c.acc,c.step); break; } // too far behind: drop the time
+			c.update ( c.udata );
+			c.acc -= c.step;
+			c.steps++;
+		}
+		if ( c.draw && c.update ) c.draw ( float(c.acc/c.step), c.udata );
+		c.nextframe += c.frame;
+		if ( c.nextframe<TimeCur ) c.nextframe = TimeCur+c.frame; // do not try to catch up with frames
+	}
+	InClocks = false;
+
+	// Remove clocks removed by the callbacks and add the new ones:
+	for ( i=0; i<Clocks.size(); i++ )
+	{	if ( !Clocks[i].update ) { Clocks[i]=Clocks.top(); Clocks.pop(); i--; }
+	}
+	for ( i=0; i<NewClocks.size(); i++ )
+	{	if ( NewClocks[i].update ) Clocks.push()=NewClocks[i];
+	}
+	NewClocks.size ( 0 );
+}
+
+// time until the next timer or clock is due, or -1 if there is nothing scheduled
+static double next_deadline ()
+{
+	int i;
+	double t = -1;
+	for ( i=0; i<NumTimers; i++ )
+	{	double d = Timers[i].lasttime+Timers[i].interval;
+		if ( t<0 || d<t ) t=d;
+	}
+	for ( i=0; i<Clocks.size(); i++ )
+	{	if ( Clocks[i].update && ( t<0 || Clocks[i].nextframe<t ) ) t=Clocks[i].nextframe;
+	}
+	return t<0? -1 : GS_MAX ( t-(gs_time()-Time0), 0 );
+}
+
 void ws_check_timers ()
 {
 	TimeCur = gs_time()-Time0;
+	if ( NumClocks && !InClocks ) check_clocks (); // callbacks may call ws_check()
 	for ( int i=0; i<NumTimers; i++ )
 	{	if ( TimeCur-Timers[i].lasttime > Timers[i].interval )
 		{	if ( Timers[i].callback )
@@ -68,6 +134,47 @@ void ws_add_timer ( double interval, WsWindow* win, int ev )
 	Timers.top().evid = ev;
 }
 
+void ws_add_clock ( double step, void(*update)(void*), void(*draw)(float,void*), void* udata, double frame, int maxsteps )
+{
+	if ( Time0==0 ) Time0 = gs_time();
+	TimeCur = gs_time()-Time0;
+	SwClockData& c = InClocks? NewClocks.push() : Clocks.push(); // Clocks cannot move during the callbacks
+	c.step = step>0? step : 1.0/60.0;
+	c.frame = frame>0? frame : c.step;
+	c.acc = 0;
+	c.lasttime = TimeCur;
+	c.nextframe = TimeCur+c.frame;
+	c.maxsteps = GS_MAX ( maxsteps, 1 );
+	c.steps = 0;
+	c.update = update;
+	c.draw = draw;
+	c.udata = udata;
+	NumClocks++;
+}
+
+void ws_remove_clock ( void(*update)(void*) )
+{
+	for ( int i=0; i<Clocks.size(); i++ )
+	{	if ( Clocks[i].update==update )
+		{	if ( InClocks ) Clocks[i].update=0; // removed after the current check
+			else { Clocks[i]=Clocks.top(); Clocks.pop(); }
+			NumClocks--;
+			return;
+		}
+	}
+	for ( int i=0; i<NewClocks.size(); i++ )
+	{	if ( NewClocks[i].update==update ) { NewClocks[i].update=0; NumClocks--; return; }
+	}
+}
+
+int ws_clock_steps ( void(*update)(void*) )
+{
+	for ( int i=0; i<Clocks.size(); i++ )
+	{	if ( Clocks[i].update==update ) return Clocks[i].steps;
+	}
+	return -1;
+}
+
 void ws_remove_timer ( void(*cb)(void*) )
 {
 	for ( int i=0; i<Timers.size(); i++ )
@@ -101,25 +208,29 @@ void ws_remove_timers ( WsWindow* win )
 	}
 }
 
+int ws_wait ( double secs )
+{
+	if ( Time0==0 ) Time0 = gs_time();
+	double end = gs_time()-Time0+secs;
+	int nwins;
+	do
+	{	double t = end-(gs_time()-Time0);
+		double d = next_deadline();
+		if ( d>=0 && d<t ) t=d;
+		nwins = wsi_wait ( t );
+		if ( NumTimers || NumClocks ) ws_check_timers ();
+	} while ( nwins && gs_time()-Time0<end );
+	return nwins;
+}
+
 void ws_run ( int sleepms )
 {
-	if ( sleepms>0 )
-	{	while ( wsi_check() )
-		{	gs_sleep ( sleepms );
-			if ( NumTimers ) ws_check_timers ();
-		}
-	}
-	else if ( sleepms<0 )
-	{	int n=sleepms;
-		while ( wsi_check() )
-		{	if ( NumTimers ) ws_check_timers ();
-			if ( ++n==0 ) { gs_sleep(1); n=sleepms; }
-		}
-	}
-	else
-	{	while ( wsi_check() )
-		{	if ( NumTimers ) ws_check_timers ();
-		}
+	int n=sleepms;
+	while ( wsi_check() )
+	{	if ( NumTimers || NumClocks ) ws_check_timers ();
+		if ( NumClocks ) wsi_wait ( next_deadline() ); // blocks until the next frame is due
+		else if ( sleepms>0 ) gs_sleep ( sleepms );
+		else if ( sleepms<0 && ++n==0 ) { gs_sleep(1); n=sleepms; }
 	}
 }
 
@@ -129,13 +240,13 @@ void ws_check ( int sleepms )
 	if ( sleepms>0 ) gs_sleep ( sleepms );
 	else if ( sleepms<0 && ++counter%-sleepms==0 ) gs_sleep(1);
    
-	if ( NumTimers ) ws_check_timers ();
+	if ( NumTimers || NumClocks ) ws_check_timers ();
 	if ( wsi_check()==0 ) exit(0);
 }
 
 int ws_fast_check ()
 {
-	if ( NumTimers ) ws_check_timers ();
+	if ( NumTimers || NumClocks ) ws_check_timers ();
 	return wsi_check ();
 }
 
@@ -33,6 +33,7 @@
 
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_tools.h>
+# include <sigogl/gl_capture.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
 # include <sigogl/gl_renderer.h>
@@ -92,11 +93,7 @@ class WsViewerData
 	GsCamera camera;		// The current camera and viewing parameters
 	GsMat matc, matp;		// Matrices used for camera and projection transformations
 
-	GsImage image;			// image memry is freed when not in use
-	GsString image_name;
-	GsString image_ext;
-	GsString image_filename;
-	int image_number;
+	GlCapture* capture;		// frame capture, created when first needed
 
 	UiPanel* rbpanel;		// right button activated menu
 
@@ -180,6 +177,7 @@ void WsViewer::build_ui ()
 		p->add ( new UiCheckButton ( "bounding box", VCmdBoundingBox ) );
 		p->add ( new UiCheckButton ( "statistics", VCmdStatistics ) );
 		p->add ( new UiCheckButton ( "spin anim", VCmdSpinAnim, 1 ) );
+		p->add ( new UiCheckButton ( "shadows", VCmdShadows ) );
 	}
 
 	//ImprNote: consider adding: number of lights, and ui style change
@@ -227,7 +225,7 @@ WsViewer::WsViewer ( int x, int y, int w, int h, const char *label )
 	_data->statistics  = false;
 
 	_data->fcounter = 0; // frame counter not in use
-	_data->image_number = 0; // not saving images
+	_data->capture = 0; // not saving images
 
 	_data->light.init();
 	_data->lightneedsupdate = true;
@@ -272,6 +270,7 @@ WsViewer::~WsViewer ()
 	_data->vr->unref();
 	_data->vroot->unref();
 	delete _data->fcounter;
+	if ( _data->capture ) { activate_ogl_context(); delete _data->capture; }
 	delete _data;
 }
 
@@ -383,6 +382,10 @@ int WsViewer::cmd ( ViewerCmd c )
 			if ( !_data->allowspinanim ) _data->spinning=false;
 		} break;
 
+		case VCmdShadows:
+		{	_data->vr->shadows ( !_data->vr->shadows() ); UPDATE(VCmdShadows,_data->vr->shadows());
+		} break;
+
 		// render mode radio buttons:
 		case VCmdAsIs:
 		{	_data->rendermode = ModeAsIs; SET(VCmdAsIs);
@@ -425,6 +428,7 @@ bool WsViewer::cmd_activated ( ViewerCmd c )
 		case VCmdBoundingBox: return SCENEBOX->visible()==1;
 		case VCmdStatistics: return _data->statistics==1;
 		case VCmdSpinAnim:	return _data->allowspinanim==1;
+		case VCmdShadows:	return _data->vr->shadows();
 
 		default : return false;
 	}
@@ -624,6 +628,11 @@ void WsViewer::camera ( const GsCamera& cam )
 	update_axis(&box);
 }
 
+GlRenderer* WsViewer::scene_renderer ()
+{
+	return _data->vr;
+}
+
 GsLight& WsViewer::light ()
 {
 	_data->lightneedsupdate = true;
@@ -658,29 +667,42 @@ void WsViewer::export_all_models ( const char* prefix, const char* dir )
 void WsViewer::snapshots ( bool onoff, const char* file, int n )
 {
 	if ( onoff==false ) // turn off
-	{	_data->image_number=0; // an index<=0 disables snapshots
-		_data->image.init(0,0); // free image memory
-		_data->image_name.len(0);
-		_data->image_ext.len(0);
-		_data->image_filename.len(0);
+	{	if ( !_data->capture ) return;
+		activate_ogl_context();
+		_data->capture->finish(); // waits for the remaining images to be saved
 	}
 	else // turn on
-	{	if ( file )
-		{	_data->image_name = file; 
-			if ( extract_extension(_data->image_name,_data->image_ext)>=0 ) // has extension
-			{	if ( _data->image_ext!="bmp" && _data->image_ext!="tga" ) _data->image_ext="png"; }
+	{	GsString name, ext;
+		if ( file )
+		{	name = file; 
+			if ( extract_extension(name,ext)>=0 ) // has extension
+			{	if ( ext!="bmp" && ext!="tga" ) ext="png"; }
 			else
-			{	if ( _data->image_name.lchar()=='.' ) _data->image_name.lchar(0); }
+			{	if ( name.lchar()=='.' ) name.lchar(0); }
 			output(0); message(0); // clear any messages on screen
 		}
 		else
-		{	_data->image_name = "img"; // default values
-			_data->image_ext = "png";
+		{	name = "img"; // default values
+			ext = "png";
 		}
-		_data->image_number = n<=0? 1:n;
+		if ( !_data->capture ) _data->capture = new GlCapture;
+		activate_ogl_context();
+		_data->capture->start ( name, ext, n<=0? 1:n );
 	}
 }
 
+void WsViewer::snapshots_stream ( FILE* s )
+{
+	if ( !_data->capture ) _data->capture = new GlCapture;
+	activate_ogl_context();
+	_data->capture->start ( s );
+}
+
+int WsViewer::snapshots_taken () const
+{
+	return _data->capture? _data->capture->frames() : 0;
+}
+
 //================== METHODS OVERRIDING WSWINDOW VIRTUAL METHODS ============================
 
 void WsViewer::init ( GlContext* c, int w, int h )
@@ -741,18 +763,20 @@ void WsViewer::draw ( GlRenderer* wr )
 	//----- Update statistics -------------------------------------------
 	if ( _data->statistics )
 	{	double fps = WsViewer::fps(); // this call will allocate timer if needed
-		_data->message()->text().setf ( "FPS:%5.2f frame %2.0f:%4.1fms render:%4.1fms", fps,
+		const GlRenderer::Stats& st = _data->vr->stats();
+		_data->message()->text().setf ( "FPS:%5.2f frame %2.0f:%4.1fms render:%4.1fms shapes:%d prog:%d tex:%d mtl:%d", fps,
 						_data->fcounter->measurements(),
 						_data->fcounter->loopdt()*1000.0,
-						_data->fcounter->meandt()*1000.0 );
+						_data->fcounter->meandt()*1000.0,
+						st.shapes, st.programs, st.textures, st.materials );
+		if ( st.casters ) _data->message()->text() << " casters:" << st.casters;
 	}
 
 	//----- Snapshots -------------------------------------------
-	if ( _data->image_number>0 )
-	{	gl_snapshot ( _data->image );
-		_data->image_filename.setf ( "%s%04d.%s", _data->image_name.pt(), _data->image_number, _data->image_ext.pt() );
-		if ( !_data->image.save(_data->image_filename) ) { ui_message("Could not save snapshot!"); _data->image_number=-1; }
-		_data->image_number++;
+	if ( _data->capture && _data->capture->active() ) // back buffer is read before the UI is drawn
+	{	glReadBuffer ( GL_BACK );
+		_data->capture->capture ();
+		if ( _data->capture->errors()>0 ) { _data->capture->finish(); ui_message("Could not save snapshot!"); }
 	}
 
 	//----- Let WsWindow draw UI ---------------------------------
@@ -979,10 +1003,9 @@ static void eps_export ( SnNode* n )
 
 static void snapshot_onoff ( WsViewerData* d, WsViewer* v )
 {
-	if ( d->image_number>0 ) // turn off
-	{	int n = d->image_number-1;
-		v->snapshots ( false );
-		GsString s; s.setf ( "Snapshots turned off.\nImages saved: %d.", n );
+	if ( d->capture && d->capture->active() ) // turn off
+	{	v->snapshots ( false );
+		GsString s; s.setf ( "Snapshots turned off.\nImages saved: %d.", v->snapshots_taken()-d->capture->errors() );
 		ui_message ( s );
 	}
 	else // turn on
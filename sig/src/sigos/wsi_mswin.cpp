@@ -19,6 +19,7 @@
 # include <sigogl/gl_resources.h>
 # include <sigogl/ws_osinterface.h>
 # include <stdlib.h>
+# include <math.h>
 
 # include <sig/gs_string.h>
 # include <Shlobj.h>
@@ -354,6 +355,14 @@ int wsi_check ()
 	return AppNumVisWindows;
 }
 
+int wsi_wait ( double secs )
+{
+	// returns when input arrives or when the time is up, without spinning; the time
+	// is rounded up to whole milliseconds as a zero timeout would return at once:
+	if ( secs>0 ) MsgWaitForMultipleObjectsEx ( 0, 0, DWORD(ceil(secs*1000.0)), QS_ALLINPUT, MWMO_INPUTAVAILABLE );
+	return wsi_check ();
+}
+
 //this function is not needed:
 // checks if there are window events to be processed; will return 0 or 1
 //int wsi_peek ()
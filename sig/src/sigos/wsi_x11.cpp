@@ -299,6 +299,12 @@ int wsi_check ()
 	return AppNumVisWindows;
 }
 
+int wsi_wait ( double secs )
+{
+	if ( secs>0 ) glfwWaitEventsTimeout ( secs ); else glfwPollEvents();
+	return AppNumVisWindows;
+}
+
 void wsi_screen_resolution ( int& w, int& h )
 {
 	const GLFWvidmode* m = glfwGetVideoMode ( glfwGetPrimaryMonitor() );
@@ -6,7 +6,9 @@
 # include <sig/sn_primitive.h>
 # include <sig/sn_transform.h>
 # include <sig/sn_manipulator.h>
+# include <sig/gs_model_registry.h>
 # include <sigogl/ws_run.h>
+# include <sigogl/gl_resources.h>
 GsMat tran;
 float pi = 3.14f;
 float xcam=0;
@@ -31,6 +33,7 @@ MyViewer::MyViewer ( int x, int y, int w, int h, const char* l ) : WsViewer(x,y,
 {
 	_nbut=0;
 	_animating=false;
+	_frame=0;
 	build_ui ();
 	build_scene ();
 	cmd(WsViewer::VCmdAsIs);
@@ -91,8 +94,6 @@ void MyViewer::circle(){
 			float y = float(sin(t));
 			c_cir.translation(GsVec( x,  y, 0));
 		}
-		render();
-		ws_check();
 //	} while (fly);
 	
 
@@ -444,9 +445,6 @@ void MyViewer::spin() {
 
 	rot.roty(float(-pi / 10));
 	round->initial_mat(pos * rot);
-
-	render();
-	ws_check();
 }
 void MyViewer::spin2() {
 
@@ -456,9 +454,6 @@ void MyViewer::spin2() {
 
 	rot.roty(float(pi / 10));
 	round->initial_mat(pos * rot);
-
-	render();
-	ws_check();
 }
 void MyViewer::follow_view(int num) {//follows my robot
 		if (num==0) {
@@ -514,23 +509,16 @@ void MyViewer::static_view() {//static camera view
 	ws_check();
 }
 
-void MyViewer::add_shadow_model(SnShape* s, GsVec p)
+// returns the model of a file shared through the registry; the model is made flat once,
+// before being registered, and an empty model is returned if the file cannot be loaded:
+static GsModel* shared_flat_model ( const char* filename )
 {
-	SnManipulator* manip = new SnManipulator;
-	GsMat m;
-	//new SnTransform (maybe use this another day)
-	m.translation(p);
-	manip->initial_mat(m);
-
-	SnGroup* g = new SnGroup;
-	SnLines* l = new SnLines;
-	l->color(GsColor::orange);
-	g->add(s);
-	g->add(l);
-	manip->child(g);
-
-	sh->add(manip);
-	//make new group for shadow in add shadow function
+	GsModel* m = GsModelRegistry::shared().get(filename);
+	if (m) return m;
+	m = new GsModel;
+	if (!m->load(filename)) return m;
+	m->flat();
+	return GsModelRegistry::shared().add(m);
 }
 
 void MyViewer::build_scene ()
@@ -550,16 +538,9 @@ void MyViewer::build_scene ()
 	r->child(e);
 	rootg()->add(r);
 	
-	SnManipulator* rs = new SnManipulator;
-	rs->visible(false);
-	tran.translation(0, 0, 0);
-	rs->initial_mat(tran);
-	rs->child(sh);
-	rootg()->add(rs);
-	
-	GsMaterial shadowMaterial;//sets materials to black
-	shadowMaterial.init(GsColor::black, GsColor::black, GsColor::black, GsColor::black,0.0f);
-	
+	WsViewer::light().position.set(light[0], light[1], light[2]);//directional light casting the shadows
+	cmd(WsViewer::VCmdShadows);
+
 	GsMat scale;
 	scale.scaling(300.5f);
 
@@ -670,6 +651,7 @@ void MyViewer::build_scene ()
 	GsModel *show13 = new GsModel;
 	show13->load("..\\city\\ciity.obj");
 	SnModel	*z13 = new SnModel(show13);
+	z13->lod(new GsModelLod(show13)); // the city is large and mostly seen from far away
 	add_model(z13, GsVec(160, -18.5f, 0));
 	SnManipulator* manip13 = e->get<SnManipulator>(12); // access one of the manipulators
 	manip13->visible(false);
@@ -681,6 +663,7 @@ void MyViewer::build_scene ()
 	SnModel	*z14 = new SnModel(show14);
 	add_model(z14, GsVec(160, -18.5f, 0));
 	show14->flat();
+	z14->lod(new GsModelLod(show14)); // levels are built after flat() as they copy the model
 	SnManipulator* manip14 = e->get<SnManipulator>(13); // access one of the manipulators
 	manip14->visible(false);
 	street = manip14->mat();
@@ -691,6 +674,7 @@ void MyViewer::build_scene ()
 	SnModel	*z15 = new SnModel(show15);
 	add_model(z15, GsVec(160, -18.5f, 0));
 	show15->flat();
+	z15->lod(new GsModelLod(show15));
 	SnManipulator* manip15 = e->get<SnManipulator>(14); // access one of the manipulators
 	manip15->visible(false);
 	manip15->initial_mat(manip15->mat()*scale);
@@ -723,170 +707,175 @@ void MyViewer::build_scene ()
 	wing = manip18->mat();
 	wing = wing * heli.inverse();
 	
-	GsModel *show19 = new GsModel;
-	show19->load("..\\red_car\\race_car.obj");
+	// the three cars share one model, which is loaded once by the registry:
+	GsModel *show19 = shared_flat_model("..\\red_car\\race_car.obj");
 	SnModel	*z19 = new SnModel(show19);
 	add_model(z19, GsVec(0, -5, 150));
-	show19->flat();
 	SnManipulator* manip19 = e->get<SnManipulator>(18); // access one of the manipulators
 	manip19->visible(false);
 
-	GsModel *show20 = new GsModel;
-	show20->load("..\\red_car\\race_car.obj");
-	SnModel	*z20 = new SnModel(show19);
+	GsModel *show20 = shared_flat_model("..\\red_car\\race_car.obj");
+	SnModel	*z20 = new SnModel(show20);
 	add_model(z20, GsVec(40, -5, -15));
-	show20->flat();
 	SnManipulator* manip20 = e->get<SnManipulator>(19); // access one of the manipulators
 	manip20->visible(false);
 
-	GsModel *show21 = new GsModel;
-	show21->load("..\\red_car\\race_car.obj");
-	SnModel	*z21 = new SnModel(show19);
+	GsModel *show21 = shared_flat_model("..\\red_car\\race_car.obj");
+	SnModel	*z21 = new SnModel(show21);
 	add_model(z21, GsVec(50, -5, -40));
-	show21->flat();
 	SnManipulator* manip21 = e->get<SnManipulator>(20); // access one of the manipulators
 	manip21->visible(false);
 
+	// the cars also share the levels of detail of their model:
+	GsModelLod* carlod = new GsModelLod(show19);
+	z19->lod(carlod);
+	z20->lod(carlod);
+	z21->lod(carlod);
+
+	// decode all wood and city textures in parallel now instead of at the first frame:
+	GlResources::declare_textures(rootg());
+	GlResources::load_textures();
 }
 
-// Below is an example of how to control the main loop of an animation:
+// Below is an example of how to control an animation with a fixed-step clock:
 void MyViewer::run_animation ()
 {
+	if (_animating) return; // already running
 	_animating = true;
+	_frame = 0;
 	circle();
-	int ind = 0; // pick one child
+	ws_add_clock(1.0 / 30.0, animation_update, animation_draw, this); // 30 steps per second, independent of the rendering
+}
 
-	double frame_count = 0;
-	double frdt = 1.0 / 30.0; // delta time to reach given number of frames per second
-							  //double v = 4; // target velocity is 1 unit per second
-	double t = 0, lt = 0, t0 = gs_time();
-	do // run for a while:
-	{
-		while (t - lt<frdt) { ws_check(); t = gs_time() - t0; } // wait until it is time for next frame
-
-		lt = t;
-		 
-		if (frame_count >= 0 && frame_count <= 10) {
-			rotate(3, 1);
-			rotate(6, -1);
-			rotate(8, 1);
-			rotate(7, -1);
-			rotate(10, -1);
-			rotate(9, -1);
-			global(17, 1);
-			rotate(14, -1);
-			car_move(0);
-			spin();
-			spin2();
-			circle();
+void MyViewer::animation_update(void* udata)
+{
+	((MyViewer*)udata)->animation_step();
+}
 
-		}
-		if (frame_count > 10 && frame_count <= 20) {
-			rotate(3, 1);
-			rotate(6, -1);
-			rotate(8, 1);
-			rotate(7, -1);
-			rotate(10, -1);
-			rotate(9, -1);
-			global(17, 1);
-			rotate(14, -1);
-			car_move(0);
-			spin();
-			spin2();
-			circle();
+void MyViewer::animation_draw(float /*alpha*/, void* udata)
+{
+	((MyViewer*)udata)->render(); // the steps move the joints by fixed amounts, so there is nothing to interpolate
+}
 
-		}
-		if (frame_count > 20 && frame_count <= 30) {
-			rotate(3, -1);
-			rotate(6, 1);
-			rotate(8, -1);
-			rotate(7, 1);
-			rotate(10, 1);
-			rotate(9, 1);
-			global (17, 1);
-			rotate(14, -1);
-			car_move(0);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count > 30 && frame_count <= 40) {
-			rotate(3, -1);
-			rotate(6, 1);
-			rotate(8, -1);
-			rotate(7, 1);
-			rotate(10, 1);
-			rotate(9, 1);
-			global(17, 1);
-			rotate(14, -1);
-			car_move(0);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count > 40 && frame_count <= 50) {
-			rotate(3, -1);
-			rotate(6, 1);
-			rotate(8, -1);
-			rotate(7, 1);
-			rotate(10, 1);
-			rotate(9, 1);
-			global(17, -1);
-			rotate(14, -1);
-			car_move(1);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count > 50 && frame_count <= 60) {
-			rotate(3, -1);
-			rotate(6, 1);
-			rotate(8, -1);
-			rotate(7, 1);
-			rotate(10, 1);
-			rotate(9, 1);
-			global(17, -1);
-			rotate(14, -1);
-			car_move(1);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count > 60 && frame_count <= 70) {
-			rotate(3, 1);
-			rotate(6, -1);
-			rotate(8, 1);
-			rotate(7, -1);
-			rotate(10, -1);
-			rotate(9, -1);
-			global(17, -1);
-			rotate(14, -1);
-			car_move(1);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count > 70 && frame_count <= 80) {
-			rotate(3, 1);
-			rotate(6, -1);
-			rotate(8, 1);
-			rotate(7, -1);
-			rotate(10, -1);
-			rotate(9, -1);
-			global(17, -1);
-			rotate(14, -1);
-			car_move(1);
-			spin();
-			spin2();
-			circle();
-		}
-		if (frame_count == 81)
-			//_animating = false;
-			frame_count = 0;
-		frame_count++;
-		render(); // notify it needs redraw
-		ws_check(); // redraw now
-	} while (_animating);
+void MyViewer::animation_step()
+{
+	if (_frame >= 0 && _frame <= 10) {
+		rotate(3, 1);
+		rotate(6, -1);
+		rotate(8, 1);
+		rotate(7, -1);
+		rotate(10, -1);
+		rotate(9, -1);
+		global(17, 1);
+		rotate(14, -1);
+		car_move(0);
+		spin();
+		spin2();
+		circle();
+
+	}
+	if (_frame > 10 && _frame <= 20) {
+		rotate(3, 1);
+		rotate(6, -1);
+		rotate(8, 1);
+		rotate(7, -1);
+		rotate(10, -1);
+		rotate(9, -1);
+		global(17, 1);
+		rotate(14, -1);
+		car_move(0);
+		spin();
+		spin2();
+		circle();
+
+	}
+	if (_frame > 20 && _frame <= 30) {
+		rotate(3, -1);
+		rotate(6, 1);
+		rotate(8, -1);
+		rotate(7, 1);
+		rotate(10, 1);
+		rotate(9, 1);
+		global (17, 1);
+		rotate(14, -1);
+		car_move(0);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame > 30 && _frame <= 40) {
+		rotate(3, -1);
+		rotate(6, 1);
+		rotate(8, -1);
+		rotate(7, 1);
+		rotate(10, 1);
+		rotate(9, 1);
+		global(17, 1);
+		rotate(14, -1);
+		car_move(0);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame > 40 && _frame <= 50) {
+		rotate(3, -1);
+		rotate(6, 1);
+		rotate(8, -1);
+		rotate(7, 1);
+		rotate(10, 1);
+		rotate(9, 1);
+		global(17, -1);
+		rotate(14, -1);
+		car_move(1);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame > 50 && _frame <= 60) {
+		rotate(3, -1);
+		rotate(6, 1);
+		rotate(8, -1);
+		rotate(7, 1);
+		rotate(10, 1);
+		rotate(9, 1);
+		global(17, -1);
+		rotate(14, -1);
+		car_move(1);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame > 60 && _frame <= 70) {
+		rotate(3, 1);
+		rotate(6, -1);
+		rotate(8, 1);
+		rotate(7, -1);
+		rotate(10, -1);
+		rotate(9, -1);
+		global(17, -1);
+		rotate(14, -1);
+		car_move(1);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame > 70 && _frame <= 80) {
+		rotate(3, 1);
+		rotate(6, -1);
+		rotate(8, 1);
+		rotate(7, -1);
+		rotate(10, -1);
+		rotate(9, -1);
+		global(17, -1);
+		rotate(14, -1);
+		car_move(1);
+		spin();
+		spin2();
+		circle();
+	}
+	if (_frame == 81)
+		_frame = 0;
+	_frame++;
 }
 
 
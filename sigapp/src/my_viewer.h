@@ -12,10 +12,9 @@ class MyViewer : public WsViewer
 	enum MenuEv { EvNormals, EvAnimate, EvExit };
 	UiCheckButton* _nbut;
 	bool _animating;
+	int _frame; // animation step, from 0 to 81
 	float light[4] = { 0,1,1,0 };
 	float ground[4] = { 0,1,0,8 };
-	GsMat shadowMat;
-	GsMat update_shadowMat;
 	GsMat floor;
 	GsMat lhand,rhand;
 	GsMat lmid,rmid;
@@ -37,7 +36,6 @@ class MyViewer : public WsViewer
 
 
 	SnGroup* e = new SnGroup;//body group
-	SnGroup* sh = new SnGroup;// shadow group
 	float zinc = 0.0f;
 	float xinc = 0.0f;
 	float yinc = 0.0f;
@@ -57,7 +55,9 @@ class MyViewer : public WsViewer
 	void build_scene ();
 	void show_normals ( bool b );
 	void run_animation ();
-	void MyViewer::add_shadow_model(SnShape* s, GsVec p);
+	void animation_step ();
+	static void animation_update ( void* udata );
+	static void animation_draw ( float alpha, void* udata );
 	void MyViewer::camera_view(int num);
 	void MyViewer::static_view();
 	void MyViewer::moves(int num, int o);